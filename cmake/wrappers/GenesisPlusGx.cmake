@@ -34,10 +34,10 @@ list(FILTER CORE_SRC_FILES EXCLUDE REGEX ".*/cd_hw/libchdr/tests/.*")
 list(FILTER CORE_SRC_FILES EXCLUDE REGEX ".*/cd_hw/libchdr/deps/zstd-.*")
 list(FILTER CORE_SRC_FILES EXCLUDE REGEX ".*/cd_hw/libchdr/deps/zlib-.*")
 
+# fileio.c is replaced by load_archive() in src/CoreWrapper/GenesisPlusGXFileIO.cpp.
 set(PLATFORM_SRC_FILES
         "${PLATFORM_DIR}/config.c"
         "${PLATFORM_DIR}/error.c"
-        "${PLATFORM_DIR}/fileio.c"
         "${PLATFORM_DIR}/unzip.c"
 )
 
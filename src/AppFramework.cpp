@@ -1,15 +1,20 @@
 #include "AppFramework.h"
 
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <SDL_opengl.h>
 
 #include "EmulatorCoreManager.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_sdl2.h"
+#include "InputManager.h"
 #include "UI/ShortcutAndMenuUtils.h"
 #include "UI/UIManager.h"
 #include "Util/Config.h"
+#include "Util/FrameProfiler.h"
+#include "Util/TraceRecorder.h"
 
 #if DEBUG_BUILD
 bool ShowDemoWindow = false;
@@ -25,6 +30,24 @@ IMGUI_UTIL_CREATE_MENU_ITEM("File->|Settings@3", ImGuiMod_Ctrl | ImGuiMod_Alt |
     ImGui::OpenPopup(AppFramework::Get().GetSettingsWindowID());
 }
 
+IMGUI_UTIL_CREATE_MENU_ITEM("View@2->|Start/Stop Trace Capture", ImGuiMod_Ctrl | ImGuiKey_F12, "Record a timeline of the emulation and UI threads, open the file in ui.perfetto.dev.")
+{
+    TraceRecorder& Recorder = TraceRecorder::Get();
+
+    if (Recorder.IsCapturing())
+    {
+        Recorder.Stop();
+        std::cout << "Trace written to " << Recorder.GetPath().string() << '\n';
+        return;
+    }
+
+    const auto Timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::filesystem::path Path = std::filesystem::path(Config::Instance().GetPreferencePath()) / "Traces" / ("Trace-" + std::to_string(Timestamp) + ".json");
+
+    if (const std::error_code Error = Recorder.Start(Path))
+        std::cerr << "Unable to start trace capture " << Path.string() << ": " << Error.message() << '\n';
+}
+
 IMGUI_UTIL_CREATE_MENU_ITEM("File@0->|Exit", ImGuiMod_Alt | ImGuiKey_F4, "")
 {
     AppFramework::Get().RequestExitApp();
@@ -32,20 +55,25 @@ IMGUI_UTIL_CREATE_MENU_ITEM("File@0->|Exit", ImGuiMod_Alt | ImGuiKey_F4, "")
 
 AppFramework::AppFramework()
 {
+    TraceRecorder::SetThreadName("UI");
+
+    // The core comes before the windows: a resumed session is already loading while the library and the debug
+    // windows initialize.
     IsInitialized = Config::Instance().Load()
         && InitSDL()
         && InitImGui()
         && InitImGuiStyle()
-        && UIManager::Get().Initialize()
-        && EmulatorCoreManager::Get().Initialize();
+        && EmulatorCoreManager::Get().Initialize()
+        && UIManager::Get().Initialize();
 
     RequestExit = !IsInitialized;
 }
 
 AppFramework::~AppFramework()
 {
-    EmulatorCoreManager::Get().StopEmulation();
+    EmulatorCoreManager::Get().SuspendEmulation();
     UIManager::Get().Stop();
+    InputManager::Get().Shutdown();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
@@ -54,6 +82,9 @@ AppFramework::~AppFramework()
     SDL_GL_DeleteContext(OpenGLContext);
     SDL_DestroyWindow(Window);
     SDL_Quit();
+
+    // The last changes may still be waiting for the writer's quiet period.
+    Config::Instance().Flush();
 }
 
 
@@ -211,6 +242,7 @@ void AppFramework::ProcessInputsAndNewFrame()
     while (SDL_PollEvent(&Event))
     {
         ImGui_ImplSDL2_ProcessEvent(&Event);
+        InputManager::Get().ProcessEvent(Event);
 
         if (Event.type == SDL_QUIT)
             RequestExit = true;
@@ -232,26 +264,34 @@ void AppFramework::ProcessInputsAndNewFrame()
 
 void AppFramework::PostRender()
 {
-    ImGui::Render();
+    {
+        ScopedFrameStage RenderStage(FrameStage::ImGuiRender);
+        ImGui::Render();
 
-    const ImGuiIO& IO = ImGui::GetIO();
+        const ImGuiIO& IO = ImGui::GetIO();
 
-    glViewport(0, 0, static_cast<GLsizei>(IO.DisplaySize.x), static_cast<GLsizei>(IO.DisplaySize.y));
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+        glViewport(0, 0, static_cast<GLsizei>(IO.DisplaySize.x), static_cast<GLsizei>(IO.DisplaySize.y));
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+        if (IO.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+        {
+            SDL_Window* BackupCurrentWindow = SDL_GL_GetCurrentWindow();
+            SDL_GLContext BackupCurrentOpenGlContext = SDL_GL_GetCurrentContext();
+            ImGui::UpdatePlatformWindows();
+            ImGui::RenderPlatformWindowsDefault();
+            SDL_GL_MakeCurrent(BackupCurrentWindow, BackupCurrentOpenGlContext);
+        }
+    }
 
-    if (IO.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
     {
-        SDL_Window* BackupCurrentWindow = SDL_GL_GetCurrentWindow();
-        SDL_GLContext BackupCurrentOpenGlContext = SDL_GL_GetCurrentContext();
-        ImGui::UpdatePlatformWindows();
-        ImGui::RenderPlatformWindowsDefault();
-        SDL_GL_MakeCurrent(BackupCurrentWindow, BackupCurrentOpenGlContext);
+        ScopedFrameStage SwapStage(FrameStage::Swap);
+        SDL_GL_SwapWindow(Window);
     }
 
-    SDL_GL_SwapWindow(Window);
+    EmulatorCoreManager::Get().OnHostPresent();
 }
 
 void AppFramework::ShowSettingsWindow()
@@ -312,10 +352,31 @@ void AppFramework::ShowSettingsWindow()
 
         if (CurrentCategory < EmulatorCoreManager::Get().EmulatorCores.size())
         {
-            for (const auto& [Name, Type] : EmulatorCoreManager::Get().EmulatorCores[CurrentCategory]->GetSettingsTypes())
+            const IEmulatorCore& Emulator = *EmulatorCoreManager::Get().EmulatorCores[CurrentCategory];
+            Config& Settings = Config::Instance();
+
+            for (const auto& [Name, Type] : Emulator.GetSettingsTypes())
             {
-                std::string ConfigKey = "Core." + EmulatorCoreManager::Get().EmulatorCores[CurrentCategory]->Name() + "." + Name;
+                const ConfigKey Key = Emulator.GetSettingKey(Name);
+                SettingEditState& State = SettingEditStates[Key.GetIndex()];
+
+                // Parsed again only when the value changed elsewhere, the config is only written when edited.
+                if (const std::uint64_t Revision = Settings.GetRevision(Key); Revision != State.Revision)
+                {
+                    const std::string Value = Settings.GetValue(Key, "");
+                    State.Revision = Revision;
+                    State.Boolean = false;
+                    State.Integer = 0;
+                    State.Float = 0.0f;
+                    ParseConfigValue(Value, State.Boolean);
+                    ParseConfigValue(Value, State.Integer);
+                    ParseConfigValue(Value, State.Float);
+                    const std::size_t Size = std::min(Value.size(), State.Text.size() - 1);
+                    std::copy_n(Value.data(), Size, State.Text.data());
+                    State.Text[Size] = '\0';
+                }
 
+                ImGui::PushID(Name.c_str());
                 ImGui::Dummy(ImVec2(10.0f, 0.0f));
                 ImGui::TextUnformatted((Name + ":").c_str());
                 ImGui::SameLine();
@@ -323,67 +384,33 @@ void AppFramework::ShowSettingsWindow()
                 switch (Type)
                 {
                     case SettingType::Boolean:
-                    {
-                        bool Value = Config::Instance().Get(ConfigKey, "False") == "True";
-                        ImGui::Checkbox(("##" + Name).c_str(), &Value);
-                        Config::Instance()[ConfigKey] = Value ? "True" : "False";
+                        if (ImGui::Checkbox("##Value", &State.Boolean))
+                            Settings.SetValue(Key, FormatConfigValue(State.Boolean));
                         break;
-                    }
                     case SettingType::Integer:
-                    {
-                        int Value = std::stoi(Config::Instance().Get(ConfigKey, "0"));
-                        ImGui::InputInt(("##" + Name).c_str(), &Value);
-                        Config::Instance()[ConfigKey] = std::to_string(Value);
-                        break;
-                    }
-                    case SettingType::String:
-                    {
-                        std::string CurrentValue = Config::Instance().Get(ConfigKey, "");
-                        char Text[512] = "";
-                        std::copy_n(CurrentValue.c_str(), std::min(CurrentValue.size(), sizeof(Text) - 1), Text);
-                        Text[std::min(CurrentValue.size(), sizeof(Text) - 1)] = '\0';
-                        ImGui::InputText(("##" + Name).c_str(), Text, IM_ARRAYSIZE(Text));
-                        Config::Instance()[ConfigKey] = Text;
+                        if (ImGui::InputInt("##Value", &State.Integer))
+                            Settings.SetValue(Key, FormatConfigValue(State.Integer));
                         break;
-                    }
                     case SettingType::Float:
-                    {
-                        float Value = std::stof(Config::Instance().Get(ConfigKey, "0.0"));
-                        ImGui::InputFloat(("##" + Name).c_str(), &Value);
-                        Config::Instance()[ConfigKey] = std::to_string(Value);
+                        if (ImGui::InputFloat("##Value", &State.Float))
+                            Settings.SetValue(Key, FormatConfigValue(State.Float));
                         break;
-                    }
+                    case SettingType::String:
                     case SettingType::Directory:
-                    {
-                        std::string CurrentValue = Config::Instance().Get(ConfigKey, "");
-                        char Text[512] = "";
-                        std::copy_n(CurrentValue.c_str(), std::min(CurrentValue.size(), sizeof(Text) - 1), Text);
-                        Text[std::min(CurrentValue.size(), sizeof(Text) - 1)] = '\0';
-                        ImGui::InputText(("##" + Name).c_str(), Text, IM_ARRAYSIZE(Text));
-                        Config::Instance()[ConfigKey] = Text;
-                        break;
-                    }
                     case SettingType::File:
-                    {
-                        std::string CurrentValue = Config::Instance().Get(ConfigKey, "");
-                        char Text[512] = "";
-                        std::copy_n(CurrentValue.c_str(), std::min(CurrentValue.size(), sizeof(Text) - 1), Text);
-                        Text[std::min(CurrentValue.size(), sizeof(Text) - 1)] = '\0';
-                        ImGui::InputText(("##" + Name).c_str(), Text, IM_ARRAYSIZE(Text));
-                        Config::Instance()[ConfigKey] = Text;
+                        if (ImGui::InputText("##Value", State.Text.data(), State.Text.size()))
+                            Settings.SetValue(Key, State.Text.data());
                         break;
-                    }
                 }
+
+                ImGui::PopID();
             }
         }
         ImGui::EndChild();
 
         ImGui::Separator();
         if (ImGui::Button("Close"))
-        {
-            Config::Instance().Save();
             ImGui::CloseCurrentPopup();
-        }
 
         ImGui::EndPopup();
     }
@@ -399,9 +426,14 @@ void AppFramework::DoUpdateUIAndRender()
     if (RequestExit)
         return;
 
+    FrameProfiler::Get().BeginHostFrame();
     ProcessInputsAndNewFrame();
 
-    UIManager::Get().Render();
+    {
+        ScopedFrameStage BuildStage(FrameStage::BuildUI);
+        UIManager::Get().Render();
+    }
+
     ShowSettingsWindow();
 
 #if DEBUG_BUILD
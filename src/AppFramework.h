@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <unordered_map>
 #include <imgui.h>
 #include <SDL.h>
 
@@ -20,6 +23,16 @@ public:
     [[nodiscard]] ImGuiID GetSettingsWindowID() const { return SettingsWindowID; }
 
 private:
+    // Widget values of a core setting, refreshed when its revision changes.
+    struct SettingEditState
+    {
+        std::uint64_t Revision = UINT64_MAX;
+        bool Boolean = false;
+        std::int32_t Integer = 0;
+        float Float = 0.0f;
+        std::array<char, 512> Text = {};
+    };
+
     AppFramework();
 
     bool InitSDL();
@@ -37,4 +50,5 @@ private:
     SDL_GLContext OpenGLContext = nullptr;
     float MainScale = 1.0f;
     ImGuiID SettingsWindowID = 0;
+    std::unordered_map<std::uint32_t, SettingEditState> SettingEditStates; // By config key index.
 };
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "ChdHunkCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace
+{
+    std::uint64_t SteadyClockNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // The core opens one disc image at a time. Only the emulation thread replaces it, the lock is for readers of the
+    // statistics.
+    std::mutex ActiveCacheMutex;
+    std::unique_ptr<ChdHunkCache> ActiveCache;
+}
+
+ChdHunkCache::ChdHunkCache(chd_file* File, std::string Path, const chd_header& Header)
+    : File(File)
+    , Path(std::move(Path))
+    , HunkBytes(Header.hunkbytes)
+    , HunkCount(Header.totalhunks)
+    , CapacityHunks(std::max<std::size_t>(CapacityBytes / std::max<std::uint32_t>(Header.hunkbytes, 1), ReadAheadHunks * 2))
+{
+    for (std::uint32_t Worker = 0; Worker < WorkerCount; ++Worker)
+        Workers.emplace_back([this](std::stop_token StopToken) { WorkerMain(StopToken); });
+}
+
+ChdHunkCache::~ChdHunkCache()
+{
+    for (std::jthread& Worker : Workers)
+        Worker.request_stop();
+
+    Workers.clear();
+}
+
+chd_error ChdHunkCache::Read(std::uint32_t HunkIndex, void* Buffer)
+{
+    // Out of range, libchdr reports the error.
+    if (HunkIndex >= HunkCount)
+        return __real_chd_read(File, HunkIndex, Buffer);
+
+    std::unique_lock Lock(Mutex);
+    QueueReadAhead(HunkIndex);
+
+    if (const auto Found = Hunks.find(HunkIndex); Found != Hunks.end())
+    {
+        Hunk& Entry = Found->second;
+
+        if (Entry.IsReady)
+        {
+            ++Stats.Hits;
+            LruOrder.splice(LruOrder.begin(), LruOrder, Entry.LruPosition);
+            std::memcpy(Buffer, Entry.Data.data(), HunkBytes);
+            return CHDERR_NONE;
+        }
+
+        // Still queued behind other hunks: take it back rather than wait for a worker to get to it.
+        if (const auto Queued = std::ranges::find(PendingReadAheads, HunkIndex); Queued != PendingReadAheads.end())
+        {
+            PendingReadAheads.erase(Queued);
+            Hunks.erase(Found);
+        }
+        else
+        {
+            const std::uint64_t WaitStartNs = SteadyClockNs();
+
+            // A failed read ahead is dropped by the worker, the hunk is then decompressed below.
+            ReadySignal.wait(Lock, [this, HunkIndex]
+            {
+                const auto Entry = Hunks.find(HunkIndex);
+                return Entry == Hunks.end() || Entry->second.IsReady;
+            });
+
+            Stats.WaitNs += SteadyClockNs() - WaitStartNs;
+
+            if (const auto Ready = Hunks.find(HunkIndex); Ready != Hunks.end())
+            {
+                ++Stats.LateHits;
+                LruOrder.splice(LruOrder.begin(), LruOrder, Ready->second.LruPosition);
+                std::memcpy(Buffer, Ready->second.Data.data(), HunkBytes);
+                return CHDERR_NONE;
+            }
+        }
+    }
+
+    ++Stats.Misses;
+
+    // Inserted before unlocking so the workers never queue it, element references survive rehashing.
+    Hunk& Entry = Hunks[HunkIndex];
+    Entry.Data.resize(HunkBytes);
+
+    const std::uint64_t ReadStartNs = SteadyClockNs();
+    Lock.unlock();
+    const chd_error Error = __real_chd_read(File, HunkIndex, Entry.Data.data());
+    Lock.lock();
+    Stats.WaitNs += SteadyClockNs() - ReadStartNs;
+
+    if (Error != CHDERR_NONE)
+    {
+        Hunks.erase(HunkIndex);
+        return Error;
+    }
+
+    std::memcpy(Buffer, Entry.Data.data(), HunkBytes);
+    MarkReady(HunkIndex, Entry);
+    return CHDERR_NONE;
+}
+
+ChdCacheStats ChdHunkCache::GetStats() const
+{
+    std::scoped_lock Lock(Mutex);
+    return Stats;
+}
+
+void ChdHunkCache::Attach(chd_file* File, const char* Path)
+{
+    const chd_header* Header = chd_get_header(File);
+
+    if (Header == nullptr || Header->hunkbytes == 0)
+        return;
+
+    std::unique_ptr<ChdHunkCache> Cache = std::make_unique<ChdHunkCache>(File, Path, *Header);
+
+    std::scoped_lock Lock(ActiveCacheMutex);
+    std::swap(ActiveCache, Cache);
+}
+
+void ChdHunkCache::Detach(chd_file* File)
+{
+    std::unique_ptr<ChdHunkCache> Cache;
+
+    {
+        std::scoped_lock Lock(ActiveCacheMutex);
+
+        if (ActiveCache != nullptr && ActiveCache->GetFile() == File)
+            Cache = std::move(ActiveCache);
+    }
+
+    // Joins the workers, outside the lock so statistics readers do not wait for the hunks they are finishing.
+    Cache.reset();
+}
+
+ChdHunkCache* ChdHunkCache::Find(chd_file* File)
+{
+    // The emulation thread is the only writer of ActiveCache.
+    return ActiveCache != nullptr && ActiveCache->GetFile() == File ? ActiveCache.get() : nullptr;
+}
+
+std::optional<ChdCacheStats> ChdHunkCache::GetActiveStats()
+{
+    std::scoped_lock Lock(ActiveCacheMutex);
+
+    if (ActiveCache == nullptr)
+        return std::nullopt;
+
+    return ActiveCache->GetStats();
+}
+
+void ChdHunkCache::QueueReadAhead(std::uint32_t HunkIndex)
+{
+    const std::uint32_t WindowEnd = static_cast<std::uint32_t>(std::min<std::uint64_t>(static_cast<std::uint64_t>(HunkIndex) + ReadAheadHunks, HunkCount - 1));
+
+    // After a seek, hunks queued for the previous position are not worth decompressing any more.
+    std::erase_if(PendingReadAheads, [this, HunkIndex, WindowEnd](std::uint32_t Queued)
+    {
+        const bool IsStale = Queued <= HunkIndex || Queued > WindowEnd;
+
+        if (IsStale)
+            Hunks.erase(Queued);
+
+        return IsStale;
+    });
+
+    for (std::uint32_t Next = HunkIndex + 1; Next <= WindowEnd && Next > HunkIndex; ++Next)
+    {
+        if (Hunks.contains(Next))
+            continue;
+
+        Hunks[Next].Data.resize(HunkBytes);
+        PendingReadAheads.push_back(Next);
+        WorkSignal.notify_one();
+    }
+}
+
+void ChdHunkCache::MarkReady(std::uint32_t HunkIndex, Hunk& Entry)
+{
+    Entry.IsReady = true;
+    LruOrder.push_front(HunkIndex);
+    Entry.LruPosition = LruOrder.begin();
+
+    // Hunks being decompressed are not in the LRU list, so they are never evicted.
+    while (Hunks.size() > CapacityHunks && LruOrder.size() > 1)
+    {
+        Hunks.erase(LruOrder.back());
+        LruOrder.pop_back();
+        ++Stats.Evictions;
+    }
+}
+
+void ChdHunkCache::WorkerMain(std::stop_token StopToken)
+{
+    chd_file* WorkerFile = nullptr;
+
+    // Without its own handle the worker stays idle, queued hunks are then taken back by the reader.
+    if (__real_chd_open(Path.c_str(), CHD_OPEN_READ, nullptr, &WorkerFile) != CHDERR_NONE)
+        return;
+
+    std::unique_lock Lock(Mutex);
+
+    while (WorkSignal.wait(Lock, StopToken, [this] { return !PendingReadAheads.empty(); }))
+    {
+        const std::uint32_t HunkIndex = PendingReadAheads.front();
+        PendingReadAheads.pop_front();
+
+        // Queued entries are only erased along with their queue slot, so this one stays until it is marked ready.
+        Hunk& Entry = Hunks.at(HunkIndex);
+
+        Lock.unlock();
+        const chd_error Error = __real_chd_read(WorkerFile, HunkIndex, Entry.Data.data());
+        Lock.lock();
+
+        if (Error == CHDERR_NONE)
+        {
+            ++Stats.ReadAheadHunks;
+            MarkReady(HunkIndex, Entry);
+        }
+        else
+        {
+            Hunks.erase(HunkIndex);
+        }
+
+        ReadySignal.notify_all();
+    }
+
+    Lock.unlock();
+    __real_chd_close(WorkerFile);
+}
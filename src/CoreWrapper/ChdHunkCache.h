@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "libchdr/chd.h"
+
+// The original libchdr functions, under the names the linker gives them when they are wrapped (see CMakeLists.txt).
+extern "C"
+{
+    chd_error __real_chd_open(const char* filename, int mode, chd_file* parent, chd_file** chd);
+    chd_error __real_chd_read(chd_file* chd, UINT32 hunknum, void* buffer);
+    void __real_chd_close(chd_file* chd);
+}
+
+struct ChdCacheStats
+{
+    std::uint64_t Hits = 0;           // Hunk already decompressed.
+    std::uint64_t LateHits = 0;       // Hunk being read ahead, the reader waited for the worker to finish it.
+    std::uint64_t Misses = 0;         // Hunk decompressed by the reader itself.
+    std::uint64_t ReadAheadHunks = 0; // Hunks decompressed by the workers.
+    std::uint64_t Evictions = 0;
+    std::uint64_t WaitNs = 0;         // Time readers spent on late hits and misses.
+};
+
+// Decompressed hunk cache between the core's CD drive and libchdr, for the CHD image the core has open.
+// Every read queues the hunks following it to worker threads, so sequential streams (FMV, CD-DA) find their hunks
+// ready and the emulation thread only decompresses after a seek. A chd_file is not thread-safe: each worker reads
+// through its own handle on the image, the core's handle is only used by the reader. Least recently used hunks are
+// evicted beyond CapacityBytes.
+class ChdHunkCache
+{
+public:
+    static constexpr std::size_t CapacityBytes = 32 * 1024 * 1024;
+    static constexpr std::uint32_t ReadAheadHunks = 8;
+    static constexpr std::uint32_t WorkerCount = 2;
+
+    ChdHunkCache(chd_file* File, std::string Path, const chd_header& Header);
+    ~ChdHunkCache();
+
+    ChdHunkCache(const ChdHunkCache&) = delete;
+    ChdHunkCache& operator=(const ChdHunkCache&) = delete;
+
+    [[nodiscard]] chd_file* GetFile() const { return File; }
+
+    // Same contract as chd_read(), called from one thread at a time (the emulation thread).
+    chd_error Read(std::uint32_t HunkIndex, void* Buffer);
+
+    [[nodiscard]] ChdCacheStats GetStats() const;
+
+    // The image opened by the core, through the wrapped chd_open() and chd_close().
+    static void Attach(chd_file* File, const char* Path);
+    static void Detach(chd_file* File);
+    [[nodiscard]] static ChdHunkCache* Find(chd_file* File);
+
+    // Any thread. Counters of the image the core has open, none when it has no CHD image open.
+    [[nodiscard]] static std::optional<ChdCacheStats> GetActiveStats();
+
+private:
+    struct Hunk
+    {
+        std::vector<std::byte> Data;
+        bool IsReady = false;
+        std::list<std::uint32_t>::iterator LruPosition; // Only valid once ready.
+    };
+
+    void QueueReadAhead(std::uint32_t HunkIndex);
+    void MarkReady(std::uint32_t HunkIndex, Hunk& Entry);
+    void WorkerMain(std::stop_token StopToken);
+
+    chd_file* File;
+    std::string Path;
+    std::uint32_t HunkBytes;
+    std::uint32_t HunkCount;
+    std::size_t CapacityHunks;
+
+    mutable std::mutex Mutex;
+    std::condition_variable_any WorkSignal;
+    std::condition_variable_any ReadySignal;
+    std::unordered_map<std::uint32_t, Hunk> Hunks;
+    std::list<std::uint32_t> LruOrder; // Ready hunks, most recently read first.
+    std::deque<std::uint32_t> PendingReadAheads;
+    ChdCacheStats Stats;
+
+    // Last, so the workers are stopped before the rest is destroyed.
+    std::vector<std::jthread> Workers;
+};
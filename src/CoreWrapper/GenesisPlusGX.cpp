@@ -1,9 +1,11 @@
 #include "GenesisPlusGX.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 
-#include "SDL.h"
-#include "Util/Config.h"
+#include "CoreWrapper/GenesisPlusGXFileIO.h"
 
 extern "C"
 {
@@ -12,214 +14,199 @@ extern "C"
     #include "md_ntsc.h"
 }
 
-int sdl_input_update()
+namespace
 {
-    int joynum = 0;
-    const std::uint8_t *keystate = SDL_GetKeyboardState(nullptr);
-    /* reset input */
-    input.pad[joynum] = 0;
+    // Samples per emulated second, audio_init() is given no frame rate so it follows the emulated refresh rate.
+    constexpr std::uint32_t CoreAudioSampleRate = 48000;
+
+    // Instance whose media lives in the core globals (bitmap.data points into its frame buffer).
+    std::atomic<const GenesisPlusGX*> GlobalStateOwner = nullptr;
 
-    switch (input.dev[joynum])
+    // Core pad bits, indexed by ControllerInput. Master System buttons 1 and 2 are B and C.
+    constexpr std::array<std::uint16_t, ControllerInputCount> ControllerInputMasks =
     {
-        case DEVICE_LIGHTGUN:
-        {
-            /* get mouse coordinates (absolute values) */
-            int x,y;
-            int state = SDL_GetMouseState(&x,&y);
+        INPUT_UP, INPUT_DOWN, INPUT_LEFT, INPUT_RIGHT, INPUT_A, INPUT_B, INPUT_C, INPUT_X, INPUT_Y, INPUT_Z, INPUT_START, INPUT_MODE,
+    };
 
-            /* X axis */
-            //input.analog[joynum][0] =  x - (sdl_video.surf_screen->w-bitmap.viewport.w)/2;
+    bool IsPressed(std::span<const float> Values, ControllerInput Input)
+    {
+        return static_cast<std::size_t>(Input) < Values.size() && Values[static_cast<std::size_t>(Input)] >= 0.5f;
+    }
 
-            /* Y axis */
-            //input.analog[joynum][1] =  y - (sdl_video.surf_screen->h-bitmap.viewport.h)/2;
+    bool IsPressed(const PointerInput& Pointer, PointerButton Button)
+    {
+        return (Pointer.Buttons & static_cast<std::uint32_t>(Button)) != 0;
+    }
 
-            /* TRIGGER, B, C (Menacer only), START (Menacer & Justifier only) */
-            if(state & SDL_BUTTON_LMASK) input.pad[joynum] |= INPUT_A;
-            if(state & SDL_BUTTON_RMASK) input.pad[joynum] |= INPUT_B;
-            if(state & SDL_BUTTON_MMASK) input.pad[joynum] |= INPUT_C;
-            if(keystate[SDL_SCANCODE_F])  input.pad[joynum] |= INPUT_START;
-            break;
-        }
+    // Pad bits of a standard controller.
+    std::uint16_t GamepadBits(std::span<const float> Values)
+    {
+        std::uint16_t Pad = 0;
 
-        case DEVICE_PADDLE:
+        for (std::size_t Input = 0; Input < Values.size(); ++Input)
         {
-            /* get mouse (absolute values) */
-            int x;
-            int state = SDL_GetMouseState(&x, NULL);
+            if (Values[Input] >= 0.5f)
+                Pad |= ControllerInputMasks[Input];
+        }
 
-            /* Range is [0;256], 128 being middle position */
-            //input.analog[joynum][0] = x * 256 /sdl_video.surf_screen->w;
+        // A real pad cannot press opposite directions together, some games misbehave when they are.
+        if (Pad & INPUT_UP)
+            Pad &= ~INPUT_DOWN;
+        if (Pad & INPUT_LEFT)
+            Pad &= ~INPUT_RIGHT;
 
-            /* Button I -> 0 0 0 0 0 0 0 I*/
-            if(state & SDL_BUTTON_LMASK) input.pad[joynum] |= INPUT_B;
+        return Pad;
+    }
 
-            break;
-        }
+    std::int32_t ClampAnalog(std::int32_t Value)
+    {
+        return std::clamp(Value, 0, 0xFF);
+    }
 
-        case DEVICE_SPORTSPAD:
+    // The Pico pen colour changes once per click of the middle button.
+    std::uint32_t PreviousPicoButtons = 0;
+}
+
+int sdl_input_update()
+{
+    // Called by the core at the start of each frame, the owner is the instance emulating it. Players are numbered in
+    // the order of the connected devices: without a multitap, port B is device 4. Devices other than pads take their
+    // buttons from the player's controller inputs (laid out as the keyboard keys they used to read) and the mouse
+    // from the player's pointer input.
+    const GenesisPlusGX* Owner = GlobalStateOwner.load(std::memory_order_relaxed);
+    int Player = 0;
+
+    for (int Device = 0; Device < MAX_INPUTS; ++Device)
+    {
+        input.pad[Device] = 0;
+
+        if (Owner == nullptr || input.dev[Device] == NO_DEVICE || Player >= MaxControllerPorts)
+            continue;
+
+        const std::span<const float> Values = Owner->GetControllerInputValues(Player);
+        const PointerInput& Pointer = Owner->GetPointerInput(Player);
+        ++Player;
+
+        switch (input.dev[Device])
         {
-            /* get mouse (relative values) */
-            int x,y;
-            int state = SDL_GetRelativeMouseState(&x,&y);
+        case DEVICE_LIGHTGUN:
+            // TRIGGER, B, C (Menacer only), START (Menacer & Justifier only)
+            if (IsPressed(Pointer, PointerButton::Left)) input.pad[Device] |= INPUT_A;
+            if (IsPressed(Pointer, PointerButton::Right)) input.pad[Device] |= INPUT_B;
+            if (IsPressed(Pointer, PointerButton::Middle)) input.pad[Device] |= INPUT_C;
+            if (IsPressed(Values, ControllerInput::Start)) input.pad[Device] |= INPUT_START;
+            break;
 
-            /* Range is [0;256] */
-            input.analog[joynum][0] = (unsigned char)(-x & 0xFF);
-            input.analog[joynum][1] = (unsigned char)(-y & 0xFF);
+        case DEVICE_PADDLE:
+            if (IsPressed(Pointer, PointerButton::Left)) input.pad[Device] |= INPUT_B;
+            break;
 
-            /* Buttons I & II -> 0 0 0 0 0 0 II I*/
-            if(state & SDL_BUTTON_LMASK) input.pad[joynum] |= INPUT_B;
-            if(state & SDL_BUTTON_RMASK) input.pad[joynum] |= INPUT_C;
+        case DEVICE_SPORTSPAD:
+            // Range is [0;256]
+            input.analog[Device][0] = static_cast<unsigned char>(-static_cast<int>(Pointer.DeltaX) & 0xFF);
+            input.analog[Device][1] = static_cast<unsigned char>(-static_cast<int>(Pointer.DeltaY) & 0xFF);
 
+            if (IsPressed(Pointer, PointerButton::Left)) input.pad[Device] |= INPUT_B;
+            if (IsPressed(Pointer, PointerButton::Right)) input.pad[Device] |= INPUT_C;
             break;
-        }
 
         case DEVICE_MOUSE:
-        {
-            /* get mouse (relative values) */
-            int x,y;
-            int state = SDL_GetRelativeMouseState(&x,&y);
+            // Sega Mouse range is [-256;+256], vertical movement is upside down.
+            input.analog[Device][0] = static_cast<int>(Pointer.DeltaX) * 2;
+            input.analog[Device][1] = static_cast<int>(Pointer.DeltaY) * 2;
 
-            /* Sega Mouse range is [-256;+256] */
-            input.analog[joynum][0] = x * 2;
-            input.analog[joynum][1] = y * 2;
-
-            /* Vertical movement is upsidedown */
             if (!config.invert_mouse)
-            input.analog[joynum][1] = 0 - input.analog[joynum][1];
-
-            /* Start,Left,Right,Middle buttons -> 0 0 0 0 START MIDDLE RIGHT LEFT */
-            if(state & SDL_BUTTON_LMASK) input.pad[joynum] |= INPUT_B;
-            if(state & SDL_BUTTON_RMASK) input.pad[joynum] |= INPUT_C;
-            if(state & SDL_BUTTON_MMASK) input.pad[joynum] |= INPUT_A;
-            if(keystate[SDL_SCANCODE_F])  input.pad[joynum] |= INPUT_START;
+                input.analog[Device][1] = -input.analog[Device][1];
 
+            if (IsPressed(Pointer, PointerButton::Left)) input.pad[Device] |= INPUT_B;
+            if (IsPressed(Pointer, PointerButton::Right)) input.pad[Device] |= INPUT_C;
+            if (IsPressed(Pointer, PointerButton::Middle)) input.pad[Device] |= INPUT_A;
+            if (IsPressed(Values, ControllerInput::Start)) input.pad[Device] |= INPUT_START;
             break;
-        }
 
         case DEVICE_XE_1AP:
         {
-            /* A,B,C,D,Select,START,E1,E2 buttons -> E1(?) E2(?) START SELECT(?) A B C D */
-            if(keystate[SDL_SCANCODE_A])  input.pad[joynum] |= INPUT_START;
-            if(keystate[SDL_SCANCODE_S])  input.pad[joynum] |= INPUT_A;
-            if(keystate[SDL_SCANCODE_D])  input.pad[joynum] |= INPUT_C;
-            if(keystate[SDL_SCANCODE_F])  input.pad[joynum] |= INPUT_Y;
-            if(keystate[SDL_SCANCODE_Z])  input.pad[joynum] |= INPUT_B;
-            if(keystate[SDL_SCANCODE_X])  input.pad[joynum] |= INPUT_X;
-            if(keystate[SDL_SCANCODE_C])  input.pad[joynum] |= INPUT_MODE;
-            if(keystate[SDL_SCANCODE_V])  input.pad[joynum] |= INPUT_Z;
-
-            /* Left Analog Stick (bidirectional) */
-            if(keystate[SDL_SCANCODE_UP])     input.analog[joynum][1]-=2;
-            else if(keystate[SDL_SCANCODE_DOWN])   input.analog[joynum][1]+=2;
-            else input.analog[joynum][1] = 128;
-            if(keystate[SDL_SCANCODE_LEFT])   input.analog[joynum][0]-=2;
-            else if(keystate[SDL_SCANCODE_RIGHT])  input.analog[joynum][0]+=2;
-            else input.analog[joynum][0] = 128;
-
-            /* Right Analog Stick (unidirectional) */
-            if(keystate[SDL_SCANCODE_KP_8])    input.analog[joynum+1][0]-=2;
-            else if(keystate[SDL_SCANCODE_KP_2])   input.analog[joynum+1][0]+=2;
-            else if(keystate[SDL_SCANCODE_KP_4])   input.analog[joynum+1][0]-=2;
-            else if(keystate[SDL_SCANCODE_KP_6])  input.analog[joynum+1][0]+=2;
-            else input.analog[joynum+1][0] = 128;
-
-            /* Limiters */
-            if (input.analog[joynum][0] > 0xFF) input.analog[joynum][0] = 0xFF;
-            else if (input.analog[joynum][0] < 0) input.analog[joynum][0] = 0;
-            if (input.analog[joynum][1] > 0xFF) input.analog[joynum][1] = 0xFF;
-            else if (input.analog[joynum][1] < 0) input.analog[joynum][1] = 0;
-            if (input.analog[joynum+1][0] > 0xFF) input.analog[joynum+1][0] = 0xFF;
-            else if (input.analog[joynum+1][0] < 0) input.analog[joynum+1][0] = 0;
-            if (input.analog[joynum+1][1] > 0xFF) input.analog[joynum+1][1] = 0xFF;
-            else if (input.analog[joynum+1][1] < 0) input.analog[joynum+1][1] = 0;
-
+            // A,B,C,D,Select,START,E1,E2 buttons -> E1(?) E2(?) START SELECT(?) A B C D
+            if (IsPressed(Values, ControllerInput::A)) input.pad[Device] |= INPUT_START;
+            if (IsPressed(Values, ControllerInput::B)) input.pad[Device] |= INPUT_A;
+            if (IsPressed(Values, ControllerInput::C)) input.pad[Device] |= INPUT_C;
+            if (IsPressed(Values, ControllerInput::Start)) input.pad[Device] |= INPUT_Y;
+            if (IsPressed(Values, ControllerInput::X)) input.pad[Device] |= INPUT_B;
+            if (IsPressed(Values, ControllerInput::Y)) input.pad[Device] |= INPUT_X;
+            if (IsPressed(Values, ControllerInput::Z)) input.pad[Device] |= INPUT_MODE;
+            if (IsPressed(Values, ControllerInput::Mode)) input.pad[Device] |= INPUT_Z;
+
+            // Left analog stick (bidirectional), driven by the directions
+            if (IsPressed(Values, ControllerInput::Up)) input.analog[Device][1] = ClampAnalog(input.analog[Device][1] - 2);
+            else if (IsPressed(Values, ControllerInput::Down)) input.analog[Device][1] = ClampAnalog(input.analog[Device][1] + 2);
+            else input.analog[Device][1] = 128;
+
+            if (IsPressed(Values, ControllerInput::Left)) input.analog[Device][0] = ClampAnalog(input.analog[Device][0] - 2);
+            else if (IsPressed(Values, ControllerInput::Right)) input.analog[Device][0] = ClampAnalog(input.analog[Device][0] + 2);
+            else input.analog[Device][0] = 128;
+
+            // Right analog stick (unidirectional), no controller input drives it
+            if (Device + 1 < MAX_INPUTS)
+                input.analog[Device + 1][0] = 128;
             break;
         }
 
         case DEVICE_PICO:
-        {
-            /* get mouse (absolute values) */
-            int x,y;
-            int state = SDL_GetMouseState(&x,&y);
-
-            /* Calculate X Y axis values */
-            //input.analog[0][0] = 0x3c  + (x * (0x17c-0x03c+1)) / sdl_video.surf_screen->w;
-            //input.analog[0][1] = 0x1fc + (y * (0x2f7-0x1fc+1)) / sdl_video.surf_screen->h;
-
-            /* Map mouse buttons to player #1 inputs */
-            if(state & SDL_BUTTON_MMASK) pico_current = (pico_current + 1) & 7;
-            if(state & SDL_BUTTON_RMASK) input.pad[0] |= INPUT_PICO_RED;
-            if(state & SDL_BUTTON_LMASK) input.pad[0] |= INPUT_PICO_PEN;
-
+            // Mouse buttons go to player #1
+            if (IsPressed(Pointer, PointerButton::Middle) && (PreviousPicoButtons & static_cast<std::uint32_t>(PointerButton::Middle)) == 0)
+                pico_current = (pico_current + 1) & 7;
+            if (IsPressed(Pointer, PointerButton::Right)) input.pad[0] |= INPUT_PICO_RED;
+            if (IsPressed(Pointer, PointerButton::Left)) input.pad[0] |= INPUT_PICO_PEN;
+            PreviousPicoButtons = Pointer.Buttons;
             break;
-        }
 
         case DEVICE_TEREBI:
-        {
-            /* get mouse (absolute values) */
-            int x,y;
-            int state = SDL_GetMouseState(&x,&y);
-
-            /* Calculate X Y axis values */
-            //input.analog[0][0] = (x * 250) / sdl_video.surf_screen->w;
-            //input.analog[0][1] = (y * 250) / sdl_video.surf_screen->h;
-
-            /* Map mouse buttons to player #1 inputs */
-            if(state & SDL_BUTTON_RMASK) input.pad[0] |= INPUT_B;
-
+            if (IsPressed(Pointer, PointerButton::Right)) input.pad[0] |= INPUT_B;
             break;
-        }
 
         case DEVICE_GRAPHIC_BOARD:
-        {
-            /* get mouse (absolute values) */
-            int x,y;
-            int state = SDL_GetMouseState(&x,&y);
-
-            /* Calculate X Y axis values */
-            //input.analog[0][0] = (x * 255) / sdl_video.surf_screen->w;
-            //input.analog[0][1] = (y * 255) / sdl_video.surf_screen->h;
-
-            /* Map mouse buttons to player #1 inputs */
-            if(state & SDL_BUTTON_LMASK) input.pad[0] |= INPUT_GRAPHIC_PEN;
-            if(state & SDL_BUTTON_RMASK) input.pad[0] |= INPUT_GRAPHIC_MENU;
-            if(state & SDL_BUTTON_MMASK) input.pad[0] |= INPUT_GRAPHIC_DO;
-
+            if (IsPressed(Pointer, PointerButton::Left)) input.pad[0] |= INPUT_GRAPHIC_PEN;
+            if (IsPressed(Pointer, PointerButton::Right)) input.pad[0] |= INPUT_GRAPHIC_MENU;
+            if (IsPressed(Pointer, PointerButton::Middle)) input.pad[0] |= INPUT_GRAPHIC_DO;
             break;
-        }
 
         case DEVICE_ACTIVATOR:
-        {
-            if(keystate[SDL_SCANCODE_G])  input.pad[joynum] |= INPUT_ACTIVATOR_7L;
-            if(keystate[SDL_SCANCODE_H])  input.pad[joynum] |= INPUT_ACTIVATOR_7U;
-            if(keystate[SDL_SCANCODE_J])  input.pad[joynum] |= INPUT_ACTIVATOR_8L;
-            if(keystate[SDL_SCANCODE_K])  input.pad[joynum] |= INPUT_ACTIVATOR_8U;
-        }
+            // The extra sensors of the pad's top half have no controller input, the rest are the pad buttons.
+            input.pad[Device] |= GamepadBits(Values);
+            break;
 
         default:
-        {
-            if(keystate[SDL_SCANCODE_A])  input.pad[joynum] |= INPUT_A;
-            if(keystate[SDL_SCANCODE_S])  input.pad[joynum] |= INPUT_B;
-            if(keystate[SDL_SCANCODE_D])  input.pad[joynum] |= INPUT_C;
-            if(keystate[SDL_SCANCODE_F])  input.pad[joynum] |= INPUT_START;
-            if(keystate[SDL_SCANCODE_Z])  input.pad[joynum] |= INPUT_X;
-            if(keystate[SDL_SCANCODE_X])  input.pad[joynum] |= INPUT_Y;
-            if(keystate[SDL_SCANCODE_C])  input.pad[joynum] |= INPUT_Z;
-            if(keystate[SDL_SCANCODE_V])  input.pad[joynum] |= INPUT_MODE;
-
-            if(keystate[SDL_SCANCODE_UP]) input.pad[joynum] |= INPUT_UP;
-            else
-            if(keystate[SDL_SCANCODE_DOWN]) input.pad[joynum] |= INPUT_DOWN;
-            if(keystate[SDL_SCANCODE_LEFT]) input.pad[joynum] |= INPUT_LEFT;
-            else
-            if(keystate[SDL_SCANCODE_RIGHT]) input.pad[joynum] |= INPUT_RIGHT;
-
+            input.pad[Device] = GamepadBits(Values);
             break;
         }
     }
+
     return 1;
 }
 
+GenesisPlusGX::~GenesisPlusGX()
+{
+    // Shutdown() is a no-op unless this instance still owns the globals.
+    Shutdown();
+}
+
+bool GenesisPlusGX::AcquireGlobalState()
+{
+    const GenesisPlusGX* Owner = nullptr;
+    return GlobalStateOwner.compare_exchange_strong(Owner, this) || Owner == this;
+}
+
+void GenesisPlusGX::ReleaseGlobalState()
+{
+    const GenesisPlusGX* Owner = this;
+    GlobalStateOwner.compare_exchange_strong(Owner, nullptr);
+}
+
+bool GenesisPlusGX::OwnsGlobalState() const
+{
+    return GlobalStateOwner.load(std::memory_order_acquire) == this;
+}
+
 const std::string& GenesisPlusGX::Name() const
 {
     static std::string Name = "Genesis Plus GX";
@@ -228,6 +215,10 @@ const std::string& GenesisPlusGX::Name() const
 
 void GenesisPlusGX::Initialize()
 {
+    // Another instance owns the globals: this one stays inert, InsertMediaSource() then fails.
+    if (!AcquireGlobalState())
+        return;
+
     // set default config
     error_init();
     set_config_defaults();
@@ -241,22 +232,30 @@ void GenesisPlusGX::Initialize()
 
 void GenesisPlusGX::Shutdown()
 {
+    if (!OwnsGlobalState())
+        return;
+
     audio_shutdown();
     error_shutdown();
+    ReleaseGlobalState();
 }
 
 void GenesisPlusGX::Reset(bool Hard)
 {
-    system_reset();
+    if (OwnsGlobalState())
+        system_reset();
 }
 
 std::string GenesisPlusGX::GetMediaFilter(int MediaSource)
 {
-    return "Genesis Plus GX (*.md *.chd){.md,.chd}";
+    return "Genesis Plus GX (*.md *.chd *.zip){.md,.chd,.zip}";
 }
 
 std::error_code GenesisPlusGX::InsertMediaSource(std::string_view Path, int MediaSource)
 {
+    if (!OwnsGlobalState())
+        return std::make_error_code(std::errc::device_or_resource_busy);
+
     memset(&bitmap, 0, sizeof(t_bitmap));
     bitmap.width = 720;
     bitmap.height = 576;
@@ -266,21 +265,28 @@ std::error_code GenesisPlusGX::InsertMediaSource(std::string_view Path, int Medi
     bitmap.data = reinterpret_cast<uint8*>(m_FrameBuffer.data());
     bitmap.viewport.changed = 3;
 
-    const std::filesystem::path CurrentPath = std::filesystem::current_path();
-    const std::string BiosFolderKey = "Core." + Name() + ".Bios Folder";
-    const std::string BiosFolder = Config::Instance().Get(BiosFolderKey, CurrentPath.string());
+    // Without a valid BIOS folder, the BIOS files are looked up in the working directory.
+    std::filesystem::path BiosFolder = GetSettingValue("Bios Folder");
+
+    if (std::error_code Error; !std::filesystem::is_directory(BiosFolder, Error))
+        BiosFolder.clear();
+
+    // Set before load_rom(), which may still switch to the device a game requires (e.g. a light gun).
+    ApplyControllerPorts();
 
-    if (std::filesystem::exists(BiosFolder) && std::filesystem::is_directory(BiosFolder))
-        std::filesystem::current_path(BiosFolder);
+    // load_rom() wants a null-terminated path it may modify.
+    std::string MediaPath(Path);
+    MediaLoadScope LoadScope(MediaPath, BiosFolder, MediaLoadFunc);
 
-    if(!load_rom(const_cast<char*>(Path.data())))
+    if (!load_rom(MediaPath.data()))
     {
+        if (LoadScope.IsCanceled())
+            return std::make_error_code(std::errc::operation_canceled);
+
         return std::make_error_code(std::errc::invalid_argument);
     }
 
-    std::filesystem::current_path(CurrentPath);
-
-    audio_init(48000, 0);
+    audio_init(CoreAudioSampleRate, 0);
     system_init();
     system_reset();
 
@@ -291,57 +297,143 @@ void GenesisPlusGX::RemoveMediaSource(int MediaSource)
 {
 }
 
-void GenesisPlusGX::PlugController(int Port, int ControllerType)
+void GenesisPlusGX::PlugController(int Port, int Type)
 {
+    if (Port < 0 || Port >= static_cast<int>(PortControllers.size()) || Type < 0 || Type >= static_cast<int>(ControllerType::Count))
+        return;
+
+    PortControllers[Port] = static_cast<ControllerType>(Type);
+    ApplyControllerPorts();
 }
 
 void GenesisPlusGX::UnplugController(int Port)
 {
+    if (Port < 0 || Port >= static_cast<int>(PortControllers.size()))
+        return;
+
+    PortControllers[Port].reset();
+    ApplyControllerPorts();
+}
+
+void GenesisPlusGX::ApplyControllerPorts()
+{
+    // The ports are kept in PortControllers until this instance owns the globals, InsertMediaSource() applies them.
+    if (!OwnsGlobalState())
+        return;
+
+    for (std::size_t Port = 0; Port < PortControllers.size(); ++Port)
+    {
+        input.system[Port] = PortControllers[Port].has_value() ? SYSTEM_GAMEPAD : NO_SYSTEM;
+
+        switch (PortControllers[Port].value_or(ControllerType::Gamepad))
+        {
+        case ControllerType::Gamepad3Button: config.input[Port].padtype = DEVICE_PAD3B; break;
+        case ControllerType::Gamepad6Button: config.input[Port].padtype = DEVICE_PAD6B; break;
+        default: config.input[Port].padtype = DEVICE_PAD2B | DEVICE_PAD3B | DEVICE_PAD6B; break;
+        }
+    }
+
+    // Before a media is loaded, system_init() picks the devices up.
+    if (system_hw != 0)
+    {
+        input_init();
+        input_reset();
+    }
 }
 
 void GenesisPlusGX::SetControllerInputValue(int Port, int Input, float Value)
 {
+    if (Port >= 0 && Port < MaxControllerPorts && Input >= 0 && Input < ControllerInputCount)
+        ControllerInputValues[Port][Input] = Value;
 }
 
 void GenesisPlusGX::SetControllerInputValues(int Port, std::span<float> Values)
 {
+    if (Port >= 0 && Port < MaxControllerPorts)
+        std::copy_n(Values.begin(), std::min<std::size_t>(Values.size(), ControllerInputCount), ControllerInputValues[Port].begin());
+}
+
+std::span<const float> GenesisPlusGX::GetControllerInputValues(int Port) const
+{
+    if (Port < 0 || Port >= MaxControllerPorts)
+        return {};
+
+    return ControllerInputValues[Port];
+}
+
+void GenesisPlusGX::SetPointerInput(int Port, const PointerInput& Input)
+{
+    if (Port >= 0 && Port < MaxControllerPorts)
+        PointerInputs[Port] = Input;
+}
+
+const PointerInput& GenesisPlusGX::GetPointerInput(int Port) const
+{
+    return PointerInputs[static_cast<std::size_t>(std::clamp(Port, 0, MaxControllerPorts - 1))];
 }
 
 double GenesisPlusGX::GetRefreshUpdate()
 {
-    return vdp_pal ? 50.0 : 60.0;
+    if (!OwnsGlobalState())
+        return MCLOCK_NTSC / (262.0 * MCYCLES_PER_LINE);
+
+    // Exact hardware rate (59.92 Hz NTSC, 49.70 Hz PAL) from the master clock and the number of lines per frame.
+    const double MasterClock = vdp_pal ? MCLOCK_PAL : MCLOCK_NTSC;
+    const double LineCount = lines_per_frame != 0 ? lines_per_frame : (vdp_pal ? 313 : 262);
+    return MasterClock / (LineCount * MCYCLES_PER_LINE);
+}
+
+std::uint32_t GenesisPlusGX::GetAudioSampleRate() const
+{
+    return CoreAudioSampleRate;
 }
 
 void GenesisPlusGX::DoFrame()
 {
+    using Clock = std::chrono::steady_clock;
+    auto ElapsedNs = [](Clock::time_point Start, Clock::time_point End)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count());
+    };
+
+    if (!OwnsGlobalState())
+        return;
+
+    const Clock::time_point EmulationStart = Clock::now();
+    const int SkipRendering = IsRenderingSkipped ? 1 : 0;
+
     if (system_hw == SYSTEM_MCD)
     {
-        system_frame_scd(0);
+        system_frame_scd(SkipRendering);
     }
     else if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
     {
-        system_frame_gen(0);
+        system_frame_gen(SkipRendering);
     }
     else
     {
-        system_frame_sms(0);
+        system_frame_sms(SkipRendering);
     }
 
-    if (RenderFunc != nullptr)
-    {
-        std::vector<uint32_t> FrameBuffer(bitmap.viewport.w * bitmap.viewport.h);
+    const Clock::time_point VideoStart = Clock::now();
 
-        for (int X = 0; X < bitmap.viewport.w; X++)
+    if (RenderFunc != nullptr && !IsRenderingSkipped)
+    {
+        const FrameBufferView Frame =
         {
-            for (int Y = 0; Y < bitmap.viewport.h; Y++)
-            {
-                FrameBuffer[X + Y * bitmap.viewport.w] = reinterpret_cast<std::uint32_t*>(bitmap.data)[(Y + bitmap.viewport.y) * bitmap.width + (X + bitmap.viewport.x)];
-            }
-        }
-
-        RenderFunc(bitmap.viewport.w, bitmap.viewport.h, std::span<std::uint32_t>(FrameBuffer));
+            m_FrameBuffer.data(),
+            static_cast<std::uint32_t>(bitmap.pitch / sizeof(std::uint32_t)),
+            static_cast<std::uint32_t>(bitmap.viewport.x),
+            static_cast<std::uint32_t>(bitmap.viewport.y),
+            static_cast<std::uint32_t>(bitmap.viewport.w),
+            static_cast<std::uint32_t>(bitmap.viewport.h),
+        };
+
+        RenderFunc(Frame);
     }
 
+    const Clock::time_point AudioStart = Clock::now();
+
     std::int16_t AudioBuffer[2048] = {};
     const std::int16_t Size = audio_update(AudioBuffer) * 2;
 
@@ -349,6 +441,30 @@ void GenesisPlusGX::DoFrame()
     {
         AudioFunc(2, std::span<std::int16_t>(AudioBuffer, AudioBuffer + Size));
     }
+
+    const Clock::time_point FrameEnd = Clock::now();
+
+    LastFrameTimings.EmulationNs = ElapsedNs(EmulationStart, VideoStart);
+    LastFrameTimings.VideoNs = ElapsedNs(VideoStart, AudioStart);
+    LastFrameTimings.AudioNs = ElapsedNs(AudioStart, FrameEnd);
+}
+
+const std::string& GenesisPlusGX::GetSystemName() const
+{
+    static const std::string MegaCD = "Mega CD";
+    static const std::string Genesis = "Genesis";
+    static const std::string MasterSystem = "Master System";
+
+    if (!OwnsGlobalState())
+        return IEmulatorCore::GetSystemName();
+
+    if (system_hw == SYSTEM_MCD)
+        return MegaCD;
+
+    if ((system_hw & SYSTEM_PBC) == SYSTEM_MD)
+        return Genesis;
+
+    return MasterSystem;
 }
 
 const std::map<std::string, SettingType>& GenesisPlusGX::GetSettingsTypes() const
@@ -360,13 +476,44 @@ const std::map<std::string, SettingType>& GenesisPlusGX::GetSettingsTypes() cons
     return SettingsTypes;
 }
 
-std::vector<std::byte> GenesisPlusGX::SaveState() const
+std::size_t GenesisPlusGX::GetStateSize() const
 {
-    return std::vector<std::byte>();
+    return STATE_SIZE;
+}
+
+std::size_t GenesisPlusGX::SaveState(std::span<std::byte> StateBuffer) const
+{
+    // state_save() does not take a size, it relies on the buffer holding STATE_SIZE bytes.
+    if (!OwnsGlobalState() || StateBuffer.size() < STATE_SIZE)
+        return 0;
+
+    return static_cast<std::size_t>(std::max(state_save(reinterpret_cast<unsigned char*>(StateBuffer.data())), 0));
 }
 
 std::error_code GenesisPlusGX::LoadState(std::span<const std::byte> StateData)
 {
+    if (!OwnsGlobalState())
+        return std::make_error_code(std::errc::device_or_resource_busy);
+
+    if (StateData.empty() || StateData.size() > STATE_SIZE)
+        return std::make_error_code(std::errc::invalid_argument);
+
+    // state_load() trusts the data and reads as much as the current hardware configuration needs, so a short or
+    // mismatched state is padded to the full state size instead of letting it read past the end.
+    const unsigned char* Source = reinterpret_cast<const unsigned char*>(StateData.data());
+
+    if (StateData.size() < STATE_SIZE)
+    {
+        StateLoadBuffer.resize(STATE_SIZE);
+        std::ranges::copy(StateData, StateLoadBuffer.begin());
+        std::fill(StateLoadBuffer.begin() + static_cast<std::ptrdiff_t>(StateData.size()), StateLoadBuffer.end(), std::byte{});
+        Source = reinterpret_cast<const unsigned char*>(StateLoadBuffer.data());
+    }
+
+    // The pointer is not const in the C API but the state is only read.
+    if (state_load(const_cast<unsigned char*>(Source)) == 0)
+        return std::make_error_code(std::errc::invalid_argument);
+
     return {};
 }
 
@@ -394,6 +541,11 @@ const std::vector<MemoryRegion>& GenesisPlusGX::GetMemoryRegions() const
             if (Bank.base != nullptr)
                 Bank.base[(Address ^ 1) & 0xffff] = static_cast<std::uint8_t>(Value);
         },
+        16,
+        [](std::uint64_t PageIndex) -> MemoryPage
+        {
+            return { reinterpret_cast<std::byte*>(m68k.memory_map[PageIndex & 0xff].base), 1 };
+        },
     };
 
     static MemoryRegion Sub68k =
@@ -418,6 +570,11 @@ const std::vector<MemoryRegion>& GenesisPlusGX::GetMemoryRegions() const
            if (Bank.base != nullptr)
                Bank.base[(Address ^ 1) & 0xffff] = static_cast<std::uint8_t>(Value);
         },
+        16,
+        [](std::uint64_t PageIndex) -> MemoryPage
+        {
+            return { reinterpret_cast<std::byte*>(s68k.memory_map[PageIndex & 0xff].base), 1 };
+        },
     };
 
     static MemoryRegion VPDVRAM =
@@ -434,6 +591,11 @@ const std::vector<MemoryRegion>& GenesisPlusGX::GetMemoryRegions() const
         {
             vram[Address ^ 1] = static_cast<uint8>(Value);
         },
+        16,
+        [](std::uint64_t) -> MemoryPage
+        {
+            return { reinterpret_cast<std::byte*>(vram), 1 };
+        },
     };
 
     static MemoryRegion VPDCRAM =
@@ -450,6 +612,11 @@ const std::vector<MemoryRegion>& GenesisPlusGX::GetMemoryRegions() const
         {
             cram[Address] = static_cast<uint8>(Value);
         },
+        7,
+        [](std::uint64_t) -> MemoryPage
+        {
+            return { reinterpret_cast<std::byte*>(cram), 0 };
+        },
     };
 
     static MemoryRegion VPDVSRAM =
@@ -466,12 +633,20 @@ const std::vector<MemoryRegion>& GenesisPlusGX::GetMemoryRegions() const
         {
             vsram[Address] = static_cast<uint8>(Value);
         },
+        7,
+        [](std::uint64_t) -> MemoryPage
+        {
+            return { reinterpret_cast<std::byte*>(vsram), 0 };
+        },
     };
 
     static std::vector<MemoryRegion> MegaCD = { Main68k, Sub68k, VPDVRAM, VPDCRAM, VPDVSRAM };
     static std::vector<MemoryRegion> Genesis = { Main68k, VPDVRAM, VPDCRAM, VPDVSRAM };
     static std::vector<MemoryRegion> SMS = {  };
 
+    if (!OwnsGlobalState())
+        return IEmulatorCore::GetMemoryRegions();
+
     if (system_hw == SYSTEM_MCD)
         return MegaCD;
 
@@ -489,6 +664,10 @@ const std::vector<CPUDescription>& GenesisPlusGX::GetCPUs() const
 const std::vector<std::array<std::uint32_t, 256>>& GenesisPlusGX::GetTilePreviewPalettes() const
 {
     static std::vector<std::array<std::uint32_t, 256>> ColorPalettes;
+
+    if (!OwnsGlobalState())
+        return IEmulatorCore::GetTilePreviewPalettes();
+
     ColorPalettes.resize(4);
     std::size_t PaletteIndex = 0;
     for (auto& Palettes : ColorPalettes)
@@ -1,9 +1,22 @@
 #pragma once
 
+#include <array>
+#include <optional>
+
 #include "CoreWrapper/IEmulatorCore.h"
 
+// The wrapped core keeps its whole state in C globals, owned by the instance whose Initialize() ran first until its
+// Shutdown() or destruction. Every other instance is inert: it never touches the globals, InsertMediaSource() and
+// LoadState() fail with std::errc::device_or_resource_busy, DoFrame() does nothing and it exposes no state. Run
+// several games in separate processes (see the headless batch mode).
+//
+// This is a guard, not concurrency: running instances side by side in one process needs the core's globals moved into
+// a per-instance context inside the external/genesis-plus-gx fork, which has not been done.
 class GenesisPlusGX : public IEmulatorCore
 {
+public:
+    ~GenesisPlusGX() override;
+
     virtual const std::string& Name() const override;
 
     virtual void Initialize() override;
@@ -14,18 +27,25 @@ class GenesisPlusGX : public IEmulatorCore
     virtual std::error_code InsertMediaSource(std::string_view Path, int MediaSource)  override;
     virtual void RemoveMediaSource(int MediaSource) override;
 
-    virtual void PlugController(int Port, int Controller_type) override;
+    virtual void PlugController(int Port, int Type) override;
     virtual void UnplugController(int Port) override;
 
     virtual void SetControllerInputValue(int Port, int Input, float Value) override;
     virtual void SetControllerInputValues(int Port, std::span<float> Values) override;
+    [[nodiscard]] virtual std::span<const float> GetControllerInputValues(int Port) const override;
+    virtual void SetPointerInput(int Port, const PointerInput& Input) override;
+    [[nodiscard]] const PointerInput& GetPointerInput(int Port) const;
 
     virtual double GetRefreshUpdate() override;
+    [[nodiscard]] virtual std::uint32_t GetAudioSampleRate() const override;
     virtual void DoFrame() override;
 
+    [[nodiscard]] virtual const std::string& GetSystemName() const override;
+
     [[nodiscard]] virtual const std::map<std::string, SettingType>& GetSettingsTypes() const override;
 
-    [[nodiscard]] virtual std::vector<std::byte> SaveState() const override;
+    [[nodiscard]] virtual std::size_t GetStateSize() const override;
+    virtual std::size_t SaveState(std::span<std::byte> StateBuffer) const override;
     virtual std::error_code LoadState(std::span<const std::byte> StateData) override;
 
     [[nodiscard]] virtual const std::vector<MemoryRegion>& GetMemoryRegions() const override;
@@ -34,5 +54,16 @@ class GenesisPlusGX : public IEmulatorCore
     [[nodiscard]] virtual const std::vector<std::array<std::uint32_t, 256>>& GetTilePreviewPalettes() const override;
 
 private:
+    [[nodiscard]] bool AcquireGlobalState();
+    void ReleaseGlobalState();
+    [[nodiscard]] bool OwnsGlobalState() const;
+    // Pushes PortControllers to the core config, and to the devices if this instance has media inserted.
+    void ApplyControllerPorts();
+
     std::vector<std::uint32_t> m_FrameBuffer;
+    std::vector<std::byte> StateLoadBuffer;
+    std::array<std::array<float, ControllerInputCount>, MaxControllerPorts> ControllerInputValues {};
+    std::array<PointerInput, MaxControllerPorts> PointerInputs {};
+    // Ports A and B, empty when unplugged.
+    std::array<std::optional<ControllerType>, 2> PortControllers = { ControllerType::Gamepad, ControllerType::Gamepad };
 };
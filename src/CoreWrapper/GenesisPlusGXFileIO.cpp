@@ -0,0 +1,184 @@
+#include "GenesisPlusGXFileIO.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+#include "CoreWrapper/ChdHunkCache.h"
+#include "Util/MappedFile.h"
+
+extern "C"
+{
+    #include "shared.h"
+    #include "unzip.h"
+}
+
+namespace
+{
+    // Progress granularity, also how long a cancel request may wait.
+    constexpr std::size_t ChunkSize = 1024 * 1024;
+
+    constexpr char ZipSignature[4] = { 'P', 'K', '\x03', '\x04' };
+
+    // Like the SDL port, a file too large for the core is refused rather than truncated.
+    bool CheckFileSize(const std::filesystem::path& Path, std::uint64_t Size, int MaxSize)
+    {
+        if (Size <= static_cast<std::uint64_t>(MAXROMSIZE) && Size <= static_cast<std::uint64_t>(std::max(MaxSize, 0)))
+            return true;
+
+        std::cerr << "ERROR - File is too large: " << Path.string() << '\n';
+        return false;
+    }
+
+    // The core picks the hardware from the last three characters of the file name, e.g. "sms" or "bin".
+    void CopyExtension(std::string_view FileName, char* Extension)
+    {
+        if (Extension == nullptr)
+            return;
+
+        const std::size_t Length = std::min<std::size_t>(FileName.size(), 3);
+        std::memcpy(Extension, FileName.data() + FileName.size() - Length, Length);
+        Extension[Length] = '\0';
+    }
+
+    int LoadZipArchive(const std::filesystem::path& Path, unsigned char* Buffer, int MaxSize, char* Extension, MediaLoadScope* Scope)
+    {
+        unzFile Archive = unzOpen(Path.c_str());
+
+        if (Archive == nullptr)
+            return 0;
+
+        unz_file_info Info = {};
+        char FileName[256] = {};
+        int Size = 0;
+
+        // Like the SDL port, the media is the first file of the archive.
+        if (unzGoToFirstFile(Archive) == UNZ_OK && unzGetCurrentFileInfo(Archive, &Info, FileName, sizeof(FileName), nullptr, 0, nullptr, 0) == UNZ_OK &&
+            unzOpenCurrentFile(Archive) == UNZ_OK)
+        {
+            const int TotalSize = CheckFileSize(Path, Info.uncompressed_size, MaxSize) ? static_cast<int>(Info.uncompressed_size) : 0;
+
+            while (Size < TotalSize)
+            {
+                const int Count = unzReadCurrentFile(Archive, Buffer + Size, static_cast<unsigned>(std::min<std::size_t>(ChunkSize, TotalSize - Size)));
+
+                if (Count <= 0 || (Scope != nullptr && !Scope->ReportProgress(static_cast<float>(Size + Count) / TotalSize)))
+                {
+                    Size = 0;
+                    break;
+                }
+
+                Size += Count;
+            }
+
+            unzCloseCurrentFile(Archive);
+            CopyExtension(FileName, Extension);
+        }
+
+        unzClose(Archive);
+        return Size;
+    }
+}
+
+extern "C" int load_archive(char* filename, unsigned char* buffer, int maxsize, char* extension)
+{
+    MediaLoadScope* Scope = MediaLoadScope::Active();
+    const std::filesystem::path Path = Scope != nullptr ? Scope->ResolvePath(filename) : std::filesystem::path(filename);
+
+    MappedFile File;
+
+    if (File.Open(Path))
+        return 0;
+
+    const std::span<const std::byte> Data = File.Data();
+
+    if (IsZipArchive(Data))
+    {
+        File.Close();
+        return LoadZipArchive(Path, buffer, maxsize, extension, Scope);
+    }
+
+    // The core owns the destination buffer, the mapping only saves the read() copies and lets the kernel read ahead.
+    File.AdviseSequentialRead();
+
+    if (!CheckFileSize(Path, Data.size(), maxsize))
+        return 0;
+
+    const std::size_t Size = Data.size();
+
+    for (std::size_t Offset = 0; Offset < Size; Offset += ChunkSize)
+    {
+        const std::size_t Count = std::min(ChunkSize, Size - Offset);
+        std::memcpy(buffer + Offset, Data.data() + Offset, Count);
+
+        if (Scope != nullptr && !Scope->ReportProgress(static_cast<float>(Offset + Count) / static_cast<float>(Size)))
+            return 0;
+    }
+
+    CopyExtension(filename, extension);
+    return static_cast<int>(Size);
+}
+
+bool IsZipArchive(std::span<const std::byte> Data)
+{
+    return Data.size() >= sizeof(ZipSignature) && std::memcmp(Data.data(), ZipSignature, sizeof(ZipSignature)) == 0;
+}
+
+// The core's libchdr calls, redirected by the linker (see CMakeLists.txt). Defined here rather than with the cache so
+// they are linked whenever the core is.
+extern "C" chd_error __wrap_chd_open(const char* filename, int mode, chd_file* parent, chd_file** chd)
+{
+    const chd_error Error = __real_chd_open(filename, mode, parent, chd);
+
+    // Parent images are opened by the caller, the cache only knows how to reopen a standalone image.
+    if (Error == CHDERR_NONE && mode == CHD_OPEN_READ && parent == nullptr)
+        ChdHunkCache::Attach(*chd, filename);
+
+    return Error;
+}
+
+extern "C" chd_error __wrap_chd_read(chd_file* chd, UINT32 hunknum, void* buffer)
+{
+    if (ChdHunkCache* Cache = ChdHunkCache::Find(chd))
+        return Cache->Read(hunknum, buffer);
+
+    return __real_chd_read(chd, hunknum, buffer);
+}
+
+extern "C" void __wrap_chd_close(chd_file* chd)
+{
+    ChdHunkCache::Detach(chd);
+    __real_chd_close(chd);
+}
+
+MediaLoadScope::MediaLoadScope(std::filesystem::path MediaPath, std::filesystem::path BiosFolder, MediaLoadCallback Callback)
+    : MediaPath(std::move(MediaPath)), BiosFolder(std::move(BiosFolder)), Callback(Callback)
+{
+    ActiveScope = this;
+}
+
+MediaLoadScope::~MediaLoadScope()
+{
+    ActiveScope = nullptr;
+}
+
+std::filesystem::path MediaLoadScope::ResolvePath(const char* FileName) const
+{
+    std::filesystem::path Path(FileName);
+
+    // The game is opened as given, only the core's own file names are relative to the BIOS folder.
+    if (Path.is_relative() && Path != MediaPath && !BiosFolder.empty())
+        return BiosFolder / Path;
+
+    return Path;
+}
+
+bool MediaLoadScope::ReportProgress(float Progress)
+{
+    if (Callback != nullptr && !Callback(Progress))
+        IsCancelRequested = true;
+
+    return !IsCancelRequested;
+}
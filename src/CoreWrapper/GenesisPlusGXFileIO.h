@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include "CoreWrapper/IEmulatorCore.h"
+
+// File access of the wrapped core: load_archive(), which the core calls for the game and the BIOS files it needs,
+// replaces the SDL port's fileio.c. Plain files are read through a memory mapping, ZIP archives through minizip, both in
+// chunks so the load reports its progress and can be canceled between two chunks.
+//
+// The core names its BIOS files relative to the working directory (see osd.h). While a scope is alive, those are
+// resolved against the BIOS folder instead, so loading never changes the process-wide working directory.
+
+// Whether the file starts with a ZIP local file header, which load_archive() opens as an archive. Shared with the ROM
+// library so it hashes the same file the core loads.
+[[nodiscard]] bool IsZipArchive(std::span<const std::byte> Data);
+
+class MediaLoadScope
+{
+public:
+    MediaLoadScope(std::filesystem::path MediaPath, std::filesystem::path BiosFolder, MediaLoadCallback Callback);
+    ~MediaLoadScope();
+
+    MediaLoadScope(const MediaLoadScope&) = delete;
+    MediaLoadScope& operator=(const MediaLoadScope&) = delete;
+
+    [[nodiscard]] bool IsCanceled() const { return IsCancelRequested; }
+
+    // Called by load_archive().
+    [[nodiscard]] std::filesystem::path ResolvePath(const char* FileName) const;
+    [[nodiscard]] bool ReportProgress(float Progress);
+
+    // Scope of the load in progress, only one core instance loads media at a time (see GenesisPlusGX.h).
+    [[nodiscard]] static MediaLoadScope* Active() { return ActiveScope; }
+
+private:
+    static inline MediaLoadScope* ActiveScope = nullptr;
+
+    std::filesystem::path MediaPath;
+    std::filesystem::path BiosFolder;
+    MediaLoadCallback Callback;
+    bool IsCancelRequested = false;
+};
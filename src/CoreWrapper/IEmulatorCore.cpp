@@ -1,7 +1,45 @@
 #include "IEmulatorCore.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "Util/Config.h"
 
+namespace
+{
+    // Calls Visit(Address, Index, Count, Page) for each run of [Address, Address + Size) inside the region and in a
+    // single page, Index being the position of the run in the block. Without a page table, Page is always empty.
+    template<typename VisitType>
+    void ForEachPage(const MemoryRegion& Region, std::uint64_t Address, std::size_t Size, VisitType&& Visit)
+    {
+        if (Size == 0 || Address > Region.EndAddress || Address + (Size - 1) < Region.StartAddress)
+            return;
+
+        const std::uint64_t First = std::max(Address, Region.StartAddress);
+        const std::uint64_t Last = std::min(Address + (Size - 1), Region.EndAddress);
+
+        for (std::uint64_t Current = First; Current <= Last;)
+        {
+            std::uint64_t RunLast = Last;
+            MemoryPage Page;
+
+            if (Region.GetPage)
+            {
+                const std::uint64_t PageMask = (std::uint64_t{1} << Region.PageBits) - 1;
+                RunLast = std::min(Last, Current | PageMask);
+                Page = Region.GetPage(Current >> Region.PageBits);
+            }
+
+            Visit(Current, static_cast<std::size_t>(Current - Address), static_cast<std::size_t>(RunLast - Current + 1), Page);
+
+            if (RunLast == Last)
+                break;
+
+            Current = RunLast + 1;
+        }
+    }
+}
+
 IEmulatorCore* IEmulatorCore::CurrentCore = nullptr;
 
 IEmulatorCore* IEmulatorCore::Current()
@@ -14,22 +52,87 @@ void IEmulatorCore::SetCurrent(IEmulatorCore* Core)
     CurrentCore = Core;
 }
 
-const std::string& IEmulatorCore::GetSettingValue(const std::string& SettingName) const
+void IEmulatorCore::SetPointerInput(int Port, const PointerInput& Input)
+{
+}
+
+std::vector<std::byte> IEmulatorCore::SaveState() const
+{
+    std::vector<std::byte> State(GetStateSize());
+    State.resize(SaveState(std::span<std::byte>(State)));
+    return State;
+}
+
+void MemoryRegion::ReadBlock(std::uint64_t Address, std::span<std::byte> Output) const
+{
+    std::ranges::fill(Output, std::byte{});
+
+    ForEachPage(*this, Address, Output.size(), [&](std::uint64_t RunAddress, std::size_t Index, std::size_t Count, const MemoryPage& Page)
+    {
+        const std::span<std::byte> Run = Output.subspan(Index, Count);
+
+        if (Page.Data == nullptr)
+        {
+            for (std::byte& Byte : Run)
+                Byte = Read(RunAddress++);
+        }
+        else if (const std::uint64_t Offset = RunAddress & ((std::uint64_t{1} << PageBits) - 1); Page.AddressXor == 0)
+        {
+            std::memcpy(Run.data(), Page.Data + Offset, Count);
+        }
+        else
+        {
+            for (std::size_t Position = 0; Position < Count; ++Position)
+                Run[Position] = Page.Data[(Offset + Position) ^ Page.AddressXor];
+        }
+    });
+}
+
+void MemoryRegion::WriteBlock(std::uint64_t Address, std::span<const std::byte> Input) const
+{
+    ForEachPage(*this, Address, Input.size(), [&](std::uint64_t RunAddress, std::size_t Index, std::size_t Count, const MemoryPage& Page)
+    {
+        const std::span<const std::byte> Run = Input.subspan(Index, Count);
+
+        if (Page.Data == nullptr)
+        {
+            for (const std::byte Byte : Run)
+                Write(RunAddress++, Byte);
+        }
+        else if (const std::uint64_t Offset = RunAddress & ((std::uint64_t{1} << PageBits) - 1); Page.AddressXor == 0)
+        {
+            std::memcpy(Page.Data + Offset, Run.data(), Count);
+        }
+        else
+        {
+            for (std::size_t Position = 0; Position < Count; ++Position)
+                Page.Data[(Offset + Position) ^ Page.AddressXor] = Run[Position];
+        }
+    });
+}
+
+ConfigKey IEmulatorCore::GetSettingKey(std::string_view SettingName) const
+{
+    std::scoped_lock Lock(SettingKeysMutex);
+
+    if (const auto Found = SettingKeys.find(SettingName); Found != SettingKeys.end())
+        return Found->second;
+
+    std::string Key = "Core.";
+    Key += Name();
+    Key += '.';
+    Key += SettingName;
+    return SettingKeys.emplace(std::string(SettingName), Config::Instance().Intern(Key)).first->second;
+}
+
+std::string IEmulatorCore::GetSettingValue(std::string_view SettingName) const
 {
-    std::string ConfigKey = "EmulatorCore.";
-    ConfigKey += Name();
-    ConfigKey += ".";
-    ConfigKey += SettingName;
-    return Config::Instance()[ConfigKey];
+    return Config::Instance().GetValue(GetSettingKey(SettingName), "");
 }
 
-void IEmulatorCore::SetSettingValue(const std::string& SettingName, const std::string& Value) const
+void IEmulatorCore::SetSettingValue(std::string_view SettingName, std::string_view Value) const
 {
-    std::string ConfigKey = "EmulatorCore.";
-    ConfigKey += Name();
-    ConfigKey += ".";
-    ConfigKey += SettingName;
-    Config::Instance()[ConfigKey] = Value;
+    Config::Instance().SetValue(GetSettingKey(SettingName), Value);
 }
 
 const std::vector<MemoryRegion>& IEmulatorCore::GetMemoryRegions() const
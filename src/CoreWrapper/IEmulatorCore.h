@@ -3,18 +3,52 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <span>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
+#include "Util/Config.h"
+
 enum class EmulatorError
 {
     Success = 0,
     UnableToLoadTheMediaSource,
 };
 
-using RenderCallback = void(*)(std::uint32_t Width, std::uint32_t Height, std::span<std::uint32_t> Pixels);
+// Strided view on the core's own frame buffer, only valid for the duration of the render callback.
+struct FrameBufferView
+{
+    const std::uint32_t* Pixels = nullptr;
+    std::uint32_t Pitch = 0; // Distance in pixels between two rows of Pixels.
+    std::uint32_t X = 0;
+    std::uint32_t Y = 0;
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+};
+
+using RenderCallback = void(*)(const FrameBufferView& Frame);
 using AudioCallback = void(*)(std::uint32_t NumChannels, std::span<std::int16_t> Samples);
+// Progress of InsertMediaSource() in [0, 1] for the file being read, returning false cancels the load, which then
+// fails with std::errc::operation_canceled.
+using MediaLoadCallback = bool(*)(float Progress);
+
+// Wall time spent in each stage of the last DoFrame() call.
+struct FrameStageTimings
+{
+    std::uint64_t EmulationNs = 0;
+    std::uint64_t AudioNs = 0;
+    std::uint64_t VideoNs = 0;
+};
+
+// Host memory currently mapped at one page of a region.
+struct MemoryPage
+{
+    std::byte* Data = nullptr; // nullptr when the page is not plain memory (I/O, unmapped), Read/Write handle it.
+    // Applied to the offset in the page: 1 for memory of a big-endian CPU kept as host-order 16-bit words.
+    std::uint64_t AddressXor = 0;
+};
 
 struct MemoryRegion
 {
@@ -24,6 +58,14 @@ struct MemoryRegion
     std::uint64_t EndAddress ;
     std::function<std::byte(std::uint64_t)> Read;
     std::function<void(std::uint64_t, std::byte)> Write;
+    // Optional page table, looked up once per page by the block accesses instead of calling Read/Write per byte.
+    // Queried on every access since bank switching may remap a page.
+    std::uint32_t PageBits = 0;
+    std::function<MemoryPage(std::uint64_t PageIndex)> GetPage;
+
+    // Bytes outside of the region read as 0 and are not written. Same threading rules as Read/Write.
+    void ReadBlock(std::uint64_t Address, std::span<std::byte> Output) const;
+    void WriteBlock(std::uint64_t Address, std::span<const std::byte> Input) const;
 };
 
 struct TileInfo
@@ -58,6 +100,53 @@ struct CPUDescription
     std::function<std::string(std::uint64_t Address, std::uint64_t Flags)> FormatedDisassemble;
 };
 
+// Inputs of a standard controller, the Input index given to SetControllerInputValue() and the order of the values
+// of SetControllerInputValues(). Digital inputs are pressed when their value is at least 0.5.
+enum class ControllerInput : int
+{
+    Up,
+    Down,
+    Left,
+    Right,
+    A,
+    B,
+    C,
+    X,
+    Y,
+    Z,
+    Start,
+    Mode,
+    Count,
+};
+
+constexpr int ControllerInputCount = static_cast<int>(ControllerInput::Count);
+constexpr int MaxControllerPorts = 8;
+
+enum class PointerButton : std::uint32_t
+{
+    Left = 1,
+    Right = 2,
+    Middle = 4,
+};
+
+// State of a mouse-like device (light gun, paddle, mouse, drawing pen) given to SetPointerInput().
+struct PointerInput
+{
+    // Relative motion in host pixels since the previous frame.
+    float DeltaX = 0.0f;
+    float DeltaY = 0.0f;
+    std::uint32_t Buttons = 0; // PointerButton bits.
+};
+
+// Type given to PlugController(), each core maps it to its closest device.
+enum class ControllerType : int
+{
+    Gamepad, // Standard pad, the core picks the button count the media supports.
+    Gamepad3Button,
+    Gamepad6Button,
+    Count,
+};
+
 enum class SettingType
 {
     String,
@@ -86,25 +175,49 @@ public:
     virtual std::error_code InsertMediaSource(std::string_view path, int MediaSource) = 0;
     virtual void RemoveMediaSource(int MediaSource) = 0;
 
-    virtual void PlugController(int Port, int ControllerType) = 0;
+    // Emulation thread: reconfigures the devices of a running media.
+    virtual void PlugController(int Port, int Type) = 0;
     virtual void UnplugController(int Port) = 0;
 
     virtual void SetControllerInputValue(int Port, int Input, float Value) = 0;
     virtual void SetControllerInputValues(int Port, std::span<float> Values) = 0;
+    // Values used by the next frame, empty for a port the core does not have.
+    [[nodiscard]] virtual std::span<const float> GetControllerInputValues(int Port) const = 0;
+    // Used by the next frame when the media drives a mouse-like device on that port, ignored by default.
+    virtual void SetPointerInput(int Port, const PointerInput& Input);
 
     void SetRenderCallback(const RenderCallback Render) { RenderFunc = Render; };
     void SetAudioCallback(const AudioCallback Audio) { AudioFunc = Audio; };
+    [[nodiscard]] RenderCallback GetRenderCallback() const { return RenderFunc; }
+    [[nodiscard]] AudioCallback GetAudioCallback() const { return AudioFunc; }
+    // Called from the thread running InsertMediaSource(), which may take a while for large media.
+    void SetMediaLoadCallback(const MediaLoadCallback MediaLoad) { MediaLoadFunc = MediaLoad; }
+
+    // Frames whose picture is thrown away (run-ahead) may skip rendering, the render callback is not called then.
+    // Cores are free to be less accurate in that mode, so it is never used for frames that stay in the timeline.
+    void SetRenderingSkipped(bool IsSkipped) { IsRenderingSkipped = IsSkipped; }
 
     virtual double GetRefreshUpdate() = 0;
+    // Rate of the samples handed to the audio callback, per emulated second.
+    [[nodiscard]] virtual std::uint32_t GetAudioSampleRate() const = 0;
     virtual void DoFrame() = 0;
 
-    [[nodiscard]] virtual std::vector<std::byte> SaveState() const = 0;
+    [[nodiscard]] const FrameStageTimings& GetLastFrameTimings() const { return LastFrameTimings; }
+    [[nodiscard]] virtual const std::string& GetSystemName() const { return Name(); }
+
+    // Upper bound of a serialized state, the buffer given to SaveState() must be at least that large.
+    [[nodiscard]] virtual std::size_t GetStateSize() const = 0;
+    // Serializes into a caller-owned buffer without allocating, returns the size written or 0 on failure.
+    virtual std::size_t SaveState(std::span<std::byte> StateBuffer) const = 0;
+    [[nodiscard]] std::vector<std::byte> SaveState() const;
     virtual std::error_code LoadState(std::span<const std::byte> state_data) = 0;
 
     [[nodiscard]] virtual const std::map<std::string, SettingType>& GetSettingsTypes() const = 0;
 
-    [[nodiscard]] const std::string& GetSettingValue(const std::string& SettingName) const;
-    void SetSettingValue(const std::string& SettingName, const std::string& Value) const;
+    // Settings are stored as "Core.<Name>.<Setting>", the key of each setting is only built and interned once.
+    [[nodiscard]] ConfigKey GetSettingKey(std::string_view SettingName) const;
+    [[nodiscard]] std::string GetSettingValue(std::string_view SettingName) const;
+    void SetSettingValue(std::string_view SettingName, std::string_view Value) const;
 
     [[nodiscard]] virtual const std::vector<MemoryRegion>& GetMemoryRegions() const;
     [[nodiscard]] virtual const std::vector<CPUDescription>& GetCPUs() const;
@@ -114,6 +227,13 @@ public:
 protected:
     RenderCallback RenderFunc = nullptr;
     AudioCallback AudioFunc = nullptr;
+    MediaLoadCallback MediaLoadFunc = nullptr;
+    bool IsRenderingSkipped = false;
+    FrameStageTimings LastFrameTimings;
 
     static IEmulatorCore* CurrentCore;
+
+private:
+    mutable std::mutex SettingKeysMutex;
+    mutable std::map<std::string, ConfigKey, std::less<>> SettingKeys;
 };
@@ -0,0 +1,412 @@
+#include "InputMovie.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <optional>
+
+#include "Util/HashUtil.h"
+#include "Util/StateFile.h"
+
+namespace
+{
+    constexpr char MovieMagic[4] = { 'U', 'P', 'M', 'V' };
+    constexpr std::uint16_t MovieVersion = 1;
+    constexpr std::size_t MovieHeaderSize = 4 + 2 + 1 + 1 + 4 + 8 + 8;
+
+    enum MovieRecordType : std::uint8_t
+    {
+        MovieRecordInput = 1,
+        MovieRecordKeyframe = 2,
+        MovieRecordEnd = 3,
+    };
+
+    void AppendBytes(std::vector<std::byte>& Output, std::uint64_t Value, std::size_t ByteCount)
+    {
+        for (std::size_t Index = 0; Index < ByteCount; ++Index)
+            Output.push_back(static_cast<std::byte>(Value >> (Index * 8)));
+    }
+
+    void AppendVarint(std::vector<std::byte>& Output, std::uint64_t Value)
+    {
+        while (Value >= 0x80)
+        {
+            Output.push_back(static_cast<std::byte>((Value & 0x7f) | 0x80));
+            Value >>= 7;
+        }
+
+        Output.push_back(static_cast<std::byte>(Value));
+    }
+
+    // Bounds-checked cursor over the mapped movie, every read fails once the data is exhausted.
+    struct MovieReader
+    {
+        std::span<const std::byte> Data;
+        std::size_t Offset = 0;
+
+        std::optional<std::uint64_t> ReadBytes(std::size_t ByteCount)
+        {
+            if (Data.size() - Offset < ByteCount)
+                return std::nullopt;
+
+            std::uint64_t Value = 0;
+
+            for (std::size_t Index = 0; Index < ByteCount; ++Index)
+                Value |= static_cast<std::uint64_t>(Data[Offset + Index]) << (Index * 8);
+
+            Offset += ByteCount;
+            return Value;
+        }
+
+        std::optional<std::uint64_t> ReadVarint()
+        {
+            std::uint64_t Value = 0;
+
+            for (unsigned Shift = 0; Shift < 64 && Offset < Data.size(); Shift += 7)
+            {
+                const auto Byte = static_cast<std::uint8_t>(Data[Offset++]);
+                Value |= static_cast<std::uint64_t>(Byte & 0x7f) << Shift;
+
+                if ((Byte & 0x80) == 0)
+                    return Value;
+            }
+
+            return std::nullopt;
+        }
+
+        std::optional<std::span<const std::byte>> ReadSpan(std::uint64_t Size)
+        {
+            if (Data.size() - Offset < Size)
+                return std::nullopt;
+
+            const std::span<const std::byte> Span = Data.subspan(Offset, static_cast<std::size_t>(Size));
+            Offset += static_cast<std::size_t>(Size);
+            return Span;
+        }
+    };
+}
+
+std::error_code HashMediaFile(const std::filesystem::path& Path, std::uint64_t& Hash)
+{
+    MappedFile Media;
+
+    if (const std::error_code Error = Media.Open(Path))
+        return Error;
+
+    Hash = FNV1A_64Offset;
+
+    for (const std::byte Byte : Media.Data())
+        FNV1A_64Update(Hash, static_cast<unsigned char>(Byte));
+
+    return {};
+}
+
+std::error_code InputMovieRecorder::Begin(const std::filesystem::path& Path, const IEmulatorCore& Core, std::uint64_t MediaHash,
+    std::uint32_t NewPortCount, std::uint32_t NewKeyframeInterval)
+{
+    End();
+
+    StateBuffer.resize(Core.GetStateSize());
+    StateBuffer.resize(Core.SaveState(std::span<std::byte>(StateBuffer)));
+
+    if (StateBuffer.empty())
+        return std::make_error_code(std::errc::io_error);
+
+    if (const std::error_code Error = CompressState(StateBuffer, CompressionBuffer))
+        return Error;
+
+    PortCount = std::clamp<std::uint32_t>(NewPortCount, 1, MaxControllerPorts);
+    KeyframeInterval = std::max<std::uint32_t>(NewKeyframeInterval, 1);
+    FrameIndex = 0;
+    LastRecordFrame = 0;
+    LastMasks.fill(0);
+
+    Record.clear();
+    Record.insert(Record.end(), reinterpret_cast<const std::byte*>(MovieMagic), reinterpret_cast<const std::byte*>(MovieMagic) + 4);
+    AppendBytes(Record, MovieVersion, 2);
+    AppendBytes(Record, PortCount, 1);
+    AppendBytes(Record, 0, 1);
+    AppendBytes(Record, KeyframeInterval, 4);
+    AppendBytes(Record, MediaHash, 8);
+    AppendBytes(Record, CompressionBuffer.size(), 8);
+    Record.insert(Record.end(), CompressionBuffer.begin(), CompressionBuffer.end());
+
+    if (!Path.parent_path().empty())
+        std::filesystem::create_directories(Path.parent_path());
+
+    Stream.open(Path, std::ios::binary | std::ios::trunc);
+
+    if (!Stream.write(reinterpret_cast<const char*>(Record.data()), static_cast<std::streamsize>(Record.size())))
+    {
+        Stream.close();
+        return std::make_error_code(std::errc::io_error);
+    }
+
+    return {};
+}
+
+void InputMovieRecorder::BeginRecord(std::uint8_t Type)
+{
+    Record.clear();
+    Record.push_back(static_cast<std::byte>(Type));
+    AppendVarint(Record, FrameIndex - LastRecordFrame);
+    LastRecordFrame = FrameIndex;
+}
+
+void InputMovieRecorder::RecordFrame(const IEmulatorCore& Core)
+{
+    if (!Stream.is_open())
+        return;
+
+    // The starting state already covers frame 0.
+    if (FrameIndex != 0 && FrameIndex % KeyframeInterval == 0)
+    {
+        StateBuffer.resize(Core.GetStateSize());
+        StateBuffer.resize(Core.SaveState(std::span<std::byte>(StateBuffer)));
+
+        if (!StateBuffer.empty() && !CompressState(StateBuffer, CompressionBuffer, 1))
+        {
+            BeginRecord(MovieRecordKeyframe);
+            AppendVarint(Record, CompressionBuffer.size());
+            Record.insert(Record.end(), CompressionBuffer.begin(), CompressionBuffer.end());
+            Stream.write(reinterpret_cast<const char*>(Record.data()), static_cast<std::streamsize>(Record.size()));
+
+            // Everything up to the keyframe survives a crash.
+            Stream.flush();
+        }
+    }
+
+    std::array<ControllerInputMask, MaxControllerPorts> Masks {};
+
+    for (std::uint32_t Port = 0; Port < PortCount; ++Port)
+    {
+        const std::span<const float> Values = Core.GetControllerInputValues(static_cast<int>(Port));
+
+        for (std::size_t Input = 0; Input < Values.size() && Input < 32; ++Input)
+        {
+            if (Values[Input] >= 0.5f)
+                Masks[Port] |= ControllerInputMask(1) << Input;
+        }
+    }
+
+    if (Masks != LastMasks)
+    {
+        BeginRecord(MovieRecordInput);
+
+        for (std::uint32_t Port = 0; Port < PortCount; ++Port)
+            AppendVarint(Record, Masks[Port] ^ LastMasks[Port]);
+
+        Stream.write(reinterpret_cast<const char*>(Record.data()), static_cast<std::streamsize>(Record.size()));
+        LastMasks = Masks;
+    }
+
+    ++FrameIndex;
+}
+
+std::error_code InputMovieRecorder::End()
+{
+    if (!Stream.is_open())
+        return {};
+
+    BeginRecord(MovieRecordEnd);
+    Stream.write(reinterpret_cast<const char*>(Record.data()), static_cast<std::streamsize>(Record.size()));
+
+    const bool HasSucceeded = Stream.flush().good();
+    Stream.close();
+
+    return HasSucceeded ? std::error_code{} : std::make_error_code(std::errc::io_error);
+}
+
+std::error_code InputMoviePlayer::Open(const std::filesystem::path& Path)
+{
+    Close();
+
+    if (const std::error_code Error = File.Open(Path))
+        return Error;
+
+    MovieReader Reader { File.Data() };
+    const auto InvalidMovie = [this]()
+    {
+        Close();
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+    };
+
+    if (File.Data().size() < MovieHeaderSize || std::memcmp(File.Data().data(), MovieMagic, 4) != 0)
+        return InvalidMovie();
+
+    Reader.Offset = 4;
+
+    if (Reader.ReadBytes(2) != MovieVersion)
+        return InvalidMovie();
+
+    PortCount = static_cast<std::uint32_t>(*Reader.ReadBytes(1));
+    Reader.ReadBytes(1);
+    Reader.ReadBytes(4);
+    MediaHash = *Reader.ReadBytes(8);
+
+    const std::optional<std::span<const std::byte>> StartState = Reader.ReadSpan(*Reader.ReadBytes(8));
+
+    if (PortCount == 0 || PortCount > MaxControllerPorts || !StartState)
+        return InvalidMovie();
+
+    Keyframes.push_back({ 0, *StartState });
+
+    std::array<ControllerInputMask, MaxControllerPorts> Masks {};
+    std::uint64_t Frame = 0;
+
+    // A record cut short ends the movie at the previous one.
+    while (Reader.Offset < File.Data().size())
+    {
+        const std::optional<std::uint64_t> Type = Reader.ReadBytes(1);
+        const std::optional<std::uint64_t> FrameDelta = Reader.ReadVarint();
+
+        if (!FrameDelta)
+            break;
+
+        const std::uint64_t RecordFrame = Frame + *FrameDelta;
+
+        if (*Type == MovieRecordInput)
+        {
+            InputChange Change { RecordFrame, Masks };
+            bool IsComplete = true;
+
+            for (std::uint32_t Port = 0; Port < PortCount && IsComplete; ++Port)
+            {
+                const std::optional<std::uint64_t> Delta = Reader.ReadVarint();
+                IsComplete = Delta.has_value();
+                Change.Masks[Port] ^= static_cast<ControllerInputMask>(Delta.value_or(0));
+            }
+
+            if (!IsComplete)
+                break;
+
+            Masks = Change.Masks;
+            InputChanges.push_back(Change);
+        }
+        else if (*Type == MovieRecordKeyframe)
+        {
+            const std::optional<std::uint64_t> Size = Reader.ReadVarint();
+            const std::optional<std::span<const std::byte>> State = Size ? Reader.ReadSpan(*Size) : std::nullopt;
+
+            if (!State)
+                break;
+
+            Keyframes.push_back({ RecordFrame, *State });
+        }
+        else if (*Type == MovieRecordEnd)
+        {
+            Frame = RecordFrame;
+            break;
+        }
+        else
+        {
+            return InvalidMovie();
+        }
+
+        Frame = RecordFrame;
+    }
+
+    FrameCount = Frame;
+    CurrentFrame = 0;
+    return {};
+}
+
+void InputMoviePlayer::Close()
+{
+    File.Close();
+    Keyframes.clear();
+    InputChanges.clear();
+    PortCount = 0;
+    FrameCount = 0;
+    CurrentFrame = 0;
+}
+
+std::error_code InputMoviePlayer::Begin(IEmulatorCore& Core, std::uint64_t CurrentMediaHash)
+{
+    if (!File.IsOpen())
+        return std::make_error_code(std::errc::bad_file_descriptor);
+
+    if (CurrentMediaHash != MediaHash)
+        return std::make_error_code(std::errc::invalid_argument);
+
+    return LoadKeyframe(Core, Keyframes.front());
+}
+
+bool InputMoviePlayer::ApplyFrame(IEmulatorCore& Core)
+{
+    if (CurrentFrame >= FrameCount)
+        return false;
+
+    const auto NextChange = std::upper_bound(InputChanges.begin(), InputChanges.end(), CurrentFrame, [](std::uint64_t Frame, const InputChange& Change)
+    {
+        return Frame < Change.Frame;
+    });
+
+    for (std::uint32_t Port = 0; Port < PortCount; ++Port)
+    {
+        const ControllerInputMask Mask = NextChange == InputChanges.begin() ? 0 : std::prev(NextChange)->Masks[Port];
+
+        for (int Input = 0; Input < ControllerInputCount; ++Input)
+            InputValues[Input] = (Mask >> Input) & 1 ? 1.0f : 0.0f;
+
+        Core.SetControllerInputValues(static_cast<int>(Port), InputValues);
+    }
+
+    ++CurrentFrame;
+    return true;
+}
+
+std::error_code InputMoviePlayer::Seek(IEmulatorCore& Core, std::uint64_t TargetFrame, bool IsTurbo)
+{
+    if (!File.IsOpen())
+        return std::make_error_code(std::errc::bad_file_descriptor);
+
+    TargetFrame = std::min(TargetFrame, FrameCount);
+
+    const auto NextKeyframe = std::upper_bound(Keyframes.begin(), Keyframes.end(), TargetFrame, [](std::uint64_t Frame, const Keyframe& Entry)
+    {
+        return Frame < Entry.Frame;
+    });
+    const Keyframe& Closest = *std::prev(NextKeyframe);
+
+    // Running forward from the current frame beats restoring an older keyframe.
+    if (TargetFrame < CurrentFrame || Closest.Frame > CurrentFrame)
+    {
+        if (const std::error_code Error = LoadKeyframe(Core, Closest))
+            return Error;
+    }
+
+    const RenderCallback Render = Core.GetRenderCallback();
+    const AudioCallback Audio = Core.GetAudioCallback();
+
+    if (IsTurbo)
+    {
+        Core.SetRenderCallback(nullptr);
+        Core.SetAudioCallback(nullptr);
+        Core.SetRenderingSkipped(true);
+    }
+
+    while (CurrentFrame < TargetFrame && ApplyFrame(Core))
+        Core.DoFrame();
+
+    if (IsTurbo)
+    {
+        Core.SetRenderingSkipped(false);
+        Core.SetRenderCallback(Render);
+        Core.SetAudioCallback(Audio);
+    }
+
+    return {};
+}
+
+std::error_code InputMoviePlayer::LoadKeyframe(IEmulatorCore& Core, const Keyframe& Entry)
+{
+    if (const std::error_code Error = DecompressState(Entry.Data, StateBuffer))
+        return Error;
+
+    if (const std::error_code Error = Core.LoadState(StateBuffer))
+        return Error;
+
+    CurrentFrame = Entry.Frame;
+    return {};
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "CoreWrapper/IEmulatorCore.h"
+#include "Util/MappedFile.h"
+
+// Movie file: per-frame controller input recorded from a starting state, replayed deterministically.
+//
+// Header (little-endian): "UPMV", u16 version, u8 port count, u8 reserved, u32 keyframe interval, u64 FNV-1a hash
+// of the media file, u64 size of the starting state followed by the state as a zstd frame.
+// Then a stream of records, each a type byte and a varint frame delta from the previous record:
+//   Input    - one varint per port, XOR of the new input mask with the previous one.
+//   Keyframe - varint size and zstd compressed state, captured before the frame, used for seeking.
+//   End      - total number of frames. A movie cut short by a crash simply ends at its last complete record.
+
+// Digital state of one port, bit N set when ControllerInput N is pressed.
+using ControllerInputMask = std::uint32_t;
+
+// FNV-1a of the whole media file, identifies the media a movie was recorded with.
+// Reads the whole file: compute it once per media, away from the emulation thread.
+std::error_code HashMediaFile(const std::filesystem::path& Path, std::uint64_t& Hash);
+
+class InputMovieRecorder
+{
+public:
+    static constexpr std::uint32_t DefaultKeyframeInterval = 600;
+
+    ~InputMovieRecorder() { End(); }
+
+    // Starts a movie from the current state of Core, MediaHash comes from HashMediaFile().
+    std::error_code Begin(const std::filesystem::path& Path, const IEmulatorCore& Core, std::uint64_t MediaHash,
+        std::uint32_t PortCount = 2, std::uint32_t KeyframeInterval = DefaultKeyframeInterval);
+
+    // Records the inputs currently set on Core, call it right before each emulated frame.
+    void RecordFrame(const IEmulatorCore& Core);
+
+    std::error_code End();
+
+    [[nodiscard]] bool IsRecording() const { return Stream.is_open(); }
+    [[nodiscard]] std::uint64_t GetFrameCount() const { return FrameIndex; }
+
+private:
+    void BeginRecord(std::uint8_t Type);
+
+    std::ofstream Stream;
+    std::uint32_t PortCount = 0;
+    std::uint32_t KeyframeInterval = DefaultKeyframeInterval;
+    std::uint64_t FrameIndex = 0;
+    std::uint64_t LastRecordFrame = 0;
+    std::array<ControllerInputMask, MaxControllerPorts> LastMasks {};
+
+    std::vector<std::byte> Record;
+    std::vector<std::byte> StateBuffer;
+    std::vector<std::byte> CompressionBuffer;
+};
+
+class InputMoviePlayer
+{
+public:
+    // Maps and indexes the movie.
+    std::error_code Open(const std::filesystem::path& Path);
+    void Close();
+
+    // Checks the media hash (see HashMediaFile()) against the movie and restores the starting state.
+    std::error_code Begin(IEmulatorCore& Core, std::uint64_t CurrentMediaHash);
+
+    // Sets the recorded inputs of the next frame on Core, call it right before emulating the frame.
+    // Returns false once the movie is over, nothing is set then.
+    bool ApplyFrame(IEmulatorCore& Core);
+
+    // Restores the closest keyframe at or before TargetFrame and emulates up to it, so the next frame emulated is
+    // TargetFrame. Turbo seeking drops the picture and audio of those frames and lets the core skip rendering,
+    // which may not be bit exact (see IEmulatorCore::SetRenderingSkipped()): hash comparisons should not use it.
+    std::error_code Seek(IEmulatorCore& Core, std::uint64_t TargetFrame, bool IsTurbo);
+
+    [[nodiscard]] bool IsOpen() const { return File.IsOpen(); }
+    [[nodiscard]] std::uint32_t GetPortCount() const { return PortCount; }
+    [[nodiscard]] std::uint64_t GetFrameCount() const { return FrameCount; }
+    [[nodiscard]] std::uint64_t GetCurrentFrame() const { return CurrentFrame; }
+
+private:
+    struct InputChange
+    {
+        std::uint64_t Frame = 0;
+        std::array<ControllerInputMask, MaxControllerPorts> Masks {};
+    };
+
+    struct Keyframe
+    {
+        std::uint64_t Frame = 0;
+        std::span<const std::byte> Data;
+    };
+
+    std::error_code LoadKeyframe(IEmulatorCore& Core, const Keyframe& Entry);
+
+    MappedFile File;
+    std::uint32_t PortCount = 0;
+    std::uint64_t MediaHash = 0;
+    std::uint64_t FrameCount = 0;
+    std::uint64_t CurrentFrame = 0;
+
+    // The starting state is the keyframe of frame 0.
+    std::vector<Keyframe> Keyframes;
+    std::vector<InputChange> InputChanges;
+
+    std::vector<std::byte> StateBuffer;
+    std::array<float, ControllerInputCount> InputValues {};
+};
@@ -0,0 +1,37 @@
+#include "RunAhead.h"
+
+bool RunAhead::DoFrame(IEmulatorCore& Core)
+{
+    if (FrameCount == 0)
+    {
+        Core.DoFrame();
+        return true;
+    }
+
+    if (StateBuffer.size() < Core.GetStateSize())
+        StateBuffer.resize(Core.GetStateSize());
+
+    const RenderCallback Render = Core.GetRenderCallback();
+    const AudioCallback Audio = Core.GetAudioCallback();
+
+    // The real frame renders normally so the timeline stays exact, only its picture is not handed over.
+    Core.SetRenderCallback(nullptr);
+    Core.DoFrame();
+    Core.SetRenderCallback(Render);
+
+    if (Core.SaveState(StateBuffer) == 0)
+        return false;
+
+    Core.SetAudioCallback(nullptr);
+    Core.SetRenderingSkipped(true);
+
+    for (std::uint32_t Frame = 1; Frame < FrameCount; ++Frame)
+        Core.DoFrame();
+
+    Core.SetRenderingSkipped(false);
+    Core.DoFrame();
+    Core.SetAudioCallback(Audio);
+
+    // The whole buffer is handed back: cores read what they need, and a full-size state avoids any padding copy.
+    return !Core.LoadState(StateBuffer);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CoreWrapper/IEmulatorCore.h"
+
+// Hides the game's own input lag by presenting a frame emulated FrameCount frames in the future.
+// Each call runs the real frame (audio kept, picture dropped), saves the state, runs FrameCount speculative frames
+// with the current input and presents the last one, then restores the real state. The state lives in a buffer
+// allocated once, so the round trip never allocates.
+class RunAhead
+{
+public:
+    static constexpr std::uint32_t MaxFrameCount = 4;
+
+    void SetFrameCount(std::uint32_t NewFrameCount) { FrameCount = NewFrameCount > MaxFrameCount ? MaxFrameCount : NewFrameCount; }
+    [[nodiscard]] std::uint32_t GetFrameCount() const { return FrameCount; }
+
+    // Emulates one real frame through the core's callbacks. Returns false if the state could not be saved or
+    // restored, the real frame has run then but no picture was presented.
+    bool DoFrame(IEmulatorCore& Core);
+
+private:
+    std::uint32_t FrameCount = 0;
+    std::vector<std::byte> StateBuffer;
+};
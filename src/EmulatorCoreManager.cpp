@@ -1,14 +1,31 @@
 #include "EmulatorCoreManager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <tuple>
+#include <utility>
 #include <SDL.h>
 
 #include "ImGuiFileDialog.h"
+#include "InputManager.h"
+#include "SaveStateManager.h"
 #include "UI/ShortcutAndMenuUtils.h"
 #include "UI/UIManager.h"
 #include "Util/Config.h"
+#include "Util/FrameProfiler.h"
+#include "Util/TraceRecorder.h"
+#include "Util/StringUtil.h"
+
+namespace
+{
+    std::uint64_t SteadyClockNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
 
 IMGUI_UTIL_CREATE_MENU_ITEM("File@0->Open@0", ImGuiMod_Ctrl | ImGuiKey_O, "Open a media source for a emulator code.")
 {
@@ -33,12 +50,18 @@ IMGUI_UTIL_CREATE_MENU_ITEM("File@0->Open@0", ImGuiMod_Ctrl | ImGuiKey_O, "Open
     });
 }
 
+IMGUI_UTIL_CREATE_MENU_ITEM("Emulation@1->Reset", ImGuiMod_Ctrl | ImGuiKey_R, "Reset the running emulator core.")
+{
+    EmulatorCoreManager::Get().ResetEmulation(false);
+}
+
 EmulatorCoreManager::EmulatorCoreManager()
 {
 }
 
 EmulatorCoreManager::~EmulatorCoreManager()
 {
+    StopEmulationThread();
 }
 
 void EmulatorCoreManager::StartEmulatorCore(IEmulatorCore* Core)
@@ -52,10 +75,13 @@ void EmulatorCoreManager::StartEmulatorCore(IEmulatorCore* Core)
     {
         CurrentEmulatorCore = Core;
         IEmulatorCore::SetCurrent(CurrentEmulatorCore);
-        CurrentEmulatorLastTick = SDL_GetPerformanceCounter();
+        CurrentEmulatorCore->SetRenderCallback(&PushVideoCallback);
         CurrentEmulatorCore->SetAudioCallback(&PushAudioCallback);
+        CurrentEmulatorCore->SetMediaLoadCallback(&MediaLoadProgressCallback);
         CurrentEmulatorCore->Initialize();
+        Resampler.Reset(CurrentEmulatorCore->GetAudioSampleRate(), AudioSampleRate);
         UIManager::Get().OnEmulationCoreStart(Core);
+        StartEmulationThread();
     }
 }
 
@@ -63,42 +89,208 @@ void EmulatorCoreManager::StopEmulatorCore()
 {
     if (CurrentEmulatorCore != nullptr)
     {
+        StopEmulationThread();
+        IsMediaLoading = false;
+        CurrentMediaPath.clear();
+        CurrentMediaFilter.clear();
+        CurrentMediaHash.reset();
+        MovieRecorder.End();
+        MoviePlayer.Close();
         UIManager::Get().OnEmulationCoreStop();
         CurrentEmulatorCore->Shutdown();
         CurrentEmulatorCore = nullptr;
         IEmulatorCore::SetCurrent(nullptr);
-        CurrentEmulatorLastTick = 0.0;
     }
 }
 
+void EmulatorCoreManager::StartEmulationThread()
+{
+    IsMediaInserted = false;
+    EmulatedFrameCount = 0;
+    VideoFrames.Clear();
+    EmulationThread = std::jthread([this](std::stop_token StopToken) { EmulationThreadMain(StopToken); });
+}
+
+void EmulatorCoreManager::StopEmulationThread()
+{
+    if (EmulationThread.joinable())
+    {
+        EmulationThread.request_stop();
+        CommandSignal.notify_all();
+        EmulationThread.join();
+    }
+
+    // Commands targeting the stopped core are meaningless for the next one.
+    std::scoped_lock Lock(CommandMutex);
+    PendingCommands.clear();
+}
+
+void EmulatorCoreManager::EmulationThreadMain(std::stop_token StopToken)
+{
+    TraceRecorder::SetThreadName("Emulation");
+    TraceRecorder& Tracer = TraceRecorder::Get();
+    EmulationStopToken = StopToken;
+
+    while (!StopToken.stop_requested())
+    {
+        // Nothing can be emulated until a media source is inserted, so sleep until a command arrives.
+        if (!ExecutePendingCommands(StopToken, !IsMediaInserted) || !IsMediaInserted)
+            continue;
+
+        // Scoped to the work of the tick, the wait for the next one below is idle time.
+        {
+            TraceScope TickScope("Emulation Tick");
+            Pacer.SetRefreshRate(CurrentEmulatorCore->GetRefreshUpdate(), SteadyClockNs());
+
+            const bool IsRewinding = IsRewindHeld && IsRewindCaptureEnabled;
+            RunAheadRunner.SetFrameCount(RunAheadFrameCount);
+
+            // Rewinding produces no audio, so the audio queue cannot drive the pacing meanwhile.
+            const double AudioFillRatio = IsRewinding ? -1.0 : GetAudioFillRatio();
+            const std::uint32_t FramesToRun = Pacer.FramesToRun(SteadyClockNs(), AudioFillRatio);
+
+            if (Tracer.IsCapturing())
+            {
+                Tracer.Counter("Audio Fill", AudioFillRatio);
+                Tracer.Counter("Frames Per Tick", FramesToRun);
+                Tracer.Counter("Catch-up Frames", FramesToRun > 1 ? FramesToRun - 1 : 0);
+            }
+
+            for (std::uint32_t FrameCount = FramesToRun; FrameCount > 0; --FrameCount)
+            {
+                if (IsRewinding)
+                {
+                    TraceScope RewindScope("Rewind");
+
+                    // The movie timeline cannot follow the rewind.
+                    MovieRecorder.End();
+                    MoviePlayer.Close();
+                    RewindOneFrame(*CurrentEmulatorCore);
+                    continue;
+                }
+
+                // Sampled as late as possible, a playing movie then overrides it and a recording one records it.
+                InputManager::Get().ApplyToCore(*CurrentEmulatorCore);
+                ProcessMovieFrame(*CurrentEmulatorCore);
+
+                {
+                    ScopedFrameStage EmulateStage(FrameStage::Emulate);
+
+                    // Only the frame that gets presented is worth running ahead, catch-up frames are overwritten anyway.
+                    if (FrameCount == 1)
+                        RunAheadRunner.DoFrame(*CurrentEmulatorCore);
+                    else
+                        CurrentEmulatorCore->DoFrame();
+                }
+
+                ++EmulatedFrameCount;
+
+                TraceScope SnapshotScope("Rewind Snapshot");
+                CaptureRewindSnapshot(*CurrentEmulatorCore);
+            }
+        }
+
+        const std::chrono::nanoseconds WaitTime(Pacer.TimeUntilNextFrameNs(SteadyClockNs()));
+        std::unique_lock Lock(CommandMutex);
+        CommandSignal.wait_for(Lock, StopToken, WaitTime, [this]
+        {
+            return !PendingCommands.empty() || std::exchange(IsHostPresentSignaled, false);
+        });
+    }
+}
+
+bool EmulatorCoreManager::ExecutePendingCommands(std::stop_token StopToken, bool WaitForCommand)
+{
+    std::vector<EmulatorCommand> Commands;
+
+    {
+        std::unique_lock Lock(CommandMutex);
+
+        if (WaitForCommand && !CommandSignal.wait(Lock, StopToken, [this] { return !PendingCommands.empty(); }))
+            return false;
+
+        Commands.swap(PendingCommands);
+    }
+
+    TraceScope CommandScope(Commands.empty() ? nullptr : "Commands");
+
+    for (EmulatorCommand& Command : Commands)
+    {
+        Command(*CurrentEmulatorCore);
+    }
+
+    return true;
+}
+
+void EmulatorCoreManager::PushCommand(EmulatorCommand Command)
+{
+    if (CurrentEmulatorCore == nullptr)
+        return;
+
+    {
+        std::scoped_lock Lock(CommandMutex);
+        PendingCommands.push_back(std::move(Command));
+    }
+
+    CommandSignal.notify_one();
+}
+
+bool EmulatorCoreManager::MediaLoadProgressCallback(float Progress)
+{
+    EmulatorCoreManager& Manager = Get();
+    Manager.MediaLoadProgress.store(Progress, std::memory_order_relaxed);
+    return !Manager.EmulationStopToken.stop_requested();
+}
+
+double EmulatorCoreManager::GetAudioFillRatio() const
+{
+    if (AudioDevice == 0)
+        return -1.0;
+
+    return static_cast<double>(AudioQueue.Size()) / static_cast<double>(AudioQueue.GetCapacity());
+}
+
+void EmulatorCoreManager::PostToUIThread(UIThreadTask Task)
+{
+    std::scoped_lock Lock(UIThreadTaskMutex);
+    PendingUIThreadTasks.push_back(std::move(Task));
+}
+
 bool EmulatorCoreManager::Initialize()
 {
     InitAudio();
+    InitPacing();
+    InitRunAhead();
+    InitRewind();
+    InitMovies();
+    SaveStateManager::Get().Initialize();
     RefreshRecentFiles();
+
+    // Started before the windows are created (see AppFramework), the game loads while the rest of the UI initializes.
+    SaveStateManager::Get().ResumeLastSession();
     return true;
 }
 
 void EmulatorCoreManager::Update()
 {
-    if (CurrentEmulatorCore != nullptr)
+    IsRewindHeld = IsMediaInserted && ImGui::IsKeyDown(ImGuiKey_Backspace) && !ImGui::GetIO().WantTextInput;
+
+    std::vector<UIThreadTask> Tasks;
+
     {
-        const std::uint64_t UpdateInterval = OneSecondFrequency / static_cast<uint64_t>(CurrentEmulatorCore->GetRefreshUpdate());
-        const std::uint64_t CurrentEmulatorTick = SDL_GetPerformanceCounter();
+        std::scoped_lock Lock(UIThreadTaskMutex);
+        Tasks.swap(PendingUIThreadTasks);
+    }
 
-        if (CurrentEmulatorTick < CurrentEmulatorLastTick)
-        {
-            CurrentEmulatorLastTick = CurrentEmulatorTick;
-        }
+    TraceScope TaskScope(Tasks.empty() ? nullptr : "UI Thread Tasks");
 
-        while (CurrentEmulatorTick - CurrentEmulatorLastTick >= UpdateInterval)
-        {
-            CurrentEmulatorLastTick += UpdateInterval;
-            CurrentEmulatorCore->DoFrame();
-        }
+    for (UIThreadTask& Task : Tasks)
+    {
+        Task();
     }
 }
 
-void EmulatorCoreManager::StartEmulationWithMedia(const std::string& FullMediaPath, const std::string& Filter)
+void EmulatorCoreManager::StartEmulationWithMedia(const std::string& FullMediaPath, const std::string& Filter, std::vector<std::byte> InitialState)
 {
     const auto ItCore = std::ranges::find_if(EmulatorCores, [&Filter](const std::unique_ptr<IEmulatorCore>& Core)
     {
@@ -108,46 +300,402 @@ void EmulatorCoreManager::StartEmulationWithMedia(const std::string& FullMediaPa
     if (ItCore != EmulatorCores.end())
     {
         StartEmulatorCore(ItCore->get());
-        using FilePath = std::filesystem::path;
+        MediaLoadProgress = 0.0f;
+        IsMediaLoading = true;
 
-        if (CurrentEmulatorCore != nullptr && CurrentEmulatorCore->InsertMediaSource(FullMediaPath, 0) != std::error_code{})
+        PushCommand([this, FullMediaPath, Filter, InitialState = std::move(InitialState)](IEmulatorCore& Core)
         {
-            StopEmulation();
-        }
-        else
+            Rewind.Clear();
+            MovieRecorder.End();
+            MoviePlayer.Close();
+
+            TraceScope LoadScope("Media Load");
+            const std::error_code Error = Core.InsertMediaSource(FullMediaPath, 0);
+            IsMediaLoading = false;
+
+            // A state that does not load leaves the game booting from scratch, which beats not starting it.
+            if (!Error && !InitialState.empty())
+            {
+                if (const std::error_code StateError = Core.LoadState(InitialState))
+                    std::cerr << "Unable to restore the state of " << FullMediaPath << ": " << StateError.message() << '\n';
+            }
+
+            // Stopped while loading (another media was opened), the outcome belongs to a core that is going away.
+            if (EmulationStopToken.stop_requested())
+                return;
+
+            IsMediaInserted = Error == std::error_code{};
+            Pacer.Reset(Core.GetRefreshUpdate(), SteadyClockNs());
+
+            PostToUIThread([this, Error, FullMediaPath, Filter]()
+            {
+                OnMediaInserted(Error, FullMediaPath, Filter);
+            });
+        });
+    }
+}
+
+void EmulatorCoreManager::OnMediaInserted(std::error_code Error, const std::string& FullMediaPath, const std::string& Filter)
+{
+    if (Error != std::error_code{})
+    {
+        std::cerr << "Unable to load " << FullMediaPath << ": " << Error.message() << '\n';
+        StopEmulation();
+        return;
+    }
+
+    std::vector<std::string> LastOpenFiles;
+    Config::Instance().GetArray("File.RecentFiles", LastOpenFiles);
+    const std::string FullMediaPathAndFilter = FullMediaPath + '|' + Filter;
+
+    if (const auto Itr = std::ranges::find(LastOpenFiles.begin(), LastOpenFiles.end(), FullMediaPathAndFilter); Itr != LastOpenFiles.end())
+        LastOpenFiles.erase(Itr);
+
+    LastOpenFiles.push_back(FullMediaPathAndFilter);
+
+    while (LastOpenFiles.size() > 5)
+        LastOpenFiles.erase(LastOpenFiles.begin());
+
+    CurrentMediaPath = FullMediaPath;
+    CurrentMediaFilter = Filter;
+    CurrentMediaHash.reset();
+
+    // Reads the whole media (up to a CD image), kept off the UI and emulation threads.
+    MediaHashPool.Push([this, FullMediaPath]()
+    {
+        std::uint64_t Hash = 0;
+        const std::error_code Error = HashMediaFile(FullMediaPath, Hash);
+
+        PostToUIThread([this, FullMediaPath, Hash, Error]()
         {
-            std::vector<std::string> LastOpenFiles;
-            Config::Instance().GetArray("File.RecentFiles", LastOpenFiles);
-            const std::string FullMediaPathAndFilter = FullMediaPath + '|' + Filter;
+            if (Error)
+                std::cerr << "Unable to hash " << FullMediaPath << ", movies are disabled: " << Error.message() << '\n';
+            else if (FullMediaPath == CurrentMediaPath)
+                CurrentMediaHash = Hash;
+        });
+    });
+    Config::Instance().SetArray("File.RecentFiles", LastOpenFiles);
 
-            if (const auto Itr = std::ranges::find(LastOpenFiles.begin(), LastOpenFiles.end(), FullMediaPathAndFilter); Itr != LastOpenFiles.end())
-                LastOpenFiles.erase(Itr);
+    // Empty when the media was not picked in the dialog (resumed session, library).
+    if (const std::string DialogPath = ImGuiFileDialog::Instance()->GetCurrentPath(); !DialogPath.empty())
+        Config::Instance().Set("File.LastOpenPath", DialogPath);
 
-            LastOpenFiles.push_back(FullMediaPathAndFilter);
+    UIManager::Get().OnEmulationMediaOpen(0, FullMediaPath);
+    RefreshRecentFiles();
+}
 
-            while (LastOpenFiles.size() > 5)
-                LastOpenFiles.erase(LastOpenFiles.begin());
+void EmulatorCoreManager::StopEmulation()
+{
+    StopEmulatorCore();
+}
 
-            Config::Instance().SetArray("File.RecentFiles", LastOpenFiles);
-            Config::Instance()["File.LastOpenPath"] = ImGuiFileDialog::Instance()->GetCurrentPath();
-            Config::Instance().Save();
+void EmulatorCoreManager::SuspendEmulation()
+{
+    if (CurrentEmulatorCore == nullptr || CurrentMediaPath.empty())
+    {
+        SaveStateManager::Get().ClearResumeSnapshot();
+        StopEmulatorCore();
+        return;
+    }
 
-            UIManager::Get().OnEmulationMediaOpen(0, FullMediaPath);
-            Get().RefreshRecentFiles();
-        }
+    // The core is only read once its thread is joined, so the state matches the last frame handed to the display.
+    StopEmulationThread();
+    SaveStateManager::Get().SaveResumeSnapshot(*CurrentEmulatorCore, CurrentMediaPath, CurrentMediaFilter, VideoFrames.GetLatest());
+    StopEmulatorCore();
+}
+
+void EmulatorCoreManager::ResetEmulation(bool Hard)
+{
+    PushCommand([Hard](IEmulatorCore& Core)
+    {
+        Core.Reset(Hard);
+    });
+}
+
+void EmulatorCoreManager::PlugController(int Port, int Type)
+{
+    PushCommand([Port, Type](IEmulatorCore& Core)
+    {
+        Core.PlugController(Port, Type);
+    });
+}
+
+void EmulatorCoreManager::UnplugController(int Port)
+{
+    PushCommand([Port](IEmulatorCore& Core)
+    {
+        Core.UnplugController(Port);
+    });
+}
+
+void EmulatorCoreManager::PushVideoCallback(const FrameBufferView& View)
+{
+    if (View.Width == 0 || View.Height == 0)
+        return;
+
+    ScopedFrameStage ConvertStage(FrameStage::Convert);
+    EmulatorCoreManager& Manager = Get();
+    VideoFrame& Frame = Manager.VideoFrames.BeginWrite();
+    Frame.Width = View.Width;
+    Frame.Height = View.Height;
+    Frame.Pitch = View.Pitch;
+    Frame.FrameNumber = Manager.EmulatedFrameCount;
+
+    // Keep the core's stride so the visible rows move in one contiguous copy, the texture upload skips the
+    // padding with GL_UNPACK_ROW_LENGTH. The slot buffers only grow, so this never allocates in steady state.
+    const std::uint32_t* FirstPixel = View.Pixels + static_cast<std::size_t>(View.Y) * View.Pitch + View.X;
+    const std::size_t PixelCount = static_cast<std::size_t>(View.Height - 1) * View.Pitch + View.Width;
+    Frame.Pixels.assign(FirstPixel, FirstPixel + PixelCount);
+
+    if (Manager.VideoFrames.Publish())
+        Manager.Pacer.OnFrameDropped();
+}
+
+const VideoFrame* EmulatorCoreManager::AcquireVideoFrame()
+{
+    const VideoFrame* Frame = VideoFrames.Acquire();
+    HasNewFrameForHost |= Frame != nullptr;
+    return Frame;
+}
+
+void EmulatorCoreManager::OnHostPresent()
+{
+    if (CurrentEmulatorCore == nullptr || !IsMediaInserted)
+        return;
+
+    Pacer.OnHostPresent(SteadyClockNs(), std::exchange(HasNewFrameForHost, false));
+
+    {
+        std::scoped_lock Lock(CommandMutex);
+        IsHostPresentSignaled = true;
     }
+
+    CommandSignal.notify_one();
 }
 
-void EmulatorCoreManager::StopEmulation()
+void EmulatorCoreManager::InitPacing()
 {
-    if (CurrentEmulatorCore != nullptr)
+    constexpr std::array<std::tuple<PacingStrategy, const char*, const char*>, 3> PacingMenuItems =
+    {{
+        { PacingStrategy::WallClock, "Wall Clock", "Emulate at the core refresh rate, following the system clock." },
+        { PacingStrategy::AudioClock, "Audio Clock", "Emulate whenever the audio device needs more samples." },
+        { PacingStrategy::VSync, "VSync", "Emulate one frame per display refresh when the rates are close enough." },
+    }};
+
+    for (const auto& [Strategy, Label, Description] : PacingMenuItems)
     {
-        UIManager::Get().OnEmulationCoreStop();
-        CurrentEmulatorCore->Shutdown();
-        CurrentEmulatorCore = nullptr;
-        IEmulatorCore::SetCurrent(nullptr);
-        CurrentEmulatorLastTick = 0.0;
+        ImGuiUtil_AddMenuItem(std::string("Emulation@1->|Pacing@5->") + Label, ImGuiKey_None, Description, [this, Strategy]()
+        {
+            SetPacingStrategy(Strategy);
+        }, &PacingMenuSelection[static_cast<std::size_t>(Strategy)]);
+    }
+
+    std::uint32_t MaxCatchUpFrames = FramePacer::DefaultMaxCatchUpFrames;
+    StringToNumber(Config::Instance().Get("Emulation.MaxCatchUpFrames", ""), MaxCatchUpFrames);
+    Pacer.SetMaxCatchUpFrames(MaxCatchUpFrames);
+
+    SetPacingStrategy(PacingStrategyFromName(Config::Instance().Get("Emulation.Pacing", "")));
+}
+
+void EmulatorCoreManager::SetPacingStrategy(PacingStrategy Strategy)
+{
+    Pacer.SetStrategy(Strategy);
+    Config::Instance().Set("Emulation.Pacing", PacingStrategyName(Strategy));
+
+    for (std::size_t Index = 0; Index < PacingMenuSelection.size(); ++Index)
+        PacingMenuSelection[Index] = Index == static_cast<std::size_t>(Strategy);
+}
+
+void EmulatorCoreManager::InitRunAhead()
+{
+    for (std::uint32_t FrameCount = 0; FrameCount <= RunAhead::MaxFrameCount; ++FrameCount)
+    {
+        const std::string Label = FrameCount == 0 ? "Off" : std::to_string(FrameCount) + (FrameCount == 1 ? " Frame" : " Frames");
+
+        ImGuiUtil_AddMenuItem("Emulation@1->Run-Ahead@5->" + Label + '@' + std::to_string(RunAhead::MaxFrameCount - FrameCount), ImGuiKey_None,
+            "Present a frame emulated ahead of time to hide the game's own input lag, costs one state save and load per frame.", [this, FrameCount]()
+        {
+            SetRunAheadFrameCount(FrameCount);
+        }, &RunAheadMenuSelection[FrameCount]);
     }
+
+    std::uint32_t FrameCount = 0;
+    StringToNumber(Config::Instance().Get("Emulation.RunAheadFrames", ""), FrameCount);
+    SetRunAheadFrameCount(FrameCount);
+}
+
+void EmulatorCoreManager::SetRunAheadFrameCount(std::uint32_t FrameCount)
+{
+    FrameCount = std::min(FrameCount, RunAhead::MaxFrameCount);
+    RunAheadFrameCount = FrameCount;
+    Config::Instance().Set("Emulation.RunAheadFrames", FormatConfigValue(FrameCount));
+
+    for (std::size_t Index = 0; Index < RunAheadMenuSelection.size(); ++Index)
+        RunAheadMenuSelection[Index] = Index == FrameCount;
+}
+
+void EmulatorCoreManager::InitRewind()
+{
+    ImGuiUtil_AddMenuItem("Emulation@1->|Rewind@4", ImGuiKey_None, "Keep a history of the emulation state, hold Backspace to play it backwards.", [this]()
+    {
+        SetRewindEnabled(!IsRewindCaptureEnabled);
+    }, &RewindMenuSelection);
+
+    std::size_t MemoryBudgetMB = RewindBuffer::DefaultMemoryBudget / (1024 * 1024);
+    std::uint32_t KeyframeInterval = RewindBuffer::DefaultKeyframeInterval;
+    StringToNumber(Config::Instance().Get("Rewind.MemoryBudgetMB", ""), MemoryBudgetMB);
+    StringToNumber(Config::Instance().Get("Rewind.KeyframeInterval", ""), KeyframeInterval);
+    StringToNumber(Config::Instance().Get("Rewind.CaptureInterval", ""), RewindCaptureInterval);
+    RewindCaptureInterval = std::max<std::uint32_t>(RewindCaptureInterval, 1);
+    Rewind.Configure(MemoryBudgetMB * 1024 * 1024, KeyframeInterval);
+
+    bool IsEnabled = true;
+    ParseConfigValue(Config::Instance().Get("Rewind.Enabled", ""), IsEnabled);
+    SetRewindEnabled(IsEnabled);
+}
+
+void EmulatorCoreManager::SetRewindEnabled(bool IsEnabled)
+{
+    IsRewindCaptureEnabled = IsEnabled;
+    RewindMenuSelection = IsEnabled;
+    Config::Instance().Set("Rewind.Enabled", FormatConfigValue(IsEnabled));
+}
+
+void EmulatorCoreManager::CaptureRewindSnapshot(IEmulatorCore& Core)
+{
+    if (IsRewindCaptureEnabled && EmulatedFrameCount % RewindCaptureInterval == 0)
+    {
+        std::vector<std::byte> State = Rewind.AcquireBuffer();
+        State.resize(Core.GetStateSize());
+        State.resize(Core.SaveState(std::span<std::byte>(State)));
+        Rewind.Push(std::move(State), EmulatedFrameCount);
+    }
+}
+
+bool EmulatorCoreManager::RewindOneFrame(IEmulatorCore& Core)
+{
+    // Show the frame before the current one: restore the closest snapshot taken before it, then re-simulate up to
+    // it silently. Snapshots are CaptureInterval frames apart, so at most that many frames run per step.
+    if (EmulatedFrameCount < 2)
+        return false;
+
+    const std::uint64_t TargetFrame = EmulatedFrameCount - 1;
+    std::uint64_t SnapshotFrame = 0;
+
+    if (!Rewind.Restore(TargetFrame - 1, RewindState, SnapshotFrame) || Core.LoadState(RewindState))
+        return false;
+
+    EmulatedFrameCount = SnapshotFrame;
+
+    Core.SetAudioCallback(nullptr);
+    Core.SetRenderCallback(nullptr);
+
+    while (EmulatedFrameCount + 1 < TargetFrame)
+    {
+        Core.DoFrame();
+        ++EmulatedFrameCount;
+    }
+
+    Core.SetRenderCallback(&PushVideoCallback);
+    Core.DoFrame();
+    ++EmulatedFrameCount;
+    Core.SetAudioCallback(&PushAudioCallback);
+
+    return true;
+}
+
+void EmulatorCoreManager::InitMovies()
+{
+    ImGuiUtil_AddMenuItem("Emulation@1->|Movie@3->Record@2", ImGuiKey_None, "Record the controller inputs from the current state.", [this]()
+    {
+        StartMovieRecording();
+    });
+
+    ImGuiUtil_AddMenuItem("Emulation@1->Movie@3->Play@1", ImGuiKey_None, "Replay the movie recorded for this media from its starting state.", [this]()
+    {
+        StartMoviePlayback();
+    });
+
+    ImGuiUtil_AddMenuItem("Emulation@1->Movie@3->Stop@0", ImGuiKey_None, "Stop recording or playing the movie.", [this]()
+    {
+        StopMovie();
+    });
+}
+
+std::filesystem::path EmulatorCoreManager::GetMoviePath(const std::string& MediaPath)
+{
+    const std::string FileName = std::filesystem::path(MediaPath).stem().string() + ".upm";
+    return std::filesystem::path(Config::Instance().GetPreferencePath()) / "Movies" / FileName;
+}
+
+void EmulatorCoreManager::StartMovieRecording()
+{
+    if (CurrentMediaPath.empty())
+        return;
+
+    if (!CurrentMediaHash)
+    {
+        std::cerr << "Unable to record a movie: the media is still being hashed\n";
+        return;
+    }
+
+    PushCommand([this, MediaHash = *CurrentMediaHash, Path = GetMoviePath(CurrentMediaPath)](IEmulatorCore& Core)
+    {
+        MoviePlayer.Close();
+
+        if (const std::error_code Error = MovieRecorder.Begin(Path, Core, MediaHash); Error)
+            std::cerr << "Unable to record movie " << Path.string() << ": " << Error.message() << '\n';
+        else
+            std::cout << "Recording movie to " << Path.string() << '\n';
+    });
+}
+
+void EmulatorCoreManager::StartMoviePlayback()
+{
+    if (CurrentMediaPath.empty())
+        return;
+
+    if (!CurrentMediaHash)
+    {
+        std::cerr << "Unable to play a movie: the media is still being hashed\n";
+        return;
+    }
+
+    PushCommand([this, MediaHash = *CurrentMediaHash, Path = GetMoviePath(CurrentMediaPath)](IEmulatorCore& Core)
+    {
+        MovieRecorder.End();
+
+        std::error_code Error = MoviePlayer.Open(Path);
+
+        if (!Error)
+            Error = MoviePlayer.Begin(Core, MediaHash);
+
+        if (Error)
+        {
+            MoviePlayer.Close();
+            std::cerr << "Unable to play movie " << Path.string() << ": " << Error.message() << '\n';
+        }
+    });
+}
+
+void EmulatorCoreManager::StopMovie()
+{
+    PushCommand([this](IEmulatorCore&)
+    {
+        if (MovieRecorder.IsRecording())
+            std::cout << "Movie recorded, " << MovieRecorder.GetFrameCount() << " frames\n";
+
+        MovieRecorder.End();
+        MoviePlayer.Close();
+    });
+}
+
+void EmulatorCoreManager::ProcessMovieFrame(IEmulatorCore& Core)
+{
+    if (MoviePlayer.IsOpen() && !MoviePlayer.ApplyFrame(Core))
+        MoviePlayer.Close();
+
+    MovieRecorder.RecordFrame(Core);
 }
 
 void EmulatorCoreManager::RefreshRecentFiles()
@@ -178,6 +726,8 @@ void EmulatorCoreManager::RefreshRecentFiles()
 
 void EmulatorCoreManager::InitAudio()
 {
+    StringToNumber(Config::Instance().Get("Audio.SampleRate", ""), AudioSampleRate);
+
     SDL_AudioSpec Desired = {};
     Desired.freq = AudioSampleRate;
     Desired.format = AUDIO_S16;
@@ -186,8 +736,9 @@ void EmulatorCoreManager::InitAudio()
     Desired.callback = EmulatorCoreManager::UpdateAudioCallback;
     Desired.userdata = nullptr;
 
-    AudioBuffer.reserve(Desired.samples * Desired.channels * 20);
-    AudioDevice = SDL_OpenAudioDevice(nullptr, 0, &Desired, nullptr, 0);
+    // Any device rate is fine, the resampler converts from the core rate.
+    SDL_AudioSpec Obtained = {};
+    AudioDevice = SDL_OpenAudioDevice(nullptr, 0, &Desired, &Obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
 
     if(!AudioDevice)
     {
@@ -195,6 +746,11 @@ void EmulatorCoreManager::InitAudio()
         return;
     }
 
+    AudioSampleRate = Obtained.freq;
+
+    // Four device buffers: the pacer and the rate control aim at half of it, the rest absorbs emulation hitches.
+    AudioQueue.Reset(static_cast<std::size_t>(Obtained.samples) * Obtained.channels * 4);
+
     SDL_PauseAudioDevice(AudioDevice, 0);
 }
 
@@ -203,29 +759,23 @@ void EmulatorCoreManager::PushAudioCallback(std::uint32_t ChannelCount, std::spa
     if (ChannelCount != 2 || Samples.empty())
         return;
 
-    SDL_LockAudioDevice(Get().AudioDevice);
-    Get().AudioBuffer.insert(Get().AudioBuffer.end(), Samples.begin(), Samples.end());
-    SDL_UnlockAudioDevice(Get().AudioDevice);
+    EmulatorCoreManager& Manager = Get();
+
+    if (Manager.AudioDevice == 0)
+        return;
+
+    // Pushes and pops are whole stereo frames and the capacity is even, so a partial push on overrun never
+    // splits a frame and the channels stay interleaved.
+    Manager.AudioQueue.Push(Manager.Resampler.Process(Samples, Manager.GetAudioFillRatio()));
 }
 
 void EmulatorCoreManager::UpdateAudioCallback(void*, Uint8* Stream, int Length)
 {
-    if (Get().AudioBuffer.size() < Length)
-    {
-        std::memset(Stream, 0, Length);
-    }
-    else
-    {
-        std::memcpy(Stream, Get().AudioBuffer.data(), Length);
-        const std::uint32_t SampleLength = Length / 2;
-        std::uint32_t LengthToRemove = SampleLength;
-        while (Get().AudioBuffer.size() - LengthToRemove >= Length * 2)
-        {
-            LengthToRemove += SampleLength;
-        }
+    const std::span<std::int16_t> Output(reinterpret_cast<std::int16_t*>(Stream), static_cast<std::size_t>(Length) / sizeof(std::int16_t));
 
-        Get().AudioBuffer.erase(Get().AudioBuffer.begin(), Get().AudioBuffer.begin() + static_cast<std::ptrdiff_t>(LengthToRemove));
-    }
+    // On underrun keep what is queued and output silence, the next callback gets a full buffer instead of a click.
+    if (!Get().AudioQueue.PopExact(Output))
+        std::memset(Stream, 0, Length);
 }
 
 void EmulatorCoreManager::DestroyAudio()
@@ -1,12 +1,33 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
 #include <SDL_audio.h>
 #include <SDL_timer.h>
 
 #include "CoreWrapper/GenesisPlusGX.h"
 #include "CoreWrapper/IEmulatorCore.h"
+#include "CoreWrapper/InputMovie.h"
+#include "CoreWrapper/RunAhead.h"
+#include "Util/AudioResampler.h"
+#include "Util/FrameMailbox.h"
+#include "Util/FramePacer.h"
+#include "Util/RewindBuffer.h"
+#include "Util/SpscRingBuffer.h"
+#include "Util/ThreadPool.h"
+
+// Work executed on the emulation thread between two frames.
+using EmulatorCommand = std::function<void(IEmulatorCore& Core)>;
+// Work posted back from the emulation thread, executed on the UI thread during Update().
+using UIThreadTask = std::function<void()>;
 
 class EmulatorCoreManager
 {
@@ -23,12 +44,58 @@ public:
     ~EmulatorCoreManager();
 
     bool Initialize();
+
+    // Called from the UI thread once per host frame, runs the tasks posted by the emulation thread.
     void Update();
 
-    void StartEmulationWithMedia(const std::string& FullMediaPath, const std::string& Filter);
+    // A non-empty InitialState is loaded right after the media, before the first frame.
+    void StartEmulationWithMedia(const std::string& FullMediaPath, const std::string& Filter, std::vector<std::byte> InitialState = {});
     void StopEmulation();
+    // Stops the emulation after saving a snapshot of the running game, which the next launch resumes.
+    void SuspendEmulation();
+    void ResetEmulation(bool Hard);
+    // Changes the device of a port of the running core, as an emulation command. Type is a ControllerType.
+    void PlugController(int Port, int Type);
+    void UnplugController(int Port);
+
+    // Queues a command that will run on the emulation thread before the next emulated frame.
+    void PushCommand(EmulatorCommand Command);
+    // Any thread, the task runs in the next Update().
+    void PostToUIThread(UIThreadTask Task);
+
+    // Latest frame produced by the emulation thread, nullptr if none since the previous call (UI thread only).
+    [[nodiscard]] const VideoFrame* AcquireVideoFrame();
+
+    // Called by the UI thread right after the host swapped its back buffer.
+    void OnHostPresent();
+
+    void SetPacingStrategy(PacingStrategy Strategy);
+    [[nodiscard]] PacingStrategy GetPacingStrategy() const { return Pacer.GetStrategy(); }
+    [[nodiscard]] FramePacingStats GetPacingStats() const { return Pacer.GetStats(); }
+
+    void SetRunAheadFrameCount(std::uint32_t FrameCount);
+    [[nodiscard]] std::uint32_t GetRunAheadFrameCount() const { return RunAheadFrameCount; }
+
+    void SetRewindEnabled(bool IsEnabled);
+    [[nodiscard]] bool IsRewindEnabled() const { return IsRewindCaptureEnabled; }
+    [[nodiscard]] RewindStats GetRewindStats() const { return Rewind.GetStats(); }
+
+    // Movies of the current media live in the preference folder, recording starts from the current state.
+    void StartMovieRecording();
+    void StartMoviePlayback();
+    void StopMovie();
+
+    // Audio queue telemetry, each call starts a new min/max fill level window.
+    [[nodiscard]] RingBufferStats TakeAudioQueueStats() { return AudioQueue.TakeStats(); }
+
+    // Media inserted by StartEmulationWithMedia() is loaded on the emulation thread, the progress is the fraction of
+    // the file being read (the game, then each BIOS file it needs).
+    [[nodiscard]] bool IsLoadingMedia() const { return IsMediaLoading.load(std::memory_order_relaxed); }
+    [[nodiscard]] float GetMediaLoadProgress() const { return MediaLoadProgress.load(std::memory_order_relaxed); }
 
     [[nodiscard]] const IEmulatorCore* CurrentCore() const { return CurrentEmulatorCore; }
+    // Path of the media running in the current core, empty until it is successfully inserted (UI thread only).
+    [[nodiscard]] const std::string& GetCurrentMediaPath() const { return CurrentMediaPath; }
 
 private:
     EmulatorCoreManager();
@@ -36,6 +103,27 @@ private:
     void StartEmulatorCore(IEmulatorCore* Core);
     void StopEmulatorCore();
 
+    void StartEmulationThread();
+    void StopEmulationThread();
+    void EmulationThreadMain(std::stop_token StopToken);
+    bool ExecutePendingCommands(std::stop_token StopToken, bool WaitForCommand);
+    [[nodiscard]] double GetAudioFillRatio() const;
+
+    void InitPacing();
+    void InitRunAhead();
+    void InitRewind();
+    void CaptureRewindSnapshot(IEmulatorCore& Core);
+    bool RewindOneFrame(IEmulatorCore& Core);
+
+    void InitMovies();
+    void ProcessMovieFrame(IEmulatorCore& Core);
+    [[nodiscard]] static std::filesystem::path GetMoviePath(const std::string& MediaPath);
+
+    void OnMediaInserted(std::error_code Error, const std::string& FullMediaPath, const std::string& Filter);
+
+    static void PushVideoCallback(const FrameBufferView& View);
+    static bool MediaLoadProgressCallback(float Progress);
+
     void InitAudio();
     static void PushAudioCallback(std::uint32_t ChannelCount, std::span<std::int16_t> Samples);
     static void UpdateAudioCallback(void*, Uint8* Stream, int Length);
@@ -43,13 +131,58 @@ private:
 
     void RefreshRecentFiles();
 
-    const std::uint64_t OneSecondFrequency = SDL_GetPerformanceFrequency();
-
     IEmulatorCore* CurrentEmulatorCore = nullptr;
-    std::uint64_t CurrentEmulatorLastTick = 0;
+    std::string CurrentMediaPath;
+    std::string CurrentMediaFilter;
+    // Movie identity of the current media, hashed by MediaHashPool after the media is inserted, empty until then.
+    std::optional<std::uint64_t> CurrentMediaHash;
+
+    std::jthread EmulationThread;
+    std::atomic<bool> IsMediaInserted = false;
+    std::atomic<bool> IsMediaLoading = false;
+    std::atomic<float> MediaLoadProgress = 0.0f;
+    // Emulation thread only, lets a long media load give up as soon as the thread is asked to stop.
+    std::stop_token EmulationStopToken;
+    std::uint64_t EmulatedFrameCount = 0;
+
+    std::mutex CommandMutex;
+    std::condition_variable_any CommandSignal;
+    std::vector<EmulatorCommand> PendingCommands;
+    bool IsHostPresentSignaled = false;
+
+    FramePacer Pacer;
+    std::array<bool, 3> PacingMenuSelection = {};
+    bool HasNewFrameForHost = false;
+
+    // Configured from the UI thread, applied by the emulation thread before each frame.
+    std::atomic<std::uint32_t> RunAheadFrameCount = 0;
+    std::array<bool, RunAhead::MaxFrameCount + 1> RunAheadMenuSelection = {};
+    RunAhead RunAheadRunner;
+
+    RewindBuffer Rewind;
+    std::atomic<bool> IsRewindCaptureEnabled = true;
+    std::atomic<bool> IsRewindHeld = false;
+    bool RewindMenuSelection = true;
+    std::uint32_t RewindCaptureInterval = 2;
+    std::vector<std::byte> RewindState;
+
+    // Emulation thread only, at most one of them is active.
+    InputMovieRecorder MovieRecorder;
+    InputMoviePlayer MoviePlayer;
+
+    std::mutex UIThreadTaskMutex;
+    std::vector<UIThreadTask> PendingUIThreadTasks;
+
+    FrameMailbox VideoFrames;
 
     bool UpdateAudio = true;
-    int AudioSampleRate = 48000;
-    std::vector<int16_t> AudioBuffer;
-    SDL_AudioDeviceID AudioDevice;
+    int AudioSampleRate = 48000; // Device rate, may differ from the requested one.
+    // Only touched by the emulation thread once the core is started.
+    AudioResampler Resampler;
+    // Interleaved stereo samples, produced by the emulation thread and consumed by the SDL audio thread.
+    SpscRingBuffer<std::int16_t> AudioQueue;
+    SDL_AudioDeviceID AudioDevice = 0;
+
+    // Last, so its thread stops before the members its tasks post to are destroyed.
+    ThreadPool MediaHashPool { 1 };
 };
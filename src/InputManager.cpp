@@ -0,0 +1,301 @@
+#include "InputManager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "imgui.h"
+
+namespace
+{
+    constexpr float StickDeadZone = 0.25f;
+
+    constexpr std::array<std::pair<SDL_Scancode, ControllerInput>, 12> KeyboardMapping =
+    {{
+        { SDL_SCANCODE_UP, ControllerInput::Up },
+        { SDL_SCANCODE_DOWN, ControllerInput::Down },
+        { SDL_SCANCODE_LEFT, ControllerInput::Left },
+        { SDL_SCANCODE_RIGHT, ControllerInput::Right },
+        { SDL_SCANCODE_A, ControllerInput::A },
+        { SDL_SCANCODE_S, ControllerInput::B },
+        { SDL_SCANCODE_D, ControllerInput::C },
+        { SDL_SCANCODE_Z, ControllerInput::X },
+        { SDL_SCANCODE_X, ControllerInput::Y },
+        { SDL_SCANCODE_C, ControllerInput::Z },
+        { SDL_SCANCODE_F, ControllerInput::Start },
+        { SDL_SCANCODE_V, ControllerInput::Mode },
+    }};
+
+    // Six button pad layout: bottom face buttons are A B C, shoulders and the top face button X Y Z.
+    constexpr std::array<std::pair<SDL_GameControllerButton, ControllerInput>, 12> GameControllerMapping =
+    {{
+        { SDL_CONTROLLER_BUTTON_DPAD_UP, ControllerInput::Up },
+        { SDL_CONTROLLER_BUTTON_DPAD_DOWN, ControllerInput::Down },
+        { SDL_CONTROLLER_BUTTON_DPAD_LEFT, ControllerInput::Left },
+        { SDL_CONTROLLER_BUTTON_DPAD_RIGHT, ControllerInput::Right },
+        { SDL_CONTROLLER_BUTTON_X, ControllerInput::A },
+        { SDL_CONTROLLER_BUTTON_A, ControllerInput::B },
+        { SDL_CONTROLLER_BUTTON_B, ControllerInput::C },
+        { SDL_CONTROLLER_BUTTON_LEFTSHOULDER, ControllerInput::X },
+        { SDL_CONTROLLER_BUTTON_Y, ControllerInput::Y },
+        { SDL_CONTROLLER_BUTTON_RIGHTSHOULDER, ControllerInput::Z },
+        { SDL_CONTROLLER_BUTTON_START, ControllerInput::Start },
+        { SDL_CONTROLLER_BUTTON_BACK, ControllerInput::Mode },
+    }};
+
+    constexpr std::size_t ToIndex(ControllerInput Input)
+    {
+        return static_cast<std::size_t>(Input);
+    }
+
+    float StickValue(std::int16_t Value, bool IsNegativeDirection)
+    {
+        const float Normalized = std::clamp(static_cast<float>(Value) / 32767.0f, -1.0f, 1.0f);
+        const float Magnitude = IsNegativeDirection ? -Normalized : Normalized;
+        return Magnitude > StickDeadZone ? Magnitude : 0.0f;
+    }
+}
+
+void InputManager::ProcessEvent(const SDL_Event& Event)
+{
+    switch (Event.type)
+    {
+    case SDL_KEYDOWN:
+        // Keys typed into a text field are not meant for the game.
+        if (Event.key.repeat == 0 && !ImGui::GetIO().WantTextInput)
+            OnKey(Event.key.keysym.scancode, true);
+        break;
+    case SDL_KEYUP:
+        OnKey(Event.key.keysym.scancode, false);
+        break;
+    case SDL_WINDOWEVENT:
+        // Key releases are not delivered to an unfocused window.
+        if (Event.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
+        {
+            KeyboardValues = {};
+            Publish(KeyboardPort);
+
+            std::scoped_lock Lock(PointerMutex);
+            Pointer.Buttons = 0;
+        }
+        break;
+    case SDL_MOUSEMOTION:
+    {
+        std::scoped_lock Lock(PointerMutex);
+        Pointer.DeltaX += static_cast<float>(Event.motion.xrel);
+        Pointer.DeltaY += static_cast<float>(Event.motion.yrel);
+        break;
+    }
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        OnMouseButton(Event.button.button, Event.type == SDL_MOUSEBUTTONDOWN);
+        break;
+    case SDL_CONTROLLERDEVICEADDED:
+        OnControllerAdded(Event.cdevice.which);
+        break;
+    case SDL_CONTROLLERDEVICEREMOVED:
+        OnControllerRemoved(Event.cdevice.which);
+        break;
+    case SDL_CONTROLLERBUTTONDOWN:
+    case SDL_CONTROLLERBUTTONUP:
+        OnControllerButton(Event.cbutton.which, Event.cbutton.button, Event.type == SDL_CONTROLLERBUTTONDOWN);
+        break;
+    case SDL_CONTROLLERAXISMOTION:
+        OnControllerAxis(Event.caxis.which, Event.caxis.axis, Event.caxis.value);
+        break;
+    default:
+        break;
+    }
+}
+
+void InputManager::Shutdown()
+{
+    for (GameControllerState& State : Controllers)
+        SDL_GameControllerClose(State.Controller);
+
+    Controllers.clear();
+    KeyboardValues = {};
+
+    for (int Port = 0; Port < MaxControllerPorts; ++Port)
+        Publish(Port);
+
+    std::scoped_lock Lock(PointerMutex);
+    Pointer = {};
+}
+
+void InputManager::ApplyToCore(IEmulatorCore& Core)
+{
+    InputValues Values;
+
+    for (int Port = 0; Port < MaxControllerPorts; ++Port)
+    {
+        const PortSnapshot& Snapshot = Snapshots[Port];
+        std::uint32_t Sequence = 0;
+
+        do
+        {
+            Sequence = Snapshot.Sequence.load(std::memory_order_acquire);
+
+            for (std::size_t Input = 0; Input < Values.size(); ++Input)
+                Values[Input] = Snapshot.Values[Input].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        while ((Sequence & 1) != 0 || Sequence != Snapshot.Sequence.load(std::memory_order_relaxed));
+
+        Core.SetControllerInputValues(Port, Values);
+    }
+
+    PointerInput Motion;
+
+    {
+        std::scoped_lock Lock(PointerMutex);
+        Motion = Pointer;
+        Pointer.DeltaX = 0.0f;
+        Pointer.DeltaY = 0.0f;
+    }
+
+    Core.SetPointerInput(KeyboardPort, Motion);
+}
+
+void InputManager::OnKey(SDL_Scancode Scancode, bool IsPressed)
+{
+    const auto Mapping = std::ranges::find(KeyboardMapping, Scancode, &std::pair<SDL_Scancode, ControllerInput>::first);
+
+    if (Mapping == KeyboardMapping.end())
+        return;
+
+    KeyboardValues[ToIndex(Mapping->second)] = IsPressed ? 1.0f : 0.0f;
+    Publish(KeyboardPort);
+}
+
+void InputManager::OnControllerAdded(int DeviceIndex)
+{
+    SDL_GameController* Controller = SDL_GameControllerOpen(DeviceIndex);
+
+    if (Controller == nullptr)
+    {
+        std::cerr << "Unable to open game controller " << DeviceIndex << ": " << SDL_GetError() << '\n';
+        return;
+    }
+
+    const SDL_JoystickID InstanceId = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(Controller));
+
+    // Already announced, SDL may report a controller connected at startup twice.
+    if (FindController(InstanceId) != nullptr)
+    {
+        SDL_GameControllerClose(Controller);
+        return;
+    }
+
+    int Port = 0;
+
+    while (Port < MaxControllerPorts - 1 && std::ranges::any_of(Controllers, [Port](const GameControllerState& State) { return State.Port == Port; }))
+        ++Port;
+
+    Controllers.push_back({ Controller, InstanceId, Port, {}, {} });
+    std::cout << "Game controller \"" << SDL_GameControllerName(Controller) << "\" connected to port " << (Port + 1) << '\n';
+}
+
+void InputManager::OnControllerRemoved(SDL_JoystickID InstanceId)
+{
+    const auto State = std::ranges::find(Controllers, InstanceId, &GameControllerState::InstanceId);
+
+    if (State == Controllers.end())
+        return;
+
+    const int Port = State->Port;
+    SDL_GameControllerClose(State->Controller);
+    Controllers.erase(State);
+    Publish(Port);
+}
+
+void InputManager::OnControllerButton(SDL_JoystickID InstanceId, std::uint8_t Button, bool IsPressed)
+{
+    GameControllerState* State = FindController(InstanceId);
+    const auto Mapping = std::ranges::find(GameControllerMapping, static_cast<SDL_GameControllerButton>(Button), &std::pair<SDL_GameControllerButton, ControllerInput>::first);
+
+    if (State == nullptr || Mapping == GameControllerMapping.end())
+        return;
+
+    State->Values[ToIndex(Mapping->second)] = IsPressed ? 1.0f : 0.0f;
+    Publish(State->Port);
+}
+
+void InputManager::OnControllerAxis(SDL_JoystickID InstanceId, std::uint8_t Axis, std::int16_t Value)
+{
+    GameControllerState* State = FindController(InstanceId);
+
+    if (State == nullptr)
+        return;
+
+    // The left stick doubles the d-pad. Kept apart from it so a stick at rest does not release a held direction,
+    // Publish() hands the core whichever of the two is pushed further.
+    if (Axis == SDL_CONTROLLER_AXIS_LEFTX)
+    {
+        State->StickValues[ToIndex(ControllerInput::Left)] = StickValue(Value, true);
+        State->StickValues[ToIndex(ControllerInput::Right)] = StickValue(Value, false);
+    }
+    else if (Axis == SDL_CONTROLLER_AXIS_LEFTY)
+    {
+        State->StickValues[ToIndex(ControllerInput::Up)] = StickValue(Value, true);
+        State->StickValues[ToIndex(ControllerInput::Down)] = StickValue(Value, false);
+    }
+    else
+    {
+        return;
+    }
+
+    Publish(State->Port);
+}
+
+void InputManager::OnMouseButton(std::uint8_t Button, bool IsPressed)
+{
+    PointerButton Mapped;
+
+    switch (Button)
+    {
+    case SDL_BUTTON_LEFT: Mapped = PointerButton::Left; break;
+    case SDL_BUTTON_RIGHT: Mapped = PointerButton::Right; break;
+    case SDL_BUTTON_MIDDLE: Mapped = PointerButton::Middle; break;
+    default: return;
+    }
+
+    std::scoped_lock Lock(PointerMutex);
+
+    if (IsPressed)
+        Pointer.Buttons |= static_cast<std::uint32_t>(Mapped);
+    else
+        Pointer.Buttons &= ~static_cast<std::uint32_t>(Mapped);
+}
+
+InputManager::GameControllerState* InputManager::FindController(SDL_JoystickID InstanceId)
+{
+    const auto State = std::ranges::find(Controllers, InstanceId, &GameControllerState::InstanceId);
+    return State != Controllers.end() ? &*State : nullptr;
+}
+
+void InputManager::Publish(int Port)
+{
+    InputValues Values = Port == KeyboardPort ? KeyboardValues : InputValues {};
+
+    for (const GameControllerState& State : Controllers)
+    {
+        if (State.Port != Port)
+            continue;
+
+        for (std::size_t Input = 0; Input < Values.size(); ++Input)
+            Values[Input] = std::max({ Values[Input], State.Values[Input], State.StickValues[Input] });
+    }
+
+    PortSnapshot& Snapshot = Snapshots[Port];
+    const std::uint32_t Sequence = Snapshot.Sequence.load(std::memory_order_relaxed);
+
+    Snapshot.Sequence.store(Sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t Input = 0; Input < Values.size(); ++Input)
+        Snapshot.Values[Input].store(Values[Input], std::memory_order_relaxed);
+
+    Snapshot.Sequence.store(Sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <SDL.h>
+
+#include "CoreWrapper/IEmulatorCore.h"
+
+// Turns SDL keyboard and game controller events into per-port controller snapshots.
+// The UI thread processes the events and publishes a new snapshot of a port whenever one of its inputs changes, the
+// emulation thread copies the latest snapshots into the core right before each frame, the latest point before the
+// core polls them. Everything reaches the core through IEmulatorCore::SetControllerInputValues(), so movies record
+// and replay it like any other input. The mouse drives the pointer of the keyboard's port, for the light guns, mice
+// and tablets the core emulates.
+class InputManager
+{
+public:
+    static InputManager& Get() { static InputManager Instance; return Instance; }
+
+    InputManager(const InputManager&) = delete;
+    InputManager& operator=(const InputManager&) = delete;
+
+    // UI thread. Game controllers connected before startup are announced by SDL as added devices too.
+    void ProcessEvent(const SDL_Event& Event);
+    void Shutdown();
+
+    // Emulation thread, right before a frame.
+    void ApplyToCore(IEmulatorCore& Core);
+
+private:
+    // The keyboard drives the first port, game controllers take the first port without one in connection order,
+    // so the first game controller shares the keyboard's port.
+    static constexpr int KeyboardPort = 0;
+
+    using InputValues = std::array<float, ControllerInputCount>;
+
+    struct GameControllerState
+    {
+        SDL_GameController* Controller = nullptr;
+        SDL_JoystickID InstanceId = -1;
+        int Port = 0;
+        InputValues Values {};      // Buttons and d-pad.
+        InputValues StickValues {}; // Left stick, as directions.
+    };
+
+    // Sequence lock: odd while the UI thread writes the values, the reader retries until it sees the same even value
+    // before and after copying them.
+    struct alignas(64) PortSnapshot
+    {
+        std::atomic<std::uint32_t> Sequence = 0;
+        std::array<std::atomic<float>, ControllerInputCount> Values {};
+    };
+
+    InputManager() = default;
+
+    void OnKey(SDL_Scancode Scancode, bool IsPressed);
+    void OnControllerAdded(int DeviceIndex);
+    void OnControllerRemoved(SDL_JoystickID InstanceId);
+    void OnControllerButton(SDL_JoystickID InstanceId, std::uint8_t Button, bool IsPressed);
+    void OnControllerAxis(SDL_JoystickID InstanceId, std::uint8_t Axis, std::int16_t Value);
+    void OnMouseButton(std::uint8_t Button, bool IsPressed);
+    GameControllerState* FindController(SDL_JoystickID InstanceId);
+    void Publish(int Port);
+
+    std::array<PortSnapshot, MaxControllerPorts> Snapshots;
+
+    // Motion accumulates until the emulation thread takes it.
+    std::mutex PointerMutex;
+    PointerInput Pointer;
+
+    // UI thread only.
+    InputValues KeyboardValues {};
+    std::vector<GameControllerState> Controllers;
+};
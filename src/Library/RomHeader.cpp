@@ -0,0 +1,194 @@
+#include "RomHeader.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    constexpr std::size_t SmdHeaderSize = 512;
+    constexpr std::size_t SmdBlockSize = 16 * 1024;
+
+    std::string_view ReadField(std::span<const std::byte> Data, std::size_t Offset, std::size_t Size)
+    {
+        return { reinterpret_cast<const char*>(Data.data()) + Offset, Size };
+    }
+
+    // Header text is space padded and some games align words with runs of spaces. Non printable bytes (Japanese
+    // titles in Shift JIS) make the field unusable as a title.
+    std::string CleanHeaderText(std::string_view Field)
+    {
+        std::string Text;
+
+        for (const char Character : Field)
+        {
+            if (Character < 0x20 || Character > 0x7E)
+                return {};
+
+            if (Character != ' ' || (!Text.empty() && Text.back() != ' '))
+                Text += Character;
+        }
+
+        while (!Text.empty() && Text.back() == ' ')
+            Text.pop_back();
+
+        return Text;
+    }
+
+    std::uint8_t ParseMegaDriveRegions(std::string_view Field)
+    {
+        std::uint8_t Regions = 0;
+
+        for (const char Character : Field)
+        {
+            if (Character == 'J')
+                Regions |= RomRegion_Japan;
+            else if (Character == 'U')
+                Regions |= RomRegion_Americas;
+            else if (Character == 'E')
+                Regions |= RomRegion_Europe;
+        }
+
+        // Newer games use a single hexadecimal digit: bit 0 Japan, bit 2 Americas, bit 3 Europe.
+        if (Regions == 0 && !Field.empty())
+        {
+            const char Digit = Field[0];
+            const int Value = Digit >= '0' && Digit <= '9' ? Digit - '0' : Digit >= 'A' && Digit <= 'F' ? Digit - 'A' + 10 : 0;
+
+            if (Value & 1)
+                Regions |= RomRegion_Japan;
+            if (Value & 4)
+                Regions |= RomRegion_Americas;
+            if (Value & 8)
+                Regions |= RomRegion_Europe;
+        }
+
+        return Regions;
+    }
+
+    bool ParseMegaDriveHeader(std::span<const std::byte> Data, RomHeaderInfo& Info)
+    {
+        if (Data.size() < 0x200)
+            return false;
+
+        const std::string_view Console = ReadField(Data, 0x100, 16);
+
+        if (!Console.starts_with("SEGA") && !Console.starts_with(" SEGA"))
+            return false;
+
+        Info.System = RomSystem::MegaDrive;
+        Info.Title = CleanHeaderText(ReadField(Data, 0x150, 48));
+
+        if (Info.Title.empty())
+            Info.Title = CleanHeaderText(ReadField(Data, 0x120, 48));
+
+        Info.ProductCode = CleanHeaderText(ReadField(Data, 0x180, 14));
+        Info.Checksum = static_cast<std::uint16_t>((std::to_integer<std::uint16_t>(Data[0x18E]) << 8) | std::to_integer<std::uint16_t>(Data[0x18F]));
+        Info.Regions = ParseMegaDriveRegions(ReadField(Data, 0x1F0, 3));
+        return true;
+    }
+
+    bool ParseSegaMasterSystemHeader(std::span<const std::byte> Data, RomHeaderInfo& Info)
+    {
+        for (const std::size_t Offset : { 0x7FF0, 0x3FF0, 0x1FF0 })
+        {
+            if (Data.size() < Offset + 16 || ReadField(Data, Offset, 8) != "TMR SEGA")
+                continue;
+
+            const std::uint8_t ProductLow = std::to_integer<std::uint8_t>(Data[Offset + 12]);
+            const std::uint8_t ProductMiddle = std::to_integer<std::uint8_t>(Data[Offset + 13]);
+            const std::uint8_t ProductHigh = std::to_integer<std::uint8_t>(Data[Offset + 14]) >> 4;
+            const std::uint8_t RegionCode = std::to_integer<std::uint8_t>(Data[Offset + 15]) >> 4;
+
+            // Binary coded decimal, the high nibble of the third byte adds ten thousands.
+            const unsigned ProductCode = ProductHigh * 10000u + (ProductMiddle >> 4) * 1000u + (ProductMiddle & 0xF) * 100u
+                + (ProductLow >> 4) * 10u + (ProductLow & 0xF);
+
+            Info.System = RegionCode >= 5 ? RomSystem::GameGear : RomSystem::MasterSystem;
+            Info.Regions = RegionCode == 3 || RegionCode == 5 ? RomRegion_Japan
+                : RegionCode == 4 || RegionCode == 6 ? RomRegion_Americas | RomRegion_Europe
+                : RegionCode == 7 ? RomRegion_Japan | RomRegion_Americas | RomRegion_Europe : 0;
+            Info.Checksum = static_cast<std::uint16_t>(std::to_integer<std::uint16_t>(Data[Offset + 10]) | (std::to_integer<std::uint16_t>(Data[Offset + 11]) << 8));
+            Info.ProductCode = ProductCode != 0 ? std::to_string(ProductCode) : std::string();
+            return true;
+        }
+
+        return false;
+    }
+
+    RomSystem SystemFromExtension(std::string_view Extension)
+    {
+        if (Extension.starts_with('.'))
+            Extension.remove_prefix(1);
+
+        auto Is = [Extension](std::string_view Expected)
+        {
+            return Extension.size() == Expected.size() && std::equal(Extension.begin(), Extension.end(), Expected.begin(),
+                [](char Left, char Right) { return (Left | 0x20) == Right; });
+        };
+
+        if (Is("md") || Is("gen") || Is("smd") || Is("bin") || Is("mdx"))
+            return RomSystem::MegaDrive;
+        if (Is("sms"))
+            return RomSystem::MasterSystem;
+        if (Is("gg"))
+            return RomSystem::GameGear;
+        if (Is("sg"))
+            return RomSystem::SG1000;
+
+        return RomSystem::Unknown;
+    }
+}
+
+RomHeaderInfo ParseRomHeader(std::span<const std::byte> Data, std::string_view Extension)
+{
+    RomHeaderInfo Info;
+
+    if (ParseMegaDriveHeader(Data, Info) || ParseSegaMasterSystemHeader(Data, Info))
+        return Info;
+
+    // Super Magic Drive dumps: a 512 byte copier header, then 16 KB blocks holding the odd bytes before the even ones.
+    if (Data.size() >= SmdHeaderSize + SmdBlockSize)
+    {
+        std::array<std::byte, SmdBlockSize> Block;
+        const std::byte* Interleaved = Data.data() + SmdHeaderSize;
+
+        for (std::size_t Index = 0; Index < SmdBlockSize / 2; ++Index)
+        {
+            Block[Index * 2 + 0] = Interleaved[SmdBlockSize / 2 + Index];
+            Block[Index * 2 + 1] = Interleaved[Index];
+        }
+
+        if (ParseMegaDriveHeader(Block, Info))
+            return Info;
+    }
+
+    Info.System = SystemFromExtension(Extension);
+    return Info;
+}
+
+std::string_view RomSystemName(RomSystem System)
+{
+    switch (System)
+    {
+        case RomSystem::MegaDrive: return "Mega Drive";
+        case RomSystem::MasterSystem: return "Master System";
+        case RomSystem::GameGear: return "Game Gear";
+        case RomSystem::SG1000: return "SG-1000";
+        default: return "Unknown";
+    }
+}
+
+std::string RomRegionsToString(std::uint8_t Regions)
+{
+    std::string Text;
+
+    if (Regions & RomRegion_Japan)
+        Text += 'J';
+    if (Regions & RomRegion_Americas)
+        Text += 'U';
+    if (Regions & RomRegion_Europe)
+        Text += 'E';
+
+    return Text;
+}
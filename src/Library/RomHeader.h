@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+enum class RomSystem : std::uint8_t
+{
+    Unknown,
+    MegaDrive,
+    MasterSystem,
+    GameGear,
+    SG1000,
+};
+
+// Bit mask of the regions a game supports.
+enum RomRegion : std::uint8_t
+{
+    RomRegion_Japan = 1 << 0,
+    RomRegion_Americas = 1 << 1,
+    RomRegion_Europe = 1 << 2,
+};
+
+struct RomHeaderInfo
+{
+    RomSystem System = RomSystem::Unknown;
+    std::uint8_t Regions = 0;
+    std::uint16_t Checksum = 0; // As stored in the header, not verified.
+    std::string Title;          // Empty when the header has none (Master System and Game Gear).
+    std::string ProductCode;
+};
+
+// Bytes ParseRomHeader() needs from the start of the ROM to find every header it knows about.
+constexpr std::size_t RomHeaderScanSize = 0x8000;
+
+// Mega Drive header at 0x100, Master System / Game Gear "TMR SEGA" header at 0x7FF0 (or 0x3FF0, 0x1FF0 for small
+// ROMs). The extension (with or without the dot) picks the system when the ROM has no recognizable header.
+[[nodiscard]] RomHeaderInfo ParseRomHeader(std::span<const std::byte> Data, std::string_view Extension);
+
+[[nodiscard]] std::string_view RomSystemName(RomSystem System);
+// Short form such as "JUE", empty when no region is known.
+[[nodiscard]] std::string RomRegionsToString(std::uint8_t Regions);
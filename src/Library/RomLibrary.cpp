@@ -0,0 +1,455 @@
+#include "RomLibrary.h"
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <zlib.h>
+
+#include "CoreWrapper/GenesisPlusGXFileIO.h"
+#include "Util/Config.h"
+#include "Util/MappedFile.h"
+#include "Util/StateFile.h"
+#include "Util/ThreadPool.h"
+
+extern "C"
+{
+    #include "unzip.h"
+}
+
+namespace
+{
+    constexpr std::size_t HashChunkSize = 1024 * 1024;
+
+    char ToLowerAscii(char Character)
+    {
+        return Character >= 'A' && Character <= 'Z' ? static_cast<char>(Character | 0x20) : Character;
+    }
+
+    constexpr std::array<char, 4> IndexMagic = { 'U', 'L', 'I', 'B' };
+    constexpr std::uint32_t IndexVersion = 1;
+
+    // The index is a header, the fixed size records, then the strings they point into. It is a local cache written
+    // in host byte order, a file of another version or another machine is simply rebuilt.
+    struct IndexHeader
+    {
+        std::array<char, 4> Magic;
+        std::uint32_t Version;
+        std::uint32_t EntryCount;
+        std::uint32_t StringTableSize;
+    };
+
+    struct IndexRecord
+    {
+        std::uint64_t FileSize;
+        std::int64_t ModifiedTime;
+        std::uint64_t RomSize;
+        std::uint32_t Crc32;
+        std::uint8_t Sha1[20];
+        std::uint32_t PathOffset;
+        std::uint32_t PathSize;
+        std::uint32_t TitleOffset;
+        std::uint32_t TitleSize;
+        std::uint32_t ProductCodeOffset;
+        std::uint32_t ProductCodeSize;
+        std::uint16_t HeaderChecksum;
+        std::uint8_t System;
+        std::uint8_t Regions;
+        std::uint8_t Reserved[4];
+    };
+
+    static_assert(sizeof(IndexHeader) == 16 && sizeof(IndexRecord) == 80, "Index records must not have implicit padding");
+
+    // Feeds both hashes and keeps the start of the ROM for the header parser.
+    struct RomHasher
+    {
+        std::uint32_t Crc32 = static_cast<std::uint32_t>(crc32(0, nullptr, 0));
+        Sha1 Sha1Hash;
+        std::uint64_t Size = 0;
+        std::vector<std::byte> HeaderBytes;
+
+        void Update(std::span<const std::byte> Data)
+        {
+            if (HeaderBytes.size() < RomHeaderScanSize)
+            {
+                const std::size_t Count = std::min(Data.size(), RomHeaderScanSize - HeaderBytes.size());
+                HeaderBytes.insert(HeaderBytes.end(), Data.begin(), Data.begin() + static_cast<std::ptrdiff_t>(Count));
+            }
+
+            Crc32 = static_cast<std::uint32_t>(crc32(Crc32, reinterpret_cast<const Bytef*>(Data.data()), static_cast<uInt>(Data.size())));
+            Sha1Hash.Update(Data);
+            Size += Data.size();
+        }
+    };
+
+    // Like the loader (see GenesisPlusGXFileIO.cpp), an archive stands for its first file.
+    bool HashZipArchive(const std::filesystem::path& Path, RomHasher& Hasher, std::string& FileName)
+    {
+        unzFile Archive = unzOpen(Path.c_str());
+
+        if (Archive == nullptr)
+            return false;
+
+        unz_file_info Info = {};
+        char EntryName[256] = {};
+        bool IsValid = false;
+
+        if (unzGoToFirstFile(Archive) == UNZ_OK && unzGetCurrentFileInfo(Archive, &Info, EntryName, sizeof(EntryName), nullptr, 0, nullptr, 0) == UNZ_OK &&
+            Info.uncompressed_size <= RomLibrary::MaxRomFileSize && unzOpenCurrentFile(Archive) == UNZ_OK)
+        {
+            std::vector<std::byte> Chunk(HashChunkSize);
+            int Count = 0;
+
+            while ((Count = unzReadCurrentFile(Archive, Chunk.data(), static_cast<unsigned>(Chunk.size()))) > 0)
+                Hasher.Update({ Chunk.data(), static_cast<std::size_t>(Count) });
+
+            // Closing checks the CRC stored in the archive against the data read.
+            IsValid = unzCloseCurrentFile(Archive) == UNZ_OK && Count == 0;
+            FileName = EntryName;
+        }
+
+        unzClose(Archive);
+        return IsValid;
+    }
+
+    template<typename Type>
+    void AppendBytes(std::vector<std::byte>& Output, const Type& Value)
+    {
+        const std::byte* Bytes = reinterpret_cast<const std::byte*>(&Value);
+        Output.insert(Output.end(), Bytes, Bytes + sizeof(Type));
+    }
+
+    bool CompareTitles(const RomEntry& Left, const RomEntry& Right)
+    {
+        const std::weak_ordering Order = std::lexicographical_compare_three_way(Left.Title.begin(), Left.Title.end(), Right.Title.begin(), Right.Title.end(),
+            [](char A, char B) { return ToLowerAscii(A) <=> ToLowerAscii(B); });
+
+        return Order != 0 ? Order < 0 : Left.Path < Right.Path;
+    }
+}
+
+std::filesystem::path RomLibrary::DefaultIndexPath()
+{
+    return std::filesystem::path(Config::Instance().GetPreferencePath()) / "Library.idx";
+}
+
+RomLibrary::RomLibrary(std::filesystem::path IndexPath)
+    : IndexPath(std::move(IndexPath))
+    , Entries(std::make_shared<const std::vector<RomEntry>>())
+{
+}
+
+RomLibrary::~RomLibrary()
+{
+    CancelScan();
+}
+
+std::error_code RomLibrary::LoadIndex()
+{
+    MappedFile File;
+
+    if (const std::error_code Error = File.Open(IndexPath); Error)
+        return Error;
+
+    const std::span<const std::byte> Data = File.Data();
+    IndexHeader Header;
+
+    if (Data.size() < sizeof(Header))
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+
+    std::memcpy(&Header, Data.data(), sizeof(Header));
+
+    if (Header.Magic != IndexMagic || Header.Version != IndexVersion)
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+
+    const std::uint64_t RecordsSize = static_cast<std::uint64_t>(Header.EntryCount) * sizeof(IndexRecord);
+
+    if (Data.size() != sizeof(Header) + RecordsSize + Header.StringTableSize)
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+
+    const char* Strings = reinterpret_cast<const char*>(Data.data() + sizeof(Header) + RecordsSize);
+    std::vector<RomEntry> LoadedEntries(Header.EntryCount);
+
+    auto ReadString = [&Header, Strings](std::uint32_t Offset, std::uint32_t Size, std::string& Output)
+    {
+        if (static_cast<std::uint64_t>(Offset) + Size > Header.StringTableSize)
+            return false;
+
+        Output.assign(Strings + Offset, Size);
+        return true;
+    };
+
+    for (std::uint32_t Index = 0; Index < Header.EntryCount; ++Index)
+    {
+        IndexRecord Record;
+        std::memcpy(&Record, Data.data() + sizeof(Header) + Index * sizeof(IndexRecord), sizeof(Record));
+
+        RomEntry& Entry = LoadedEntries[Index];
+
+        if (!ReadString(Record.PathOffset, Record.PathSize, Entry.Path) || !ReadString(Record.TitleOffset, Record.TitleSize, Entry.Title) ||
+            !ReadString(Record.ProductCodeOffset, Record.ProductCodeSize, Entry.ProductCode) || Record.System > static_cast<std::uint8_t>(RomSystem::SG1000))
+            return std::make_error_code(std::errc::illegal_byte_sequence);
+
+        Entry.FileSize = Record.FileSize;
+        Entry.ModifiedTime = Record.ModifiedTime;
+        Entry.RomSize = Record.RomSize;
+        Entry.Crc32 = Record.Crc32;
+        std::memcpy(Entry.Sha1.data(), Record.Sha1, Entry.Sha1.size());
+        Entry.System = static_cast<RomSystem>(Record.System);
+        Entry.Regions = Record.Regions;
+        Entry.HeaderChecksum = Record.HeaderChecksum;
+    }
+
+    PublishEntries(std::move(LoadedEntries));
+    return {};
+}
+
+std::error_code RomLibrary::SaveIndex(const std::vector<RomEntry>& SavedEntries) const
+{
+    std::vector<std::byte> Records;
+    std::vector<std::byte> Strings;
+    Records.reserve(SavedEntries.size() * sizeof(IndexRecord));
+
+    auto AddString = [&Strings](const std::string& Value, std::uint32_t& Offset, std::uint32_t& Size)
+    {
+        Offset = static_cast<std::uint32_t>(Strings.size());
+        Size = static_cast<std::uint32_t>(Value.size());
+        const std::byte* Bytes = reinterpret_cast<const std::byte*>(Value.data());
+        Strings.insert(Strings.end(), Bytes, Bytes + Value.size());
+    };
+
+    for (const RomEntry& Entry : SavedEntries)
+    {
+        IndexRecord Record = {};
+        Record.FileSize = Entry.FileSize;
+        Record.ModifiedTime = Entry.ModifiedTime;
+        Record.RomSize = Entry.RomSize;
+        Record.Crc32 = Entry.Crc32;
+        std::memcpy(Record.Sha1, Entry.Sha1.data(), Entry.Sha1.size());
+        AddString(Entry.Path, Record.PathOffset, Record.PathSize);
+        AddString(Entry.Title, Record.TitleOffset, Record.TitleSize);
+        AddString(Entry.ProductCode, Record.ProductCodeOffset, Record.ProductCodeSize);
+        Record.HeaderChecksum = Entry.HeaderChecksum;
+        Record.System = static_cast<std::uint8_t>(Entry.System);
+        Record.Regions = Entry.Regions;
+        AppendBytes(Records, Record);
+    }
+
+    const IndexHeader Header = { IndexMagic, IndexVersion, static_cast<std::uint32_t>(SavedEntries.size()), static_cast<std::uint32_t>(Strings.size()) };
+
+    std::vector<std::byte> Output;
+    Output.reserve(sizeof(Header) + Records.size() + Strings.size());
+    AppendBytes(Output, Header);
+    Output.insert(Output.end(), Records.begin(), Records.end());
+    Output.insert(Output.end(), Strings.begin(), Strings.end());
+
+    return WriteFileAtomically(IndexPath, Output);
+}
+
+void RomLibrary::StartScan(std::vector<std::filesystem::path> Folders)
+{
+    CancelScan();
+
+    FilesFound = 0;
+    FilesToHash = 0;
+    FilesHashed = 0;
+    IsScanRunning = true;
+    ScanThread = std::jthread([this, Folders = std::move(Folders)](std::stop_token StopToken) mutable { ScanMain(StopToken, std::move(Folders)); });
+}
+
+void RomLibrary::CancelScan()
+{
+    if (ScanThread.joinable())
+    {
+        ScanThread.request_stop();
+        ScanThread.join();
+    }
+
+    IsScanRunning = false;
+}
+
+RomLibraryProgress RomLibrary::GetProgress() const
+{
+    return { IsScanRunning.load(std::memory_order_relaxed), FilesFound.load(std::memory_order_relaxed),
+        FilesToHash.load(std::memory_order_relaxed), FilesHashed.load(std::memory_order_relaxed) };
+}
+
+std::shared_ptr<const std::vector<RomEntry>> RomLibrary::GetEntries() const
+{
+    std::scoped_lock Lock(EntriesMutex);
+    return Entries;
+}
+
+bool RomLibrary::IsRomExtension(const std::filesystem::path& Path)
+{
+    std::string Extension = Path.extension().string();
+    std::ranges::transform(Extension, Extension.begin(), ToLowerAscii);
+
+    constexpr std::array<std::string_view, 9> RomExtensions = { ".md", ".gen", ".bin", ".smd", ".mdx", ".sms", ".gg", ".sg", ".zip" };
+    return std::ranges::find(RomExtensions, Extension) != RomExtensions.end();
+}
+
+std::optional<RomEntry> RomLibrary::IndexFile(const std::filesystem::path& Path, std::int64_t ModifiedTime)
+{
+    RomHasher Hasher;
+    RomEntry Entry;
+    std::string RomFileName = Path.filename().string();
+
+    {
+        MappedFile File;
+
+        if (File.Open(Path))
+            return std::nullopt;
+
+        const std::span<const std::byte> Data = File.Data();
+        Entry.FileSize = Data.size();
+
+        if (IsZipArchive(Data))
+        {
+            File.Close();
+
+            if (!HashZipArchive(Path, Hasher, RomFileName))
+                return std::nullopt;
+        }
+        else
+        {
+            File.AdviseSequentialRead();
+
+            for (std::size_t Offset = 0; Offset < Data.size(); Offset += HashChunkSize)
+                Hasher.Update(Data.subspan(Offset, std::min(HashChunkSize, Data.size() - Offset)));
+        }
+    }
+
+    const RomHeaderInfo Header = ParseRomHeader(Hasher.HeaderBytes, std::filesystem::path(RomFileName).extension().string());
+
+    Entry.Path = Path.string();
+    Entry.Title = Header.Title.empty() ? Path.stem().string() : Header.Title;
+    Entry.ProductCode = Header.ProductCode;
+    Entry.ModifiedTime = ModifiedTime;
+    Entry.RomSize = Hasher.Size;
+    Entry.Crc32 = Hasher.Crc32;
+    Entry.Sha1 = Hasher.Sha1Hash.Finish();
+    Entry.System = Header.System;
+    Entry.Regions = Header.Regions;
+    Entry.HeaderChecksum = Header.Checksum;
+    return Entry;
+}
+
+void RomLibrary::ScanMain(std::stop_token StopToken, std::vector<std::filesystem::path> Folders)
+{
+    struct FoundFile
+    {
+        std::filesystem::path Path;
+        std::uint64_t Size;
+        std::int64_t ModifiedTime;
+    };
+
+    std::vector<FoundFile> Files;
+
+    for (const std::filesystem::path& Folder : Folders)
+    {
+        std::error_code Error;
+        std::filesystem::recursive_directory_iterator Iterator(Folder, std::filesystem::directory_options::skip_permission_denied, Error);
+
+        // Unreadable entries are skipped, the walk goes on with the next one.
+        for (; !Error && Iterator != std::filesystem::recursive_directory_iterator(); Iterator.increment(Error))
+        {
+            if (StopToken.stop_requested())
+                return;
+
+            const std::filesystem::directory_entry& Entry = *Iterator;
+            std::error_code EntryError;
+
+            if (!Entry.is_regular_file(EntryError) || !IsRomExtension(Entry.path()))
+                continue;
+
+            const std::uint64_t Size = Entry.file_size(EntryError);
+            const std::filesystem::file_time_type ModifiedTime = Entry.last_write_time(EntryError);
+
+            if (EntryError || Size == 0 || Size > MaxRomFileSize)
+                continue;
+
+            Files.push_back({ Entry.path(), Size, static_cast<std::int64_t>(ModifiedTime.time_since_epoch().count()) });
+            FilesFound.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (Error)
+            std::cerr << "Library: unable to scan " << Folder.string() << ": " << Error.message() << '\n';
+    }
+
+    // Overlapping folders would list the same file twice.
+    std::ranges::sort(Files, {}, &FoundFile::Path);
+    Files.erase(std::ranges::unique(Files, {}, &FoundFile::Path).begin(), Files.end());
+    FilesFound = static_cast<std::uint32_t>(Files.size());
+
+    const std::shared_ptr<const std::vector<RomEntry>> PreviousEntries = GetEntries();
+    std::unordered_map<std::string_view, const RomEntry*> PreviousByPath;
+
+    for (const RomEntry& Entry : *PreviousEntries)
+        PreviousByPath.emplace(Entry.Path, &Entry);
+
+    // Files which fail to index keep an empty path and are dropped once the pool is done.
+    std::vector<RomEntry> ScannedEntries(Files.size());
+    std::vector<std::size_t> ChangedFiles;
+
+    for (std::size_t Index = 0; Index < Files.size(); ++Index)
+    {
+        const auto Previous = PreviousByPath.find(Files[Index].Path.native());
+
+        if (Previous != PreviousByPath.end() && Previous->second->FileSize == Files[Index].Size && Previous->second->ModifiedTime == Files[Index].ModifiedTime)
+            ScannedEntries[Index] = *Previous->second;
+        else
+            ChangedFiles.push_back(Index);
+    }
+
+    FilesToHash = static_cast<std::uint32_t>(ChangedFiles.size());
+
+    if (!ChangedFiles.empty())
+    {
+        ThreadPool Pool;
+
+        for (const std::size_t Index : ChangedFiles)
+        {
+            Pool.Push([this, &StopToken, &Files, &ScannedEntries, Index]()
+            {
+                if (StopToken.stop_requested())
+                    return;
+
+                if (std::optional<RomEntry> Entry = IndexFile(Files[Index].Path, Files[Index].ModifiedTime))
+                    ScannedEntries[Index] = std::move(*Entry);
+
+                FilesHashed.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+
+        Pool.Wait();
+    }
+
+    if (StopToken.stop_requested())
+        return;
+
+    std::erase_if(ScannedEntries, [](const RomEntry& Entry) { return Entry.Path.empty(); });
+
+    const bool IsChanged = !ChangedFiles.empty() || ScannedEntries.size() != PreviousEntries->size();
+    std::ranges::sort(ScannedEntries, CompareTitles);
+
+    if (IsChanged)
+    {
+        if (const std::error_code Error = SaveIndex(ScannedEntries); Error)
+            std::cerr << "Library: unable to write " << IndexPath.string() << ": " << Error.message() << '\n';
+    }
+
+    PublishEntries(std::move(ScannedEntries));
+    IsScanRunning = false;
+}
+
+void RomLibrary::PublishEntries(std::vector<RomEntry>&& NewEntries)
+{
+    std::shared_ptr<const std::vector<RomEntry>> Published = std::make_shared<const std::vector<RomEntry>>(std::move(NewEntries));
+
+    std::scoped_lock Lock(EntriesMutex);
+    Entries = std::move(Published);
+}
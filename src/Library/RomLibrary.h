@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "Library/RomHeader.h"
+#include "Util/Sha1.h"
+
+struct RomEntry
+{
+    std::string Path;
+    std::string Title; // From the header, the file name without extension when the header has none.
+    std::string ProductCode;
+    std::uint64_t FileSize = 0;
+    std::int64_t ModifiedTime = 0; // std::filesystem::file_time_type ticks.
+    std::uint64_t RomSize = 0;     // Differs from FileSize for archives.
+    std::uint32_t Crc32 = 0;
+    Sha1Digest Sha1 = {};
+    RomSystem System = RomSystem::Unknown;
+    std::uint8_t Regions = 0;
+    std::uint16_t HeaderChecksum = 0;
+};
+
+struct RomLibraryProgress
+{
+    bool IsScanning = false;
+    std::uint32_t FilesFound = 0;
+    std::uint32_t FilesToHash = 0; // Files new or changed since the index was written.
+    std::uint32_t FilesHashed = 0;
+};
+
+// ROMs found in a set of folders, with their hashes and header information.
+// Scans run in the background: the folders are walked, files whose size and modification time match the index are
+// kept as they are and the others are hashed (CRC32 and SHA-1, archives through their first file like the loader)
+// on a thread pool. The result replaces the entries at once and is written to a compact binary index, which the
+// next launch reads back in a few milliseconds instead of hashing the library again.
+class RomLibrary
+{
+public:
+    // Same limit as the core's MAXROMSIZE, anything larger is a disc image or not a ROM.
+    static constexpr std::uint64_t MaxRomFileSize = 32 * 1024 * 1024;
+
+    // Library.idx in the preference folder, shared by the library window and the headless thumbnail generator.
+    [[nodiscard]] static std::filesystem::path DefaultIndexPath();
+
+    explicit RomLibrary(std::filesystem::path IndexPath);
+    ~RomLibrary();
+
+    RomLibrary(const RomLibrary&) = delete;
+    RomLibrary& operator=(const RomLibrary&) = delete;
+
+    // Replaces the entries with the ones of the index file.
+    std::error_code LoadIndex();
+
+    // Walks the folders recursively, restarting the scan in progress if any.
+    void StartScan(std::vector<std::filesystem::path> Folders);
+    void CancelScan();
+    [[nodiscard]] RomLibraryProgress GetProgress() const;
+
+    // Any thread. Sorted by title, replaced as a whole when a scan completes.
+    [[nodiscard]] std::shared_ptr<const std::vector<RomEntry>> GetEntries() const;
+
+    [[nodiscard]] static bool IsRomExtension(const std::filesystem::path& Path);
+    // Hashes the file and parses its header, nullopt if it cannot be read.
+    [[nodiscard]] static std::optional<RomEntry> IndexFile(const std::filesystem::path& Path, std::int64_t ModifiedTime);
+
+private:
+    void ScanMain(std::stop_token StopToken, std::vector<std::filesystem::path> Folders);
+    void PublishEntries(std::vector<RomEntry>&& Entries);
+    [[nodiscard]] std::error_code SaveIndex(const std::vector<RomEntry>& Entries) const;
+
+    std::filesystem::path IndexPath;
+
+    mutable std::mutex EntriesMutex;
+    std::shared_ptr<const std::vector<RomEntry>> Entries;
+
+    std::atomic<bool> IsScanRunning = false;
+    std::atomic<std::uint32_t> FilesFound = 0;
+    std::atomic<std::uint32_t> FilesToHash = 0;
+    std::atomic<std::uint32_t> FilesHashed = 0;
+
+    std::jthread ScanThread;
+};
@@ -0,0 +1,201 @@
+#include "ThumbnailAtlas.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "Util/Config.h"
+#include "Util/StateFile.h"
+
+namespace
+{
+    constexpr std::array<char, 4> AtlasMagic = { 'U', 'T', 'H', 'A' };
+    constexpr std::uint32_t AtlasVersion = 1;
+
+    // Pixels start on their own page, the header is rewritten in place once the keys are known.
+    constexpr std::uint64_t PixelsOffset = 4096;
+    constexpr std::uint64_t ThumbnailSize = ThumbnailPixelCount * sizeof(std::uint16_t);
+
+    struct AtlasHeader
+    {
+        std::array<char, 4> Magic;
+        std::uint32_t Version;
+        std::uint32_t Width;
+        std::uint32_t Height;
+        std::uint32_t SlotCount;
+        std::uint32_t KeyCount; // Lower than SlotCount when duplicates were dropped.
+        std::uint64_t KeysOffset;
+    };
+
+    static_assert(sizeof(AtlasHeader) == 32 && sizeof(ThumbnailAtlasKey) == 24, "Atlas records must not have implicit padding");
+    static_assert(ThumbnailSize % alignof(ThumbnailAtlasKey) == 0, "Keys must stay aligned after the pixels");
+
+    bool CompareKeys(const ThumbnailAtlasKey& Left, const ThumbnailAtlasKey& Right)
+    {
+        return Left.Sha1 < Right.Sha1;
+    }
+
+    std::uint16_t ToRgb565(std::uint32_t Red, std::uint32_t Green, std::uint32_t Blue)
+    {
+        return static_cast<std::uint16_t>((Red >> 3) << 11 | (Green >> 2) << 5 | Blue >> 3);
+    }
+}
+
+void DownscaleToThumbnail(const FrameBufferView& Frame, std::span<std::uint16_t, ThumbnailPixelCount> Output)
+{
+    for (std::uint32_t Y = 0; Y < ThumbnailHeight; ++Y)
+    {
+        const std::uint32_t FirstRow = Y * Frame.Height / ThumbnailHeight;
+        const std::uint32_t LastRow = std::max((Y + 1) * Frame.Height / ThumbnailHeight, FirstRow + 1);
+
+        for (std::uint32_t X = 0; X < ThumbnailWidth; ++X)
+        {
+            const std::uint32_t FirstColumn = X * Frame.Width / ThumbnailWidth;
+            const std::uint32_t LastColumn = std::max((X + 1) * Frame.Width / ThumbnailWidth, FirstColumn + 1);
+            std::uint32_t Red = 0;
+            std::uint32_t Green = 0;
+            std::uint32_t Blue = 0;
+
+            for (std::uint32_t Row = FirstRow; Row < LastRow; ++Row)
+            {
+                const std::uint32_t* Pixels = Frame.Pixels + static_cast<std::size_t>(Frame.Y + Row) * Frame.Pitch + Frame.X;
+
+                for (std::uint32_t Column = FirstColumn; Column < LastColumn; ++Column)
+                {
+                    Red += Pixels[Column] >> 16 & 0xFF;
+                    Green += Pixels[Column] >> 8 & 0xFF;
+                    Blue += Pixels[Column] & 0xFF;
+                }
+            }
+
+            const std::uint32_t Count = (LastRow - FirstRow) * (LastColumn - FirstColumn);
+            Output[Y * ThumbnailWidth + X] = ToRgb565(Red / Count, Green / Count, Blue / Count);
+        }
+    }
+}
+
+std::filesystem::path ThumbnailAtlas::DefaultPath()
+{
+    return std::filesystem::path(Config::Instance().GetPreferencePath()) / "Thumbnails.atlas";
+}
+
+std::error_code ThumbnailAtlas::Open(const std::filesystem::path& Path)
+{
+    Close();
+
+    if (const std::error_code Error = File.Open(Path); Error)
+        return Error;
+
+    const std::span<const std::byte> Data = File.Data();
+    AtlasHeader Header;
+
+    if (Data.size() < PixelsOffset)
+    {
+        Close();
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+    }
+
+    std::memcpy(&Header, Data.data(), sizeof(Header));
+
+    if (Header.Magic != AtlasMagic || Header.Version != AtlasVersion || Header.Width != ThumbnailWidth || Header.Height != ThumbnailHeight ||
+        Header.KeyCount > Header.SlotCount || Header.KeysOffset != PixelsOffset + Header.SlotCount * ThumbnailSize ||
+        Data.size() != Header.KeysOffset + Header.KeyCount * sizeof(ThumbnailAtlasKey))
+    {
+        Close();
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+    }
+
+    // Nothing else is read here: the pages of a thumbnail are only faulted in when it is displayed.
+    Pixels = reinterpret_cast<const std::uint16_t*>(Data.data() + PixelsOffset);
+    Keys = { reinterpret_cast<const ThumbnailAtlasKey*>(Data.data() + Header.KeysOffset), Header.KeyCount };
+    SlotCount = Header.SlotCount;
+    return {};
+}
+
+void ThumbnailAtlas::Close()
+{
+    File.Close();
+    Keys = {};
+    Pixels = nullptr;
+    SlotCount = 0;
+}
+
+ThumbnailPixels ThumbnailAtlas::GetPixels(std::uint32_t Slot) const
+{
+    return ThumbnailPixels(Pixels + static_cast<std::size_t>(Slot) * ThumbnailPixelCount, ThumbnailPixelCount);
+}
+
+const std::uint16_t* ThumbnailAtlas::Find(const Sha1Digest& Sha1) const
+{
+    const auto Key = std::ranges::lower_bound(Keys, Sha1, {}, &ThumbnailAtlasKey::Sha1);
+
+    if (Key == Keys.end() || Key->Sha1 != Sha1 || Key->Slot >= SlotCount)
+        return nullptr;
+
+    return GetPixels(Key->Slot).data();
+}
+
+std::error_code ThumbnailAtlasWriter::Begin(const std::filesystem::path& AtlasPath)
+{
+    std::error_code Error;
+
+    Path = AtlasPath;
+    TemporaryPath = AtlasPath;
+    TemporaryPath += ".tmp";
+    Keys.clear();
+    SlotCount = 0;
+
+    if (Path.has_parent_path())
+    {
+        std::filesystem::create_directories(Path.parent_path(), Error);
+        if (Error)
+            return Error;
+    }
+
+    // The header is only valid once Finish() rewrote it, an interrupted run leaves an unreadable temporary file.
+    const std::array<char, PixelsOffset> Placeholder = {};
+
+    Stream.open(TemporaryPath, std::ios::binary | std::ios::trunc);
+    Stream.write(Placeholder.data(), Placeholder.size());
+
+    return Stream ? std::error_code() : std::make_error_code(std::errc::io_error);
+}
+
+void ThumbnailAtlasWriter::Add(const Sha1Digest& Sha1, ThumbnailPixels Pixels)
+{
+    Stream.write(reinterpret_cast<const char*>(Pixels.data()), ThumbnailSize);
+    Keys.push_back({ Sha1, SlotCount++ });
+}
+
+std::error_code ThumbnailAtlasWriter::Finish()
+{
+    // Identical dumps in several folders share one thumbnail, the first one added wins.
+    std::ranges::stable_sort(Keys, &CompareKeys);
+    const auto Duplicates = std::ranges::unique(Keys, {}, &ThumbnailAtlasKey::Sha1);
+    Keys.erase(Duplicates.begin(), Duplicates.end());
+
+    const AtlasHeader Header = { AtlasMagic, AtlasVersion, ThumbnailWidth, ThumbnailHeight, SlotCount, static_cast<std::uint32_t>(Keys.size()),
+        PixelsOffset + SlotCount * ThumbnailSize };
+
+    Stream.write(reinterpret_cast<const char*>(Keys.data()), static_cast<std::streamsize>(Keys.size() * sizeof(ThumbnailAtlasKey)));
+    Stream.seekp(0);
+    Stream.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+    Stream.close();
+
+    std::error_code Error;
+
+    if (!Stream)
+    {
+        std::filesystem::remove(TemporaryPath, Error);
+        return std::make_error_code(std::errc::io_error);
+    }
+
+    if (const std::error_code SyncError = SyncFile(TemporaryPath))
+    {
+        std::filesystem::remove(TemporaryPath, Error);
+        return SyncError;
+    }
+
+    std::filesystem::rename(TemporaryPath, Path, Error);
+    return Error;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "CoreWrapper/IEmulatorCore.h"
+#include "Util/MappedFile.h"
+#include "Util/Sha1.h"
+
+// A Mega Drive frame (320x224) scaled by 0.4, other systems are stretched to the same size.
+constexpr std::uint32_t ThumbnailWidth = 128;
+constexpr std::uint32_t ThumbnailHeight = 90;
+constexpr std::size_t ThumbnailPixelCount = ThumbnailWidth * ThumbnailHeight;
+
+// RGB565, the layout OpenGL takes as GL_RGB / GL_UNSIGNED_SHORT_5_6_5, so a thumbnail is uploaded straight from the
+// atlas mapping.
+using ThumbnailPixels = std::span<const std::uint16_t, ThumbnailPixelCount>;
+
+// Exit code of the thumbnail generator when it wrote the atlas but some ROMs got no thumbnail.
+constexpr int ThumbnailGeneratorPartialExitCode = 4;
+
+// Box filtered downscale of the visible part of a frame.
+void DownscaleToThumbnail(const FrameBufferView& Frame, std::span<std::uint16_t, ThumbnailPixelCount> Output);
+
+struct ThumbnailAtlasKey
+{
+    Sha1Digest Sha1;   // Of the ROM, see RomEntry.
+    std::uint32_t Slot;
+};
+
+// Thumbnails of the library in one file, read through a memory mapping: only the pages of the thumbnails looked up
+// are ever read from the disk. Written by Ultipugna-headless --thumbnails (see tools/Headless/Thumbnails.h).
+//
+// Layout, host byte order like the library index: a header, the pixels of every thumbnail from offset 4096, then the
+// keys sorted by SHA-1.
+class ThumbnailAtlas
+{
+public:
+    [[nodiscard]] static std::filesystem::path DefaultPath();
+
+    std::error_code Open(const std::filesystem::path& Path);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return File.IsOpen(); }
+    [[nodiscard]] std::span<const ThumbnailAtlasKey> GetKeys() const { return Keys; }
+    [[nodiscard]] ThumbnailPixels GetPixels(std::uint32_t Slot) const;
+
+    // Pixels of the ROM, nullptr when it has no thumbnail. Valid until the atlas is closed.
+    [[nodiscard]] const std::uint16_t* Find(const Sha1Digest& Sha1) const;
+
+private:
+    MappedFile File;
+    std::span<const ThumbnailAtlasKey> Keys;
+    const std::uint16_t* Pixels = nullptr;
+    std::uint32_t SlotCount = 0;
+};
+
+// Streams the thumbnails into a temporary file as they are added, Finish() writes the keys and replaces the atlas.
+class ThumbnailAtlasWriter
+{
+public:
+    std::error_code Begin(const std::filesystem::path& Path);
+    void Add(const Sha1Digest& Sha1, ThumbnailPixels Pixels);
+    std::error_code Finish();
+
+    [[nodiscard]] std::uint32_t GetCount() const { return SlotCount; }
+
+private:
+    std::filesystem::path Path;
+    std::filesystem::path TemporaryPath;
+    std::ofstream Stream;
+    std::vector<ThumbnailAtlasKey> Keys;
+    std::uint32_t SlotCount = 0;
+};
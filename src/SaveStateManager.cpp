@@ -0,0 +1,290 @@
+#include "SaveStateManager.h"
+
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "EmulatorCoreManager.h"
+#include "Library/ThumbnailAtlas.h"
+#include "UI/ShortcutAndMenuUtils.h"
+#include "Util/Config.h"
+#include "Util/MappedFile.h"
+#include "Util/StateFile.h"
+#include "Util/TraceRecorder.h"
+
+namespace
+{
+    constexpr std::array<char, 4> ResumeMagic = { 'U', 'R', 'E', 'S' };
+    constexpr std::uint32_t ResumeVersion = 1;
+
+    // Followed by the media path, the filter, the thumbnail (ThumbnailPixelCount RGB565 pixels, or none when
+    // ThumbnailSize is 0) and the compressed state. Host byte order, like the other files of the preference folder.
+    struct ResumeHeader
+    {
+        std::array<char, 4> Magic;
+        std::uint32_t Version;
+        std::uint32_t MediaPathSize;
+        std::uint32_t FilterSize;
+        std::uint32_t ThumbnailSize;
+        std::uint32_t Reserved;
+        std::uint64_t StateSize;
+    };
+
+    static_assert(sizeof(ResumeHeader) == 32, "Resume header must not have implicit padding");
+
+    template<typename Type>
+    void AppendBytes(std::vector<std::byte>& Output, const Type* Data, std::size_t Count)
+    {
+        const std::byte* Bytes = reinterpret_cast<const std::byte*>(Data);
+        Output.insert(Output.end(), Bytes, Bytes + Count * sizeof(Type));
+    }
+}
+
+SaveStateManager::~SaveStateManager()
+{
+    if (IOThread.joinable())
+    {
+        IOThread.request_stop();
+        IOJobSignal.notify_all();
+        IOThread.join();
+    }
+}
+
+void SaveStateManager::Initialize()
+{
+    if (IOThread.joinable())
+        return;
+
+    IOThread = std::jthread([this](std::stop_token StopToken) { IOThreadMain(StopToken); });
+
+    for (int Slot = 1; Slot <= SlotCount; ++Slot)
+    {
+        const ImGuiKey SlotKey = static_cast<ImGuiKey>(ImGuiKey_F1 + Slot - 1);
+        const std::string SlotName = "Slot " + std::to_string(Slot) + '@' + std::to_string(SlotCount - Slot);
+
+        ImGuiUtil_AddMenuItem("Emulation@1->|Save State@6->" + SlotName, ImGuiMod_Shift | SlotKey, "Save the emulation state to this slot.", [this, Slot]()
+        {
+            SaveSlot(Slot);
+        });
+
+        ImGuiUtil_AddMenuItem("Emulation@1->Load State@6->" + SlotName, SlotKey, "Restore the emulation state saved in this slot.", [this, Slot]()
+        {
+            LoadSlot(Slot);
+        });
+    }
+}
+
+std::filesystem::path SaveStateManager::GetSlotPath(const std::string& MediaPath, int Slot)
+{
+    const std::string FileName = std::filesystem::path(MediaPath).stem().string() + ".slot" + std::to_string(Slot) + ".zst";
+    return std::filesystem::path(Config::Instance().GetPreferencePath()) / "States" / FileName;
+}
+
+void SaveStateManager::SaveSlot(int Slot)
+{
+    const std::string& MediaPath = EmulatorCoreManager::Get().GetCurrentMediaPath();
+    if (MediaPath.empty())
+        return;
+
+    EmulatorCoreManager::Get().PushCommand([this, Slot, Path = GetSlotPath(MediaPath, Slot)](IEmulatorCore& Core)
+    {
+        std::vector<std::byte> State = Core.SaveState();
+        if (State.empty())
+            return;
+
+        PushIOJob([this, Slot, Path, State = std::move(State)]()
+        {
+            std::error_code Error = CompressState(State, CompressionBuffer);
+
+            if (!Error)
+                Error = WriteFileAtomically(Path, CompressionBuffer);
+
+            if (Error)
+                std::cerr << "Unable to save state slot " << Slot << ": " << Error.message() << '\n';
+            else
+                std::cout << "State saved to slot " << Slot << " (" << State.size() << " -> " << CompressionBuffer.size() << " bytes)\n";
+        });
+    });
+}
+
+void SaveStateManager::LoadSlot(int Slot)
+{
+    const std::string& MediaPath = EmulatorCoreManager::Get().GetCurrentMediaPath();
+    if (MediaPath.empty())
+        return;
+
+    PushIOJob([Slot, MediaPath, Path = GetSlotPath(MediaPath, Slot)]()
+    {
+        std::vector<std::byte> State;
+
+        if (const std::error_code Error = ReadStateFile(Path, State); Error)
+        {
+            std::cerr << "Unable to read state slot " << Slot << ": " << Error.message() << '\n';
+            return;
+        }
+
+        // The current core and media belong to the UI thread, which also drops a state read for a media since closed.
+        EmulatorCoreManager::Get().PostToUIThread([Slot, MediaPath, State = std::move(State)]() mutable
+        {
+            if (EmulatorCoreManager::Get().GetCurrentMediaPath() != MediaPath)
+                return;
+
+            EmulatorCoreManager::Get().PushCommand([Slot, State = std::move(State)](IEmulatorCore& Core)
+            {
+                if (const std::error_code Error = Core.LoadState(State); Error)
+                    std::cerr << "Unable to load state slot " << Slot << ": " << Error.message() << '\n';
+            });
+        });
+    });
+}
+
+std::filesystem::path SaveStateManager::GetResumePath()
+{
+    return std::filesystem::path(Config::Instance().GetPreferencePath()) / "States" / "Resume.snap";
+}
+
+void SaveStateManager::SaveResumeSnapshot(const IEmulatorCore& Core, const std::string& MediaPath, const std::string& Filter, const VideoFrame* LastFrame)
+{
+    std::vector<std::byte> State = Core.SaveState();
+
+    if (State.empty())
+    {
+        ClearResumeSnapshot();
+        return;
+    }
+
+    std::vector<std::uint16_t> Thumbnail;
+
+    if (LastFrame != nullptr && LastFrame->Width != 0 && LastFrame->Height != 0)
+    {
+        Thumbnail.resize(ThumbnailPixelCount);
+        DownscaleToThumbnail({ LastFrame->Pixels.data(), LastFrame->Pitch, 0, 0, LastFrame->Width, LastFrame->Height }, std::span<std::uint16_t, ThumbnailPixelCount>(Thumbnail));
+    }
+
+    // Still written if the app quits right after, pending jobs are run before the I/O thread stops.
+    PushIOJob([this, MediaPath, Filter, State = std::move(State), Thumbnail = std::move(Thumbnail)]()
+    {
+        std::error_code Error = CompressState(State, CompressionBuffer);
+
+        if (!Error)
+        {
+            const ResumeHeader Header = { ResumeMagic, ResumeVersion, static_cast<std::uint32_t>(MediaPath.size()), static_cast<std::uint32_t>(Filter.size()),
+                static_cast<std::uint32_t>(Thumbnail.size()), 0, CompressionBuffer.size() };
+
+            std::vector<std::byte> Output;
+            AppendBytes(Output, &Header, 1);
+            AppendBytes(Output, MediaPath.data(), MediaPath.size());
+            AppendBytes(Output, Filter.data(), Filter.size());
+            AppendBytes(Output, Thumbnail.data(), Thumbnail.size());
+            AppendBytes(Output, CompressionBuffer.data(), CompressionBuffer.size());
+
+            Error = WriteFileAtomically(GetResumePath(), Output);
+        }
+
+        if (Error)
+            std::cerr << "Unable to save the resume snapshot: " << Error.message() << '\n';
+    });
+}
+
+void SaveStateManager::ClearResumeSnapshot()
+{
+    PushIOJob([]()
+    {
+        std::error_code Error;
+        std::filesystem::remove(GetResumePath(), Error);
+    });
+}
+
+bool SaveStateManager::ResumeLastSession()
+{
+    TraceScope ResumeScope("Resume Last Session");
+
+    const std::filesystem::path Path = GetResumePath();
+    MappedFile File;
+
+    if (File.Open(Path))
+        return false;
+
+    const std::span<const std::byte> Data = File.Data();
+    ResumeHeader Header;
+    bool IsValid = Data.size() >= sizeof(Header);
+
+    if (IsValid)
+    {
+        std::memcpy(&Header, Data.data(), sizeof(Header));
+
+        IsValid = Header.Magic == ResumeMagic && Header.Version == ResumeVersion && (Header.ThumbnailSize == 0 || Header.ThumbnailSize == ThumbnailPixelCount) &&
+            Data.size() == sizeof(Header) + static_cast<std::uint64_t>(Header.MediaPathSize) + Header.FilterSize + Header.ThumbnailSize * sizeof(std::uint16_t) + Header.StateSize;
+    }
+
+    std::string MediaPath;
+    std::string Filter;
+    std::vector<std::byte> State;
+
+    if (IsValid)
+    {
+        const char* Strings = reinterpret_cast<const char*>(Data.data() + sizeof(Header));
+        MediaPath.assign(Strings, Header.MediaPathSize);
+        Filter.assign(Strings + Header.MediaPathSize, Header.FilterSize);
+
+        const std::span<const std::byte> Thumbnail = Data.subspan(sizeof(Header) + Header.MediaPathSize + Header.FilterSize, Header.ThumbnailSize * sizeof(std::uint16_t));
+        ResumeThumbnail.resize(Header.ThumbnailSize);
+        std::memcpy(ResumeThumbnail.data(), Thumbnail.data(), Thumbnail.size());
+
+        // Decompressed straight from the mapping.
+        IsValid = !DecompressState(Data.last(Header.StateSize), State);
+    }
+
+    File.Close();
+
+    std::error_code Error;
+    std::filesystem::remove(Path, Error);
+
+    if (!IsValid)
+    {
+        ResumeThumbnail.clear();
+        std::cerr << "Resume snapshot ignored, the file is invalid\n";
+        return false;
+    }
+
+    std::cout << "Resuming " << MediaPath << '\n';
+    EmulatorCoreManager::Get().StartEmulationWithMedia(MediaPath, Filter, std::move(State));
+    return true;
+}
+
+void SaveStateManager::PushIOJob(IOJob Job)
+{
+    {
+        std::scoped_lock Lock(IOJobMutex);
+        PendingIOJobs.push_back(std::move(Job));
+    }
+
+    IOJobSignal.notify_one();
+}
+
+void SaveStateManager::IOThreadMain(std::stop_token StopToken)
+{
+    TraceRecorder::SetThreadName("Save State I/O");
+
+    while (true)
+    {
+        IOJob Job;
+
+        {
+            std::unique_lock Lock(IOJobMutex);
+
+            // Pending saves are still written when stopping, so quitting right after a save keeps it.
+            IOJobSignal.wait(Lock, StopToken, [this] { return !PendingIOJobs.empty(); });
+
+            if (PendingIOJobs.empty())
+                return;
+
+            Job = std::move(PendingIOJobs.front());
+            PendingIOJobs.pop_front();
+        }
+
+        TraceScope JobScope("Save State Job");
+        Job();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CoreWrapper/IEmulatorCore.h"
+#include "Util/FrameMailbox.h"
+
+// Numbered save state slots persisted under the preference folder.
+// The state is captured between two frames on the emulation thread, compression and file I/O run on a dedicated
+// thread so a save never delays a frame. Loading maps and decompresses the file on that same thread, then hands
+// the state to the emulation thread.
+//
+// Quitting with a game running also writes a resume snapshot (the state, the media and a thumbnail of the last frame)
+// which the next launch restores before the windows are created.
+class SaveStateManager
+{
+public:
+    static constexpr int SlotCount = 8;
+
+    static SaveStateManager& Get() { static SaveStateManager Instance; return Instance; }
+
+    SaveStateManager(const SaveStateManager&) = delete;
+    SaveStateManager& operator=(const SaveStateManager&) = delete;
+    ~SaveStateManager();
+
+    void Initialize();
+
+    void SaveSlot(int Slot);
+    void LoadSlot(int Slot);
+
+    [[nodiscard]] static std::filesystem::path GetSlotPath(const std::string& MediaPath, int Slot);
+
+    // Core stopped but not shut down yet (UI thread), written on the I/O thread. LastFrame may be nullptr.
+    void SaveResumeSnapshot(const IEmulatorCore& Core, const std::string& MediaPath, const std::string& Filter, const VideoFrame* LastFrame);
+    void ClearResumeSnapshot();
+    // Starts the media of the snapshot from its state, returns false if there is none. The snapshot is consumed, a
+    // session which crashes is not resumed again.
+    bool ResumeLastSession();
+    // RGB565 thumbnail of the resumed session, shown until its first frame. Empty once taken (UI thread only).
+    [[nodiscard]] std::vector<std::uint16_t> TakeResumeThumbnail() { return std::exchange(ResumeThumbnail, {}); }
+
+    [[nodiscard]] static std::filesystem::path GetResumePath();
+
+private:
+    using IOJob = std::function<void()>;
+
+    SaveStateManager() = default;
+
+    void PushIOJob(IOJob Job);
+    void IOThreadMain(std::stop_token StopToken);
+
+    std::jthread IOThread;
+    std::mutex IOJobMutex;
+    std::condition_variable_any IOJobSignal;
+    std::deque<IOJob> PendingIOJobs;
+
+    // Only used by the I/O thread.
+    std::vector<std::byte> CompressionBuffer;
+
+    std::vector<std::uint16_t> ResumeThumbnail;
+};
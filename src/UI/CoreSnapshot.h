@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "EmulatorCoreManager.h"
+
+// Bytes of a memory region copied on the emulation thread.
+struct MemoryBlock
+{
+    const MemoryRegion* Region = nullptr;
+    std::uint64_t Address = 0;
+    std::vector<std::byte> Data;
+
+    // Runs on the emulation thread.
+    void Capture(const MemoryRegion& Source, std::uint64_t StartAddress, std::size_t Size)
+    {
+        Region = &Source;
+        Address = StartAddress;
+        Data.resize(Size);
+        Source.ReadBlock(StartAddress, Data);
+    }
+
+    // Bytes of Source not in the block are 0, returns false when none was.
+    bool CopyTo(const MemoryRegion* Source, std::uint64_t StartAddress, std::span<std::byte> Output) const
+    {
+        std::ranges::fill(Output, std::byte{});
+
+        if (Source != Region || Source == nullptr || StartAddress >= Address + Data.size() || StartAddress + Output.size() <= Address)
+            return false;
+
+        const std::uint64_t First = std::max(StartAddress, Address);
+        const std::uint64_t Last = std::min(StartAddress + Output.size(), Address + Data.size());
+        std::copy(Data.begin() + static_cast<std::ptrdiff_t>(First - Address), Data.begin() + static_cast<std::ptrdiff_t>(Last - Address),
+            Output.begin() + static_cast<std::ptrdiff_t>(First - StartAddress));
+        return true;
+    }
+};
+
+// Core state a window displays, captured on the emulation thread so the UI thread never reads the core's memory while
+// a frame is emulated. Request() queues the capture as an emulation command and Acquire() returns the last completed
+// one: the window shows the state of a frame ago. A single capture is in flight, the values are recycled buffers
+// which the capture function must overwrite.
+template<typename Type>
+class CoreSnapshot
+{
+public:
+    using CaptureFunction = std::function<void(IEmulatorCore& Core, Type& Value)>;
+
+    // Ignored while the previous capture did not run yet.
+    void Request(CaptureFunction Capture)
+    {
+        if (Shared->IsPending.exchange(true, std::memory_order_acq_rel))
+            return;
+
+        EmulatorCoreManager::Get().PushCommand([State = Shared, Capture = std::move(Capture)](IEmulatorCore& Core)
+        {
+            // Back is only touched by the pending capture.
+            Capture(Core, State->Back);
+
+            {
+                std::scoped_lock Lock(State->Mutex);
+                std::swap(State->Back, State->Latest);
+                State->HasLatest = true;
+            }
+
+            State->IsPending.store(false, std::memory_order_release);
+        });
+    }
+
+    [[nodiscard]] const Type& Acquire()
+    {
+        std::scoped_lock Lock(Shared->Mutex);
+
+        if (Shared->HasLatest)
+        {
+            std::swap(Shared->Latest, Current);
+            Shared->HasLatest = false;
+        }
+
+        return Current;
+    }
+
+    // When the core stops, its queued commands may never run.
+    void Reset()
+    {
+        Shared = std::make_shared<SharedState>();
+        Current = {};
+    }
+
+private:
+    struct SharedState
+    {
+        std::mutex Mutex;
+        Type Back {};
+        Type Latest {};
+        bool HasLatest = false;
+        std::atomic<bool> IsPending = false;
+    };
+
+    // Kept alive by a queued capture after a Reset().
+    std::shared_ptr<SharedState> Shared = std::make_shared<SharedState>();
+    Type Current {};
+};
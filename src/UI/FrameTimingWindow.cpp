@@ -0,0 +1,260 @@
+#include "UI/FrameTimingWindow.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "imgui.h"
+#include "EmulatorCoreManager.h"
+#include "CoreWrapper/ChdHunkCache.h"
+#include "Util/Config.h"
+
+namespace
+{
+    constexpr std::array<ImU32, FrameStageCount> StageColors =
+    {
+        IM_COL32(86, 156, 214, 255),  // Emulate
+        IM_COL32(78, 201, 176, 255),  // Convert
+        IM_COL32(220, 220, 120, 255), // TextureUpload
+        IM_COL32(197, 134, 192, 255), // BuildUI
+        IM_COL32(206, 145, 120, 255), // ImGuiRender
+        IM_COL32(110, 110, 120, 255), // Swap
+    };
+
+    constexpr double NsToMs(std::uint64_t Ns)
+    {
+        return static_cast<double>(Ns) / 1'000'000.0;
+    }
+
+    double GetSeriesMs(const HostFrameTimings& Frame, std::size_t Series)
+    {
+        return NsToMs(Series == 0 ? Frame.DurationNs : Frame.StageNs[Series - 1]);
+    }
+}
+
+std::uint64_t FrameTimingWindow::TypeId()
+{
+    return StaticTypeId();
+}
+
+const std::string& FrameTimingWindow::Title()
+{
+    static std::string Title = "Frame Timing";
+    return Title;
+}
+
+void FrameTimingWindow::Render()
+{
+    ImGui::Begin(Title().c_str(), &IsOpen);
+
+    const Percentiles FramePercentiles = ComputePercentiles(0);
+
+    ImGui::Text("Frame: p50 %.2f ms  p99 %.2f ms  max %.2f ms", FramePercentiles.P50Ms, FramePercentiles.P99Ms, FramePercentiles.MaxMs);
+    ImGui::SameLine();
+
+    if (ImGui::Button("Export CSV"))
+        ExportCsv();
+
+    if (!LastExportPath.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", LastExportPath.filename().string().c_str());
+    }
+
+    RenderGraph(static_cast<float>(std::max(FramePercentiles.P99Ms * 1.25, 20.0)));
+
+    if (ImGui::BeginTable("Stages", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("p50 (ms)");
+        ImGui::TableSetupColumn("p99 (ms)");
+        ImGui::TableSetupColumn("max (ms)");
+        ImGui::TableHeadersRow();
+
+        for (std::size_t Stage = 0; Stage < FrameStageCount; ++Stage)
+        {
+            const Percentiles StagePercentiles = ComputePercentiles(Stage + 1);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::ColorButton("##Color", ImGui::ColorConvertU32ToFloat4(StageColors[Stage]), ImGuiColorEditFlags_NoTooltip, ImVec2(ImGui::GetTextLineHeight(), ImGui::GetTextLineHeight()));
+            ImGui::SameLine();
+            ImGui::TextUnformatted(FrameStageName(static_cast<FrameStage>(Stage)).data());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", StagePercentiles.P50Ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", StagePercentiles.P99Ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", StagePercentiles.MaxMs);
+        }
+
+        ImGui::EndTable();
+    }
+
+    RenderQueueStats();
+
+    ImGui::End();
+}
+
+FrameTimingWindow::Percentiles FrameTimingWindow::ComputePercentiles(std::size_t Series)
+{
+    const FrameProfiler& Profiler = FrameProfiler::Get();
+    SortedValues.resize(Profiler.GetFrameCount());
+
+    if (SortedValues.empty())
+        return {};
+
+    for (std::size_t Index = 0; Index < SortedValues.size(); ++Index)
+        SortedValues[Index] = GetSeriesMs(Profiler.GetFrame(Index), Series);
+
+    std::ranges::sort(SortedValues);
+
+    auto At = [this](double Ratio)
+    {
+        return SortedValues[static_cast<std::size_t>(Ratio * static_cast<double>(SortedValues.size() - 1) + 0.5)];
+    };
+
+    return { At(0.50), At(0.99), SortedValues.back() };
+}
+
+void FrameTimingWindow::RenderGraph(float MaxMs)
+{
+    const FrameProfiler& Profiler = FrameProfiler::Get();
+    const ImVec2 GraphSize(ImGui::GetContentRegionAvail().x, ImGui::GetTextLineHeight() * 10.0f);
+    const ImVec2 GraphMin = ImGui::GetCursorScreenPos();
+    const ImVec2 GraphMax(GraphMin.x + GraphSize.x, GraphMin.y + GraphSize.y);
+
+    ImGui::InvisibleButton("##Graph", ImVec2(std::max(GraphSize.x, 1.0f), GraphSize.y));
+
+    ImDrawList* DrawList = ImGui::GetWindowDrawList();
+    DrawList->AddRectFilled(GraphMin, GraphMax, IM_COL32(20, 20, 24, 255));
+
+    const float PixelsPerMs = GraphSize.y / MaxMs;
+    const float BarWidth = GraphSize.x / static_cast<float>(FrameProfiler::HistoryLength);
+    const std::size_t FrameCount = Profiler.GetFrameCount();
+    // Newest frame on the right edge.
+    const float FirstBarX = GraphMax.x - BarWidth * static_cast<float>(FrameCount);
+
+    for (std::size_t Index = 0; Index < FrameCount; ++Index)
+    {
+        const HostFrameTimings& Frame = Profiler.GetFrame(Index);
+        const float X0 = FirstBarX + BarWidth * static_cast<float>(Index);
+        const float X1 = X0 + std::max(BarWidth - 1.0f, 1.0f);
+        float Y = GraphMax.y;
+
+        for (std::size_t Stage = 0; Stage < FrameStageCount; ++Stage)
+        {
+            const float Height = static_cast<float>(NsToMs(Frame.StageNs[Stage])) * PixelsPerMs;
+            const float NextY = std::max(Y - Height, GraphMin.y);
+            DrawList->AddRectFilled(ImVec2(X0, NextY), ImVec2(X1, Y), StageColors[Stage]);
+            Y = NextY;
+        }
+
+        // Stages of both threads are stacked, so the bar may stand above the wall time of the frame.
+        const float FrameY = std::max(GraphMax.y - static_cast<float>(NsToMs(Frame.DurationNs)) * PixelsPerMs, GraphMin.y);
+        DrawList->AddLine(ImVec2(X0, FrameY), ImVec2(X1, FrameY), IM_COL32(255, 255, 255, 200));
+    }
+
+    for (const float ReferenceMs : { 1000.0f / 60.0f, 1000.0f / 30.0f })
+    {
+        if (ReferenceMs < MaxMs)
+        {
+            const float Y = GraphMax.y - ReferenceMs * PixelsPerMs;
+            DrawList->AddLine(ImVec2(GraphMin.x, Y), ImVec2(GraphMax.x, Y), IM_COL32(255, 80, 80, 120));
+        }
+    }
+
+    if (ImGui::IsItemHovered() && FrameCount != 0 && BarWidth > 0.0f)
+    {
+        const float Offset = (ImGui::GetIO().MousePos.x - FirstBarX) / BarWidth;
+
+        if (Offset >= 0.0f && Offset < static_cast<float>(FrameCount))
+        {
+            const HostFrameTimings& Frame = Profiler.GetFrame(static_cast<std::size_t>(Offset));
+
+            ImGui::BeginTooltip();
+            ImGui::Text("Frame: %.3f ms", NsToMs(Frame.DurationNs));
+
+            for (std::size_t Stage = 0; Stage < FrameStageCount; ++Stage)
+                ImGui::Text("%s: %.3f ms", FrameStageName(static_cast<FrameStage>(Stage)).data(), NsToMs(Frame.StageNs[Stage]));
+
+            ImGui::EndTooltip();
+        }
+    }
+}
+
+void FrameTimingWindow::RenderQueueStats()
+{
+    EmulatorCoreManager& Manager = EmulatorCoreManager::Get();
+
+    // Each call restarts the min/max window, refresh about twice a second so the range stays readable.
+    if (AudioStatsAge++ % 30 == 0)
+        AudioStats = Manager.TakeAudioQueueStats();
+
+    const FramePacingStats Pacing = Manager.GetPacingStats();
+
+    ImGui::SeparatorText("Pacing");
+    ImGui::Text("Emulated %llu  Catch-up %llu  Missed %llu  Dropped %llu  Duplicated %llu",
+        static_cast<unsigned long long>(Pacing.EmulatedFrames), static_cast<unsigned long long>(Pacing.CatchUpFrames),
+        static_cast<unsigned long long>(Pacing.MissedFrames), static_cast<unsigned long long>(Pacing.DroppedFrames),
+        static_cast<unsigned long long>(Pacing.DuplicatedFrames));
+
+    ImGui::SeparatorText("Audio Queue");
+    ImGui::Text("Fill %zu / %zu (min %zu, max %zu)  Underruns %llu  Dropped samples %llu",
+        AudioStats.FillLevel, AudioStats.Capacity, AudioStats.MinFillLevel, AudioStats.MaxFillLevel,
+        static_cast<unsigned long long>(AudioStats.Underruns), static_cast<unsigned long long>(AudioStats.DroppedElements));
+
+    if (const std::uint64_t DroppedSamples = FrameProfiler::Get().GetDroppedSampleCount(); DroppedSamples != 0)
+        ImGui::TextDisabled("%llu timing samples dropped", static_cast<unsigned long long>(DroppedSamples));
+
+    if (const std::optional<ChdCacheStats> CdCache = ChdHunkCache::GetActiveStats())
+    {
+        const std::uint64_t Reads = CdCache->Hits + CdCache->LateHits + CdCache->Misses;
+        const double HitRate = Reads != 0 ? static_cast<double>(CdCache->Hits + CdCache->LateHits) * 100.0 / static_cast<double>(Reads) : 0.0;
+
+        ImGui::SeparatorText("CD Cache");
+        ImGui::Text("Hit rate %.1f%%  Hits %llu  Late %llu  Misses %llu  Read ahead %llu  Evicted %llu  Waited %.1f ms",
+            HitRate, static_cast<unsigned long long>(CdCache->Hits), static_cast<unsigned long long>(CdCache->LateHits),
+            static_cast<unsigned long long>(CdCache->Misses), static_cast<unsigned long long>(CdCache->ReadAheadHunks),
+            static_cast<unsigned long long>(CdCache->Evictions), NsToMs(CdCache->WaitNs));
+    }
+}
+
+void FrameTimingWindow::ExportCsv()
+{
+    const FrameProfiler& Profiler = FrameProfiler::Get();
+    const auto Timestamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::filesystem::path Path = std::filesystem::path(Config::Instance().GetPreferencePath()) / ("FrameTiming-" + std::to_string(Timestamp) + ".csv");
+
+    std::ofstream Stream(Path);
+
+    if (!Stream)
+    {
+        std::cerr << "Unable to write frame timings to " << Path.string() << '\n';
+        return;
+    }
+
+    Stream << "frame,start_ms,frame_ms";
+
+    for (std::size_t Stage = 0; Stage < FrameStageCount; ++Stage)
+        Stream << ',' << FrameStageName(static_cast<FrameStage>(Stage));
+
+    Stream << '\n';
+
+    const std::uint64_t FirstStartNs = Profiler.GetFrameCount() != 0 ? Profiler.GetFrame(0).StartNs : 0;
+
+    for (std::size_t Index = 0; Index < Profiler.GetFrameCount(); ++Index)
+    {
+        const HostFrameTimings& Frame = Profiler.GetFrame(Index);
+        Stream << Index << ',' << NsToMs(Frame.StartNs - FirstStartNs) << ',' << NsToMs(Frame.DurationNs);
+
+        for (const std::uint64_t StageNs : Frame.StageNs)
+            Stream << ',' << NsToMs(StageNs);
+
+        Stream << '\n';
+    }
+
+    std::cout << "Frame timings written to " << Path.string() << '\n';
+    LastExportPath = Path;
+}
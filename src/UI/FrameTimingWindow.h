@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "IWindow.h"
+#include "Util/FrameProfiler.h"
+#include "Util/HashUtil.h"
+#include "Util/SpscRingBuffer.h"
+
+class FrameTimingWindow final : public IWindow
+{
+public:
+    static consteval std::uint64_t StaticTypeId() { return SourceLocationUniqueId64(); }
+
+    virtual std::uint64_t TypeId() override;
+
+    virtual const std::string& Title() override;
+    virtual void Render() override;
+
+private:
+    struct Percentiles
+    {
+        double P50Ms = 0.0;
+        double P99Ms = 0.0;
+        double MaxMs = 0.0;
+    };
+
+    [[nodiscard]] Percentiles ComputePercentiles(std::size_t Series);
+    void RenderGraph(float MaxMs);
+    void RenderQueueStats();
+    void ExportCsv();
+
+    // Per frame total, then one entry per stage.
+    static constexpr std::size_t SeriesCount = FrameStageCount + 1;
+
+    std::vector<double> SortedValues;
+    RingBufferStats AudioStats;
+    std::uint32_t AudioStatsAge = 0;
+    std::filesystem::path LastExportPath;
+};
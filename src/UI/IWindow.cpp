@@ -15,3 +15,7 @@ void IWindow::OnEmulationMediaOpen(std::uint32_t MediaSource, const std::string&
 void IWindow::OnEmulationMediaClose(std::uint32_t MediaSource)
 {
 }
+
+void IWindow::Update()
+{
+}
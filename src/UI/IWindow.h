@@ -16,6 +16,9 @@ public:
     virtual void OnEmulationMediaOpen(std::uint32_t MediaSource, const std::string& MediaPath);
     virtual void OnEmulationMediaClose(std::uint32_t MediaSource);
 
+    // Every frame, even while the window is closed.
+    virtual void Update();
+
     virtual ImGuiKeyChord GetDisplayShortcutKey() { return ImGuiKey_None; }
     virtual const std::string& Title() = 0;
     virtual void Render() = 0;
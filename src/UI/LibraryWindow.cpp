@@ -0,0 +1,440 @@
+#include "UI/LibraryWindow.h"
+
+#include <algorithm>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <spawn.h>
+#include <string_view>
+#include <sys/wait.h>
+#include <SDL_opengl.h>
+
+#include "ImGuiFileDialog.h"
+#include "GL/glcorearb.h"
+#include "EmulatorCoreManager.h"
+#include "UI/ShortcutAndMenuUtils.h"
+#include "Util/Config.h"
+
+extern char** environ;
+
+namespace
+{
+    // About 6 MB of video memory, several screens of rows.
+    constexpr std::size_t MaxThumbnailTextures = 256;
+    // Each upload may fault a few pages of the atlas in from the disk, fast scrolling fills the rows over a few frames
+    // instead of stalling one.
+    constexpr std::uint32_t MaxThumbnailUploadsPerFrame = 16;
+    constexpr float ThumbnailDisplayScale = 0.75f;
+
+    bool ContainsIgnoringCase(std::string_view Text, std::string_view Pattern)
+    {
+        const auto ToLower = [](char Character) { return Character >= 'A' && Character <= 'Z' ? static_cast<char>(Character | 0x20) : Character; };
+
+        return Pattern.empty() || !std::ranges::search(Text, Pattern, [&ToLower](char Left, char Right) { return ToLower(Left) == ToLower(Right); }).empty();
+    }
+}
+
+LibraryWindow::LibraryWindow()
+    : Library(RomLibrary::DefaultIndexPath())
+{
+    Config::Instance().GetArray("Library.Folders", Folders);
+
+    // A missing index only means the library was never scanned.
+    if (const std::error_code Error = Library.LoadIndex(); Error && Error != std::errc::no_such_file_or_directory)
+        std::cerr << "Library: index ignored, " << Error.message() << '\n';
+
+    Entries = Library.GetEntries();
+
+    if (const std::error_code Error = Thumbnails.Open(ThumbnailAtlas::DefaultPath()); Error && Error != std::errc::no_such_file_or_directory)
+        std::cerr << "Library: thumbnails ignored, " << Error.message() << '\n';
+
+    // Picks up what changed since the last launch, only new and modified files are hashed again.
+    if (!Folders.empty())
+        StartScan();
+}
+
+LibraryWindow::~LibraryWindow()
+{
+    // Its process group includes the workers it forked. The atlas is replaced atomically, killing it leaves the
+    // previous one in place.
+    if (ThumbnailGenerator > 0)
+    {
+        kill(-ThumbnailGenerator, SIGKILL);
+        waitpid(ThumbnailGenerator, nullptr, 0);
+    }
+
+    DestroyThumbnailTextures();
+}
+
+std::uint64_t LibraryWindow::TypeId()
+{
+    return StaticTypeId();
+}
+
+const std::string& LibraryWindow::Title()
+{
+    static std::string Title = "Library";
+    return Title;
+}
+
+void LibraryWindow::Update()
+{
+    // The generator outlives a closed window, it is reaped as soon as it exits.
+    PollThumbnailGenerator();
+}
+
+void LibraryWindow::Render()
+{
+    ImGui::Begin(Title().c_str(), &IsOpen);
+
+    RenderFolders();
+
+    if (std::shared_ptr<const std::vector<RomEntry>> LatestEntries = Library.GetEntries(); LatestEntries != Entries)
+    {
+        Entries = std::move(LatestEntries);
+        IsFilterChanged = true;
+    }
+
+    ImGui::SetNextItemWidth(-FLT_MIN);
+
+    if (ImGui::InputTextWithHint("##Filter", "Filter by title or file name", FilterText.data(), FilterText.size()))
+        IsFilterChanged = true;
+
+    if (IsFilterChanged)
+        RefreshVisibleEntries();
+
+    RenderEntries();
+
+    ImGui::End();
+}
+
+void LibraryWindow::RenderFolders()
+{
+    const RomLibraryProgress Progress = Library.GetProgress();
+
+    if (ImGui::Button("Add Folder..."))
+    {
+        ImGuiUtil_OpenModalFileDialog("Add Library Folder", "", Config::Instance().Get("File.LastOpenPath", "."), [this](const std::string_view&)
+        {
+            const std::string Folder = ImGuiFileDialog::Instance()->GetFilePathName();
+
+            if (std::ranges::find(Folders, Folder) == Folders.end())
+            {
+                Folders.push_back(Folder);
+                SaveFolders();
+                StartScan();
+            }
+        }, "LibraryAddFolder");
+    }
+
+    ImGui::SameLine();
+
+    if (Progress.IsScanning)
+    {
+        if (ImGui::Button("Cancel"))
+            Library.CancelScan();
+
+        ImGui::SameLine();
+
+        // Walking the folders first, the number of files to hash is only known once it is done.
+        if (Progress.FilesToHash == 0)
+        {
+            ImGui::Text("Scanning, %u files found", Progress.FilesFound);
+        }
+        else
+        {
+            const std::string Overlay = std::to_string(Progress.FilesHashed) + " / " + std::to_string(Progress.FilesToHash) + " files hashed";
+            ImGui::ProgressBar(static_cast<float>(Progress.FilesHashed) / static_cast<float>(Progress.FilesToHash), ImVec2(-FLT_MIN, 0.0f), Overlay.c_str());
+        }
+    }
+    else
+    {
+        if (ImGui::Button("Rescan"))
+            StartScan();
+
+        ImGui::SameLine();
+        ImGui::Text("%zu games", Entries != nullptr ? Entries->size() : 0);
+        ImGui::SameLine();
+        RenderThumbnailControls();
+    }
+
+    if (!Folders.empty() && ImGui::CollapsingHeader("Folders"))
+    {
+        for (std::size_t Index = 0; Index < Folders.size(); ++Index)
+        {
+            ImGui::PushID(static_cast<int>(Index));
+
+            if (ImGui::SmallButton("Remove"))
+            {
+                Folders.erase(Folders.begin() + static_cast<std::ptrdiff_t>(Index));
+                SaveFolders();
+                StartScan();
+                ImGui::PopID();
+                break;
+            }
+
+            ImGui::SameLine();
+            ImGui::TextUnformatted(Folders[Index].c_str());
+            ImGui::PopID();
+        }
+    }
+}
+
+void LibraryWindow::RenderEntries()
+{
+    constexpr ImGuiTableFlags TableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersInnerV;
+
+    const bool HasThumbnailColumn = IsShowingThumbnails && Thumbnails.IsOpen();
+    const ImVec2 ThumbnailSize(ThumbnailWidth * ThumbnailDisplayScale, ThumbnailHeight * ThumbnailDisplayScale);
+
+    if (!ImGui::BeginTable("Games", HasThumbnailColumn ? 6 : 5, TableFlags))
+        return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+
+    if (HasThumbnailColumn)
+        ImGui::TableSetupColumn("##Thumbnail", ImGuiTableColumnFlags_WidthFixed, ThumbnailSize.x);
+
+    ImGui::TableSetupColumn("Title", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("System", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("Region", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("CRC32", ImGuiTableColumnFlags_WidthFixed);
+    ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableHeadersRow();
+
+    // Ten thousand rows only cost the visible ones.
+    ImGuiListClipper Clipper;
+    Clipper.Begin(static_cast<int>(VisibleEntries.size()));
+
+    while (Clipper.Step())
+    {
+        for (int Row = Clipper.DisplayStart; Row < Clipper.DisplayEnd; ++Row)
+        {
+            const RomEntry& Entry = (*Entries)[VisibleEntries[Row]];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+
+            if (HasThumbnailColumn)
+            {
+                if (const ImTextureID Texture = GetThumbnailTexture(Entry); Texture != ImTextureID_Invalid)
+                    ImGui::Image(Texture, ThumbnailSize);
+                else
+                    ImGui::Dummy(ThumbnailSize);
+
+                ImGui::TableNextColumn();
+            }
+
+            ImGui::PushID(Row);
+
+            if (ImGui::Selectable(Entry.Title.c_str(), false, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick,
+                    ImVec2(0.0f, HasThumbnailColumn ? ThumbnailSize.y : 0.0f)) &&
+                ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+            {
+                EmulatorCoreManager& Manager = EmulatorCoreManager::Get();
+                Manager.StartEmulationWithMedia(Entry.Path, Manager.EmulatorCores[0]->GetMediaFilter(0));
+            }
+
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("%s\nSHA-1 %s\n%s", Entry.ProductCode.c_str(), Sha1ToHex(Entry.Sha1).c_str(), Entry.Path.c_str());
+
+            ImGui::PopID();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(RomSystemName(Entry.System).data());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(RomRegionsToString(Entry.Regions).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%08X", Entry.Crc32);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(std::filesystem::path(Entry.Path).filename().c_str());
+        }
+    }
+
+    Clipper.End();
+    ImGui::EndTable();
+
+    EvictThumbnailTextures();
+}
+
+void LibraryWindow::RenderThumbnailControls()
+{
+    if (ThumbnailGenerator > 0)
+    {
+        ImGui::TextUnformatted("Generating thumbnails...");
+        return;
+    }
+
+    if (Thumbnails.IsOpen())
+    {
+        ImGui::Checkbox("Thumbnails", &IsShowingThumbnails);
+        ImGui::SameLine();
+    }
+
+    // Only ROMs missing from the atlas are booted, so this is also how new games get their thumbnail.
+    ImGui::BeginDisabled(Entries == nullptr || Entries->empty());
+
+    if (ImGui::Button("Generate Thumbnails"))
+        StartThumbnailGenerator();
+
+    ImGui::EndDisabled();
+}
+
+void LibraryWindow::RefreshVisibleEntries()
+{
+    const std::string_view Filter = FilterText.data();
+
+    VisibleEntries.clear();
+
+    for (std::uint32_t Index = 0; Index < Entries->size(); ++Index)
+    {
+        const RomEntry& Entry = (*Entries)[Index];
+
+        if (ContainsIgnoringCase(Entry.Title, Filter) || ContainsIgnoringCase(std::filesystem::path(Entry.Path).filename().native(), Filter))
+            VisibleEntries.push_back(Index);
+    }
+
+    IsFilterChanged = false;
+}
+
+void LibraryWindow::StartScan()
+{
+    Library.StartScan({ Folders.begin(), Folders.end() });
+}
+
+void LibraryWindow::SaveFolders()
+{
+    Config::Instance().SetArray("Library.Folders", Folders);
+}
+
+ImTextureID LibraryWindow::GetThumbnailTexture(const RomEntry& Entry)
+{
+    const std::uint16_t* Pixels = Thumbnails.Find(Entry.Sha1);
+
+    if (Pixels == nullptr)
+        return ImTextureID_Invalid;
+
+    const int Frame = ImGui::GetFrameCount();
+
+    if (const auto Cached = ThumbnailTextures.find(Pixels); Cached != ThumbnailTextures.end())
+    {
+        Cached->second.LastUsedFrame = Frame;
+        return Cached->second.Texture;
+    }
+
+    if (ThumbnailUploadFrame != Frame)
+    {
+        ThumbnailUploadFrame = Frame;
+        ThumbnailUploads = 0;
+    }
+
+    if (ThumbnailUploads == MaxThumbnailUploadsPerFrame)
+        return ImTextureID_Invalid;
+
+    ++ThumbnailUploads;
+
+    // Straight from the mapping, the atlas stores the pixels in the layout OpenGL takes.
+    GLuint TextureId;
+    glGenTextures(1, &TextureId);
+    glBindTexture(GL_TEXTURE_2D, TextureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, ThumbnailWidth, ThumbnailHeight, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, Pixels);
+
+    const ImTextureID Texture = static_cast<ImTextureID>(static_cast<intptr_t>(TextureId));
+    ThumbnailTextures.emplace(Pixels, ThumbnailTexture { Texture, Frame });
+    return Texture;
+}
+
+void LibraryWindow::EvictThumbnailTextures()
+{
+    if (ThumbnailTextures.size() <= MaxThumbnailTextures)
+        return;
+
+    std::vector<std::pair<int, const std::uint16_t*>> ByLastUse;
+    ByLastUse.reserve(ThumbnailTextures.size());
+
+    for (const auto& [Pixels, Cached] : ThumbnailTextures)
+        ByLastUse.emplace_back(Cached.LastUsedFrame, Pixels);
+
+    // Down to three quarters, so scrolling does not evict on every frame.
+    const std::size_t EvictedCount = ThumbnailTextures.size() - MaxThumbnailTextures * 3 / 4;
+    std::ranges::nth_element(ByLastUse, ByLastUse.begin() + static_cast<std::ptrdiff_t>(EvictedCount));
+
+    for (std::size_t Index = 0; Index < EvictedCount; ++Index)
+    {
+        const auto Cached = ThumbnailTextures.find(ByLastUse[Index].second);
+        const auto TextureId = static_cast<GLuint>(static_cast<intptr_t>(Cached->second.Texture));
+        glDeleteTextures(1, &TextureId);
+        ThumbnailTextures.erase(Cached);
+    }
+}
+
+void LibraryWindow::DestroyThumbnailTextures()
+{
+    for (const auto& [Pixels, Cached] : ThumbnailTextures)
+    {
+        const auto TextureId = static_cast<GLuint>(static_cast<intptr_t>(Cached.Texture));
+        glDeleteTextures(1, &TextureId);
+    }
+
+    ThumbnailTextures.clear();
+}
+
+void LibraryWindow::StartThumbnailGenerator()
+{
+    // Booting thousands of ROMs takes minutes: the headless runner does it in its own worker processes and replaces
+    // the atlas when done, the window only reopens it.
+    std::error_code Error;
+    const std::filesystem::path Executable = std::filesystem::read_symlink("/proc/self/exe", Error).parent_path() / "Ultipugna-headless";
+
+    const std::string IndexPath = RomLibrary::DefaultIndexPath().string();
+    const std::string AtlasPath = ThumbnailAtlas::DefaultPath().string();
+    const std::string BiosFolder = EmulatorCoreManager::Get().EmulatorCores[0]->GetSettingValue("Bios Folder");
+
+    std::vector<const char*> Arguments = { Executable.c_str(), "--thumbnails", "--library", IndexPath.c_str(), "--atlas", AtlasPath.c_str() };
+
+    if (!BiosFolder.empty())
+        Arguments.insert(Arguments.end(), { "--bios", BiosFolder.c_str() });
+
+    Arguments.push_back(nullptr);
+
+    // In a process group of its own, so the window can stop it along with its workers.
+    posix_spawnattr_t Attributes;
+    posix_spawnattr_init(&Attributes);
+    posix_spawnattr_setflags(&Attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&Attributes, 0);
+
+    const int Result = posix_spawn(&ThumbnailGenerator, Executable.c_str(), nullptr, &Attributes, const_cast<char* const*>(Arguments.data()), environ);
+    posix_spawnattr_destroy(&Attributes);
+
+    if (Result != 0)
+    {
+        std::cerr << "Library: unable to start " << Executable.string() << ", " << std::generic_category().message(Result) << '\n';
+        ThumbnailGenerator = -1;
+    }
+}
+
+void LibraryWindow::PollThumbnailGenerator()
+{
+    int Status = 0;
+
+    if (ThumbnailGenerator <= 0 || waitpid(ThumbnailGenerator, &Status, WNOHANG) != ThumbnailGenerator)
+        return;
+
+    ThumbnailGenerator = -1;
+
+    if (!WIFEXITED(Status) || (WEXITSTATUS(Status) != 0 && WEXITSTATUS(Status) != ThumbnailGeneratorPartialExitCode))
+    {
+        std::cerr << "Library: thumbnail generation failed\n";
+        return;
+    }
+
+    if (WEXITSTATUS(Status) == ThumbnailGeneratorPartialExitCode)
+        std::cerr << "Library: some ROMs got no thumbnail\n";
+
+    // The cached textures are keyed by pointers into the previous mapping.
+    DestroyThumbnailTextures();
+
+    if (const std::error_code Error = Thumbnails.Open(ThumbnailAtlas::DefaultPath()))
+        std::cerr << "Library: thumbnails ignored, " << Error.message() << '\n';
+}
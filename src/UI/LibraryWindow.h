@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+#include "imgui.h"
+#include "IWindow.h"
+#include "Library/RomLibrary.h"
+#include "Library/ThumbnailAtlas.h"
+#include "Util/HashUtil.h"
+
+class LibraryWindow final : public IWindow
+{
+public:
+    static consteval std::uint64_t StaticTypeId() { return SourceLocationUniqueId64(); }
+
+    LibraryWindow();
+    virtual ~LibraryWindow() override;
+
+    virtual std::uint64_t TypeId() override;
+
+    virtual const std::string& Title() override;
+    virtual void Update() override;
+    virtual void Render() override;
+
+private:
+    void RenderFolders();
+    void RenderEntries();
+    void RenderThumbnailControls();
+    void RefreshVisibleEntries();
+    void StartScan();
+    void SaveFolders();
+
+    // Uploads the thumbnail of the entry on first use, ImTextureID_Invalid if it has none or the frame's upload
+    // budget is spent (it shows up on one of the next frames then).
+    ImTextureID GetThumbnailTexture(const RomEntry& Entry);
+    void EvictThumbnailTextures();
+    void DestroyThumbnailTextures();
+    void StartThumbnailGenerator();
+    void PollThumbnailGenerator();
+
+    RomLibrary Library;
+    std::vector<std::string> Folders;
+
+    // Snapshot being displayed, and the indices in it matching the filter.
+    std::shared_ptr<const std::vector<RomEntry>> Entries;
+    std::vector<std::uint32_t> VisibleEntries;
+    std::array<char, 128> FilterText = {};
+    bool IsFilterChanged = true;
+
+    struct ThumbnailTexture
+    {
+        ImTextureID Texture = ImTextureID_Invalid;
+        int LastUsedFrame = 0;
+    };
+
+    // Textures of the thumbnails scrolled by recently, keyed by their pixels in the atlas mapping.
+    ThumbnailAtlas Thumbnails;
+    std::unordered_map<const std::uint16_t*, ThumbnailTexture> ThumbnailTextures;
+    std::uint32_t ThumbnailUploads = 0;
+    int ThumbnailUploadFrame = -1;
+    bool IsShowingThumbnails = true;
+    pid_t ThumbnailGenerator = -1;
+};
@@ -1,5 +1,8 @@
 #include "MemoryViewerWindow.h"
 
+#include <algorithm>
+
+#include "EmulatorCoreManager.h"
 #include "UI/ShortcutAndMenuUtils.h"
 #include "Util/ImGuiMathUtil.h"
 
@@ -23,6 +26,7 @@ void MemoryViewerWindow::OnEmulationMediaOpen(std::uint32_t MediaSource, const s
 
 void MemoryViewerWindow::OnEmulationCoreStop()
 {
+    Snapshot.Reset();
     MemEditorState.ReadCallback = nullptr;
     MemEditorState.WriteCallback = nullptr;
     MemRegion = nullptr;
@@ -51,6 +55,11 @@ void MemoryViewerWindow::Render()
         ImGuiUtil_ComboAutoWidth("##SelectedMemoryRegion", &SelectedMemoryRegion, MemoryRegionNames.c_str());
         ImGui::Separator();
 
+        // The editor reads the bytes captured a frame ago, the lines it asks for are captured for the next frame.
+        VisibleBlock = &Snapshot.Acquire();
+        VisibleFirst = UINT64_MAX;
+        VisibleEnd = 0;
+
         ImGui::BeginHexEditor("HexEditor", &MemEditorState);
 
         if (ImGui::IsWindowHovered())
@@ -67,6 +76,14 @@ void MemoryViewerWindow::Render()
 
         ImGui::EndHexEditor();
 
+        if (VisibleFirst < VisibleEnd)
+        {
+            Snapshot.Request([Region = MemRegion, Address = MemRegion->StartAddress + VisibleFirst, Size = VisibleEnd - VisibleFirst](IEmulatorCore&, MemoryBlock& Block)
+            {
+                Block.Capture(*Region, Address, static_cast<std::size_t>(Size));
+            });
+        }
+
         if (bInside && ImGui::IsMouseReleased(ImGuiMouseButton_Right)) // touche "Menu" de certains claviers
         {
             ImGui::OpenPopup("ItemCtx");
@@ -118,15 +135,16 @@ void MemoryViewerWindow::SelectMemoryRegion(std::size_t Index)
             MemRegion = &MemRegions[SelectedMemoryRegion];
             MemEditorState.BytesPerLine = 16;
             MemEditorState.MaxBytes = static_cast<int>(MemRegion->EndAddress - MemRegion->StartAddress + 1ull);
-            MemEditorState.UserData = const_cast<MemoryRegion*>(MemRegion);
+            MemEditorState.UserData = this;
             MemEditorState.AddressChars = static_cast<int>(MemRegion->AddressBits / 4);
             MemEditorState.ReadCallback = [](ImGuiHexEditorState* State, int Offset, void* Buffer, int Size) -> int
             {
-                if (const auto Mem = static_cast<const MemoryRegion*>(State->UserData))
+                if (const auto Window = static_cast<MemoryViewerWindow*>(State->UserData); Window != nullptr && Window->VisibleBlock != nullptr)
                 {
-                    for (std::byte& Byte : std::span(static_cast<std::byte*>(Buffer), Size))
-                        Byte = Mem->Read(Offset++);
-
+                    const std::uint64_t First = static_cast<std::uint64_t>(Offset);
+                    Window->VisibleFirst = std::min(Window->VisibleFirst, First);
+                    Window->VisibleEnd = std::max(Window->VisibleEnd, First + static_cast<std::uint64_t>(Size));
+                    Window->VisibleBlock->CopyTo(Window->MemRegion, Window->MemRegion->StartAddress + First, std::span(static_cast<std::byte*>(Buffer), Size));
                     return Size;
                 }
 
@@ -134,10 +152,16 @@ void MemoryViewerWindow::SelectMemoryRegion(std::size_t Index)
             };
             MemEditorState.WriteCallback = [](ImGuiHexEditorState* State, int Offset, void* Buffer, int Size) -> int
             {
-                if (const auto Mem = static_cast<const MemoryRegion*>(State->UserData))
+                if (const auto Window = static_cast<const MemoryViewerWindow*>(State->UserData))
                 {
-                    for (const std::byte& Byte : std::span(static_cast<std::byte*>(Buffer), Size))
-                        Mem->Write(Offset++, Byte);
+                    const MemoryRegion* Mem = Window->MemRegion;
+
+                    // Writes must not race with the emulation thread, they are applied between two frames.
+                    const std::span Bytes(static_cast<const std::byte*>(Buffer), Size);
+                    EmulatorCoreManager::Get().PushCommand([Mem, Offset, Data = std::vector(Bytes.begin(), Bytes.end())](IEmulatorCore&)
+                    {
+                        Mem->WriteBlock(Mem->StartAddress + static_cast<std::uint64_t>(Offset), Data);
+                    });
 
                     return Size;
                 }
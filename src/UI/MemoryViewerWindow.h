@@ -2,6 +2,7 @@
 
 #include "imgui_hex.h"
 #include "IWindow.h"
+#include "UI/CoreSnapshot.h"
 #include "Util/HashUtil.h"
 
 class MemoryViewerWindow final : public IWindow
@@ -25,4 +26,10 @@ private:
     int SelectedMemoryRegion = 0;
     std::uint64_t DisplayAddress = 0;
     std::string MemoryRegionNames;
+
+    CoreSnapshot<MemoryBlock> Snapshot;
+    const MemoryBlock* VisibleBlock = nullptr;
+    // Offsets read by the hex editor during the current frame.
+    std::uint64_t VisibleFirst = UINT64_MAX;
+    std::uint64_t VisibleEnd = 0;
 };
@@ -6,6 +6,10 @@
 #include <SDL_opengl.h>
 #include "imgui.h"
 #include "GL/glcorearb.h"
+#include "EmulatorCoreManager.h"
+#include "Library/ThumbnailAtlas.h"
+#include "SaveStateManager.h"
+#include "Util/FrameProfiler.h"
 
 extern "C"
 {
@@ -13,12 +17,9 @@ extern "C"
     #include "system.h"
 }
 
-std::vector<RenderWindow*> RenderWindow::CurrentInstances;
-
 RenderWindow::RenderWindow(std::uint32_t MediaSource)
     : Source(MediaSource)
 {
-    CurrentInstances.push_back(this);
     IsOpen = true;
 
     if (MediaSource == 0)
@@ -35,7 +36,6 @@ RenderWindow::RenderWindow(std::uint32_t MediaSource)
 
 RenderWindow::~RenderWindow()
 {
-    std::erase(CurrentInstances, this);
     DestroyTexture();
 }
 
@@ -46,6 +46,20 @@ std::uint64_t RenderWindow::TypeId()
 
 void RenderWindow::Render()
 {
+    // Todo: support multiple output screen
+    if (Source == 0)
+    {
+        if (const VideoFrame* Frame = EmulatorCoreManager::Get().AcquireVideoFrame())
+        {
+            ScopedFrameStage UploadStage(FrameStage::TextureUpload);
+            UpdateTexture(Frame->Width, Frame->Height, Frame->Pitch, Frame->Pixels);
+        }
+        else if (RenderTexture == ImTextureID_Invalid)
+        {
+            ShowResumeThumbnail();
+        }
+    }
+
     ImGui::Begin(Title().c_str(), nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
 
     if (RenderTexture != ImTextureID_Invalid)
@@ -64,6 +78,19 @@ void RenderWindow::Render()
         ImGui::Image(RenderTexture, ImageSize, ImVec2(0,0), ImVec2(1, 1));
     }
 
+    if (Source == 0 && EmulatorCoreManager::Get().IsLoadingMedia())
+    {
+        // The cursor moved past the picture, place the bar from the window's content bounds.
+        const ImVec2 RegionMin = ImGui::GetWindowContentRegionMin();
+        const ImVec2 RegionMax = ImGui::GetWindowContentRegionMax();
+        const float BarX = RegionMin.x + (RegionMax.x - RegionMin.x) * 0.25f;
+
+        ImGui::SetCursorPos({ BarX, (RegionMin.y + RegionMax.y) * 0.5f });
+        ImGui::TextUnformatted("Loading media...");
+        ImGui::SetCursorPosX(BarX);
+        ImGui::ProgressBar(EmulatorCoreManager::Get().GetMediaLoadProgress(), ImVec2((RegionMax.x - RegionMin.x) * 0.5f, 0.0f));
+    }
+
     ImGui::End();
 }
 
@@ -90,7 +117,7 @@ void RenderWindow::CreateTexture(std::uint32_t Width, std::uint32_t Height)
     RenderHeight = static_cast<float>(Height);
 }
 
-void RenderWindow::UpdateTexture(std::uint32_t Width, std::uint32_t Height, std::span<std::uint32_t> Pixels)
+void RenderWindow::UpdateTexture(std::uint32_t Width, std::uint32_t Height, std::uint32_t Pitch, std::span<const std::uint32_t> Pixels)
 {
     if (RenderWidth != Width || RenderHeight != Height)
     {
@@ -100,21 +127,28 @@ void RenderWindow::UpdateTexture(std::uint32_t Width, std::uint32_t Height, std:
 
     const GLuint TextureId = static_cast<GLuint>(static_cast<intptr_t>(RenderTexture));
     glBindTexture(GL_TEXTURE_2D, TextureId);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(Pitch));
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(Width), static_cast<GLsizei>(Height), GL_BGRA, GL_UNSIGNED_BYTE, Pixels.data());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 }
 
-void RenderWindow::RenderCallback(std::uint32_t Width, std::uint32_t Height, std::span<std::uint32_t> Pixels)
+void RenderWindow::ShowResumeThumbnail()
 {
-    // Todo: support multiple output screen
-    if (!CurrentInstances.empty() && CurrentInstances[0] != nullptr)
-    {
-        CurrentInstances[0]->UpdateTexture(Width, Height, Pixels);
-    }
+    const std::vector<std::uint16_t> Thumbnail = SaveStateManager::Get().TakeResumeThumbnail();
+
+    if (Thumbnail.empty())
+        return;
+
+    // Stands for the resumed game until its first frame, which replaces the texture as its size differs.
+    CreateTexture(ThumbnailWidth, ThumbnailHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, ThumbnailWidth, ThumbnailHeight, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, Thumbnail.data());
 }
 
 void RenderWindow::OnEmulationCoreStart(IEmulatorCore* Emulator)
 {
-    Emulator->SetRenderCallback(&RenderWindow::RenderCallback);
+    DestroyTexture();
 }
 
 void RenderWindow::OnEmulationCoreStop()
@@ -25,14 +25,12 @@ public:
 private:
     void DestroyTexture();
     void CreateTexture(std::uint32_t Width, std::uint32_t Height);
-    void UpdateTexture(std::uint32_t Width, std::uint32_t Height, std::span<std::uint32_t> Pixels);
+    void UpdateTexture(std::uint32_t Width, std::uint32_t Height, std::uint32_t Pitch, std::span<const std::uint32_t> Pixels);
+    void ShowResumeThumbnail();
 
     ImTextureID RenderTexture = ImTextureID_Invalid;
     float RenderWidth = 0;
     float RenderHeight = 0;
     std::uint32_t Source = 0;
     std::string TitleName;
-
-    static void RenderCallback(std::uint32_t Width, std::uint32_t Height, std::span<std::uint32_t> Pixels);
-    static std::vector<RenderWindow*> CurrentInstances;
 };
@@ -259,7 +259,7 @@ void ImGuiUtil_OpenModalFileDialog(const std::string& Title, const std::string&
     Config.path = Path;
     Config.flags = ImGuiFileDialogFlags_Modal;
 
-    ImGuiFileDialog::Instance()->OpenDialog(Key, Title, Filter.c_str(), Config);
+    ImGuiFileDialog::Instance()->OpenDialog(Key, Title, Filter.empty() ? nullptr : Filter.c_str(), Config);
     FileDialogIdAndCallback[Key] = Callback;
 }
 
@@ -14,6 +14,7 @@ bool ImGuiUtil_RemoveMenuItem(const std::string& Path);
 void ImGuiUtil_DisplayMenuBar();
 void ImGuiUtil_UpdateShortcut();
 
+// An empty Filter selects a directory instead of a file.
 void ImGuiUtil_OpenModalFileDialog(const std::string& Title, const std::string& Filter, const std::string_view& Path, std::function<void(const std::string_view&)> Callback, const std::string& Key = SourceLocationUniqueCStrHexId().data());
 
 #define CONCAT_IMPL(a, b) a##b
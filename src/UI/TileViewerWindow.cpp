@@ -35,6 +35,7 @@ void TileViewerWindow::OnEmulationMediaOpen(std::uint32_t MediaSource, const std
 
 void TileViewerWindow::OnEmulationCoreStop()
 {
+    Snapshot.Reset();
     MemRegion = nullptr;
 }
 
@@ -93,9 +94,10 @@ void TileViewerWindow::Render()
         ImGui::SameLine();
         ImGui::TextUnformatted("Palette:");
         ImGui::SameLine();
+        // Tiles and palettes are captured on the emulation thread, as they were a frame ago.
+        const TileSnapshot& Captured = Snapshot.Acquire();
         PaletteColors.resize(1);
-        const auto& ColorPalettes = IEmulatorCore::Current()->GetTilePreviewPalettes();
-        PaletteColors.insert(PaletteColors.end(), ColorPalettes.begin(), ColorPalettes.end());
+        PaletteColors.insert(PaletteColors.end(), Captured.Palettes.begin(), Captured.Palettes.end());
         std::string PaletteNames = "Default Generic";
         PaletteNames += '\0';
         for (uint32_t PaletteIndex = 1; PaletteIndex < PaletteColors.size(); ++PaletteIndex)
@@ -126,12 +128,22 @@ void TileViewerWindow::Render()
         const std::int32_t TileByRowCount = ImageWidth / 8;
         const std::int32_t RowCount = ImageHeight / 8;
 
-        for (std::int32_t Row = 0, TileAddress = DisplayAddress; Row < RowCount; ++Row)
+        TileData.resize(static_cast<std::size_t>(std::max(RowCount * TileByRowCount * TileSize, 0)));
+        Captured.Tiles.CopyTo(MemRegion, static_cast<std::uint64_t>(DisplayAddress), TileData);
+
+        // The visible tiles are read in one block, page by page, rather than through a call per byte.
+        Snapshot.Request([Region = MemRegion, Address = static_cast<std::uint64_t>(DisplayAddress), Size = TileData.size()](IEmulatorCore& Core, TileSnapshot& Value)
+        {
+            Value.Tiles.Capture(*Region, Address, Size);
+            Value.Palettes = Core.GetTilePreviewPalettes();
+        });
+
+        for (std::int32_t Row = 0, TileOffset = 0; Row < RowCount; ++Row)
         {
             for (std::int32_t Column = 0; Column < TileByRowCount; ++Column)
             {
-                TileToImage(TileAddress, Column * 8, Row * 8);
-                TileAddress += TileSize;
+                TileToImage(std::span(TileData).subspan(static_cast<std::size_t>(TileOffset), static_cast<std::size_t>(TileSize)), Column * 8, Row * 8);
+                TileOffset += TileSize;
             }
         }
 
@@ -209,14 +221,13 @@ void TileViewerWindow::UpdateTexture(ImTextureID TextureID, std::span<std::uint3
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(Width), static_cast<GLsizei>(Height), GL_RGBA, GL_UNSIGNED_BYTE, Pixels.data());
 }
 
-void TileViewerWindow::TileToImage(std::uint64_t MemoryAddress, std::size_t OutputX, std::size_t OutputY)
+void TileViewerWindow::TileToImage(std::span<const std::byte> Tile, std::size_t OutputX, std::size_t OutputY)
 {
-    auto ReadData = [&](std::uint64_t Address) -> std::uint8_t
-    {
-        if (Address <= MemRegion->EndAddress && Address >= MemRegion->StartAddress)
-            return static_cast<std::uint8_t>(MemRegion->Read(Address));
+    std::size_t TileIndex = 0;
 
-        return 0;
+    auto ReadData = [&]() -> std::uint8_t
+    {
+        return static_cast<std::uint8_t>(Tile[TileIndex++]);
     };
     auto WritePixel = [&](std::size_t Index, std::size_t X, std::size_t Y)
     {
@@ -229,8 +240,8 @@ void TileViewerWindow::TileToImage(std::uint64_t MemoryAddress, std::size_t Outp
     case TileFormat::GB_2BP:
         for (std::size_t TileY = 0; TileY < 8; ++TileY)
         {
-            const std::uint8_t LowByte = ReadData(MemoryAddress++);
-            const std::uint8_t HighByte = ReadData(MemoryAddress++);
+            const std::uint8_t LowByte = ReadData();
+            const std::uint8_t HighByte = ReadData();
             for (std::size_t TileX = 0; TileX < 8; ++TileX)
             {
                 const std::size_t BitIndex = 7 - TileX;
@@ -242,16 +253,16 @@ void TileViewerWindow::TileToImage(std::uint64_t MemoryAddress, std::size_t Outp
     case TileFormat::Genesis_4BPP:
         for (std::size_t TileY = 0; TileY < 8; ++TileY)
         {
-            std::uint8_t Data = ReadData(MemoryAddress++);
+            std::uint8_t Data = ReadData();
             WritePixel(Data >> 4, OutputX, OutputY + TileY);
             WritePixel(Data & 0xf, OutputX + 1, OutputY + TileY);
-            Data = ReadData(MemoryAddress++);
+            Data = ReadData();
             WritePixel(Data >> 4, OutputX + 2, OutputY + TileY);
             WritePixel(Data & 0xf, OutputX + 3, OutputY + TileY);
-            Data = ReadData(MemoryAddress++);
+            Data = ReadData();
             WritePixel(Data >> 4, OutputX + 4, OutputY + TileY);
             WritePixel(Data & 0xf, OutputX + 5, OutputY + TileY);
-            Data = ReadData(MemoryAddress++);
+            Data = ReadData();
             WritePixel(Data >> 4, OutputX + 6, OutputY + TileY);
             WritePixel(Data & 0xf, OutputX + 7, OutputY + TileY);
         }
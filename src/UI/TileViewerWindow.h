@@ -1,6 +1,7 @@
 #pragma once
 
 #include "IWindow.h"
+#include "UI/CoreSnapshot.h"
 #include "Util/HashUtil.h"
 
 enum class TileFormat
@@ -9,6 +10,12 @@ enum class TileFormat
     Genesis_4BPP
 };
 
+struct TileSnapshot
+{
+    MemoryBlock Tiles;
+    std::vector<std::array<std::uint32_t, 256>> Palettes;
+};
+
 class TileViewerWindow : public IWindow
 {
 public:
@@ -29,7 +36,7 @@ private:
     static void DestroyTexture(ImTextureID& TextureID);
     static void UpdateTexture(ImTextureID TextureID, std::span<std::uint32_t> Pixels, std::int32_t Width, std::int32_t Height);
 
-    void TileToImage(std::uint64_t MemoryAddress, std::size_t OutputX, std::size_t OutputY);
+    void TileToImage(std::span<const std::byte> Tile, std::size_t OutputX, std::size_t OutputY);
     void InitDefaultPalette();
 
     TileFormat Format = TileFormat::Genesis_4BPP;
@@ -38,6 +45,8 @@ private:
     std::string MemoryRegionNames;
     std::int32_t SelectedMemoryRegion = 0;
     std::int32_t DisplayAddress = 0;
+    std::vector<std::byte> TileData;
+    CoreSnapshot<TileSnapshot> Snapshot;
 
     ImTextureID ImageTexture = ImTextureID_Invalid;
     std::vector<std::uint32_t> Image;
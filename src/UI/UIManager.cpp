@@ -4,6 +4,8 @@
 
 #include "MemoryViewerWindow.h"
 #include "TileViewerWindow.h"
+#include "UI/FrameTimingWindow.h"
+#include "UI/LibraryWindow.h"
 #include "UI/LogWindow.h"
 #include "UI/RenderWindow.h"
 #include "UI/ShortcutAndMenuUtils.h"
@@ -16,6 +18,8 @@ bool UIManager::Initialize()
     AddWindow<LogWindow>();
     AddWindow<MemoryViewerWindow>();
     AddWindow<TileViewerWindow>();
+    AddWindow<FrameTimingWindow>();
+    AddWindow<LibraryWindow>();
 
     return true;
 }
@@ -50,6 +54,8 @@ void UIManager::Render()
 
     for (const std::unique_ptr<IWindow>& Window : Windows)
     {
+        Window->Update();
+
         if (Window->IsOpen)
         {
             Window->Render();
@@ -65,6 +71,8 @@ void UIManager::Stop()
     RemoveWindow<LogWindow>();
     RemoveWindow<MemoryViewerWindow>();
     RemoveWindow<TileViewerWindow>();
+    RemoveWindow<FrameTimingWindow>();
+    RemoveWindow<LibraryWindow>();
 }
 
 void UIManager::OnEmulationCoreStart(IEmulatorCore* EmulatorCore)
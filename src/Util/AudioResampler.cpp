@@ -0,0 +1,160 @@
+#include "AudioResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+    double Sinc(double X)
+    {
+        return X == 0.0 ? 1.0 : std::sin(std::numbers::pi * X) / (std::numbers::pi * X);
+    }
+
+    double Blackman(double X)
+    {
+        // X in [-1, 1], zero at both ends.
+        return 0.42 + 0.5 * std::cos(std::numbers::pi * X) + 0.08 * std::cos(2.0 * std::numbers::pi * X);
+    }
+
+    std::int16_t ToSample(float Value)
+    {
+        return static_cast<std::int16_t>(std::lrint(std::clamp(Value * 32768.0f, -32768.0f, 32767.0f)));
+    }
+}
+
+void AudioResampler::Reset(double InputRate, double OutputRate, std::size_t MaxInputFrames)
+{
+    BaseStep = InputRate > 0.0 && OutputRate > 0.0 ? InputRate / OutputRate : 1.0;
+    Step = BaseStep;
+    Position = 0.0;
+    SmoothedFillRatio = 0.5;
+
+    // Low-pass below the smaller Nyquist frequency, with some room for the transition band of a short kernel.
+    const double Cutoff = std::min(1.0, 1.0 / BaseStep) * 0.91;
+    constexpr double HalfWidth = TapCount / 2.0;
+
+    Coefficients.assign((PhaseCount + 1) * TapCount, 0.0f);
+
+    for (std::size_t Phase = 0; Phase <= PhaseCount; ++Phase)
+    {
+        const double Fraction = static_cast<double>(Phase) / PhaseCount;
+        float* Row = &Coefficients[Phase * TapCount];
+        double Sum = 0.0;
+
+        for (std::size_t Tap = 0; Tap < TapCount; ++Tap)
+        {
+            // Tap distance to the output instant, which lies Fraction after the center tap.
+            const double Distance = static_cast<double>(Tap) - (HalfWidth - 1.0) - Fraction;
+            const double Value = Cutoff * Sinc(Cutoff * Distance) * Blackman(Distance / HalfWidth);
+            Row[Tap] = static_cast<float>(Value);
+            Sum += Value;
+        }
+
+        // Unity gain at DC for every phase, otherwise the interpolation between phases turns into a buzz.
+        for (std::size_t Tap = 0; Tap < TapCount; ++Tap)
+            Row[Tap] = static_cast<float>(Row[Tap] / Sum);
+    }
+
+    HistoryFrames = TapCount - 1;
+    for (std::vector<float>& Channel : History)
+        Channel.assign(MaxInputFrames + TapCount, 0.0f);
+
+    Output.clear();
+    Reserve(MaxInputFrames);
+}
+
+void AudioResampler::Reserve(std::size_t InputFrames)
+{
+    if (History[0].size() < HistoryFrames + InputFrames)
+    {
+        for (std::vector<float>& Channel : History)
+            Channel.resize(HistoryFrames + InputFrames);
+    }
+
+    const std::size_t MaxOutputFrames = static_cast<std::size_t>(std::ceil((HistoryFrames + InputFrames) / (BaseStep * (1.0 - MaxRateAdjustment)))) + 1;
+    Output.reserve(MaxOutputFrames * ChannelCount);
+}
+
+std::span<const std::int16_t> AudioResampler::Process(std::span<const std::int16_t> Input, double FillRatio)
+{
+    const std::size_t InputFrames = Input.size() / ChannelCount;
+    Reserve(InputFrames);
+
+    if (FillRatio >= 0.0)
+    {
+        // The device drains the queue in large chunks, smooth the level so the ratio does not follow the sawtooth.
+        SmoothedFillRatio += (std::clamp(FillRatio, 0.0, 1.0) - SmoothedFillRatio) * 0.05;
+        Step = BaseStep / (1.0 + MaxRateAdjustment * (1.0 - 2.0 * SmoothedFillRatio));
+    }
+    else
+    {
+        Step = BaseStep;
+    }
+
+    float* Left = History[0].data();
+    float* Right = History[1].data();
+
+    for (std::size_t Frame = 0; Frame < InputFrames; ++Frame)
+    {
+        Left[HistoryFrames + Frame] = static_cast<float>(Input[Frame * ChannelCount + 0]) * (1.0f / 32768.0f);
+        Right[HistoryFrames + Frame] = static_cast<float>(Input[Frame * ChannelCount + 1]) * (1.0f / 32768.0f);
+    }
+
+    HistoryFrames += InputFrames;
+    Output.clear();
+
+    alignas(32) std::array<float, TapCount> Kernel;
+
+    while (static_cast<std::size_t>(Position) + TapCount <= HistoryFrames)
+    {
+        const std::size_t First = static_cast<std::size_t>(Position);
+        const double PhasePosition = (Position - static_cast<double>(First)) * PhaseCount;
+        const std::size_t Phase = static_cast<std::size_t>(PhasePosition);
+        const float Blend = static_cast<float>(PhasePosition - static_cast<double>(Phase));
+
+        const float* Row0 = &Coefficients[Phase * TapCount];
+        const float* Row1 = Row0 + TapCount;
+
+        for (std::size_t Tap = 0; Tap < TapCount; ++Tap)
+            Kernel[Tap] = Row0[Tap] + Blend * (Row1[Tap] - Row0[Tap]);
+
+        // Fixed-width partial sums keep the loops free of a serial dependency, so they vectorize without fast-math.
+        std::array<float, LaneCount> LeftSum = {};
+        std::array<float, LaneCount> RightSum = {};
+
+        for (std::size_t Tap = 0; Tap < TapCount; Tap += LaneCount)
+        {
+            for (std::size_t Lane = 0; Lane < LaneCount; ++Lane)
+            {
+                LeftSum[Lane] += Kernel[Tap + Lane] * Left[First + Tap + Lane];
+                RightSum[Lane] += Kernel[Tap + Lane] * Right[First + Tap + Lane];
+            }
+        }
+
+        float LeftValue = 0.0f;
+        float RightValue = 0.0f;
+
+        for (std::size_t Lane = 0; Lane < LaneCount; ++Lane)
+        {
+            LeftValue += LeftSum[Lane];
+            RightValue += RightSum[Lane];
+        }
+
+        Output.push_back(ToSample(LeftValue));
+        Output.push_back(ToSample(RightValue));
+        Position += Step;
+    }
+
+    // Keep only the frames the next outputs still reach.
+    const std::size_t ConsumedFrames = std::min(static_cast<std::size_t>(Position), HistoryFrames);
+    const std::size_t RemainingFrames = HistoryFrames - ConsumedFrames;
+
+    for (std::vector<float>& Channel : History)
+        std::copy_n(Channel.begin() + static_cast<std::ptrdiff_t>(ConsumedFrames), RemainingFrames, Channel.begin());
+
+    HistoryFrames = RemainingFrames;
+    Position -= static_cast<double>(ConsumedFrames);
+
+    return Output;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Interleaved stereo resampler converting the core sample rate to the audio device rate.
+// Polyphase windowed-sinc: the kernel is tabulated for PhaseCount sub-sample offsets and linearly interpolated
+// between two neighbouring phases, so any pair of rates works without a rational ratio.
+// Dynamic rate control: the ratio is nudged by at most MaxRateAdjustment from the consumer queue fill level, which
+// absorbs the drift between the emulated frame rate and the device clock without audible pitch changes.
+class AudioResampler
+{
+public:
+    static constexpr double MaxRateAdjustment = 0.005;
+
+    // Allocates the kernel and the working buffers, Process() does not allocate for inputs up to MaxInputFrames.
+    void Reset(double InputRate, double OutputRate, std::size_t MaxInputFrames = 4096);
+
+    // FillRatio is the level in [0, 1] of the queue fed by the output, a negative value disables rate control.
+    // The returned samples are valid until the next call.
+    [[nodiscard]] std::span<const std::int16_t> Process(std::span<const std::int16_t> Input, double FillRatio);
+
+    // Output samples per input sample, including the current rate control adjustment.
+    [[nodiscard]] double GetEffectiveRatio() const { return Step > 0.0 ? 1.0 / Step : 0.0; }
+
+private:
+    static constexpr std::size_t ChannelCount = 2;
+    static constexpr std::size_t TapCount = 32;
+    static constexpr std::size_t PhaseCount = 128;
+    static constexpr std::size_t LaneCount = 8;
+    static_assert(TapCount % LaneCount == 0);
+
+    void Reserve(std::size_t InputFrames);
+
+    double BaseStep = 1.0;
+    double Step = 1.0;
+    double Position = 0.0;
+    double SmoothedFillRatio = 0.5;
+
+    // (PhaseCount + 1) rows of TapCount coefficients, the extra row lets the last phase interpolate without a branch.
+    std::vector<float> Coefficients;
+
+    // Planar history: the TapCount - 1 frames still needed by the kernel followed by the new input.
+    std::array<std::vector<float>, ChannelCount> History;
+    std::size_t HistoryFrames = 0;
+
+    std::vector<std::int16_t> Output;
+};
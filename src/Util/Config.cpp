@@ -1,75 +1,291 @@
 #include "Config.h"
 
+#include <algorithm>
+#include <charconv>
 #include <fstream>
-#include <sstream>
+#include <iostream>
+#include <span>
 #include "SDL.h"
 
+#include "Util/StateFile.h"
+#include "Util/StringUtil.h"
+
+Config::~Config()
+{
+    if (WriterThread.joinable())
+    {
+        WriterThread.request_stop();
+        SaveSignal.notify_all();
+        WriterThread.join();
+    }
+
+    // Changes made during the last quiet period.
+    Flush();
+}
+
+ConfigKey Config::Intern(std::string_view Name)
+{
+    std::scoped_lock Lock(Mutex);
+
+    if (const auto Found = KeysByName.find(Name); Found != KeysByName.end())
+        return ConfigKey(Found->second);
+
+    const std::uint32_t Index = static_cast<std::uint32_t>(Entries.size());
+    Entries.emplace_back().Name = Name;
+    KeysByName.emplace(std::string(Name), Index);
+    return ConfigKey(Index);
+}
+
+ConfigKey Config::FindKey(std::string_view Name) const
+{
+    std::scoped_lock Lock(Mutex);
+    const auto Found = KeysByName.find(Name);
+    return Found != KeysByName.end() ? ConfigKey(Found->second) : ConfigKey();
+}
+
+bool Config::HasValue(ConfigKey Key) const
+{
+    std::scoped_lock Lock(Mutex);
+    return Key.IsValid() && Entries[Key.GetIndex()].HasValue;
+}
+
+std::string Config::GetValue(ConfigKey Key, std::string_view DefaultValue) const
+{
+    std::scoped_lock Lock(Mutex);
+
+    if (!Key.IsValid() || !Entries[Key.GetIndex()].HasValue)
+        return std::string(DefaultValue);
+
+    return Entries[Key.GetIndex()].Value;
+}
+
+void Config::SetValue(ConfigKey Key, std::string_view Value)
+{
+    if (!Key.IsValid())
+        return;
+
+    {
+        std::scoped_lock Lock(Mutex);
+        Entry& Setting = Entries[Key.GetIndex()];
+
+        if (Setting.HasValue && Setting.Value == Value)
+            return;
+
+        Setting.Value = Value;
+        Setting.HasValue = true;
+        Setting.Revision.fetch_add(1, std::memory_order_release);
+    }
+
+    Notify(Key);
+    Save();
+}
+
+std::uint64_t Config::GetRevision(ConfigKey Key) const
+{
+    if (!Key.IsValid())
+        return 0;
+
+    // Entries never move, only the growth of the deque itself needs the lock.
+    std::scoped_lock Lock(Mutex);
+    return Entries[Key.GetIndex()].Revision.load(std::memory_order_acquire);
+}
+
+std::uint32_t Config::AddListener(ConfigKey Key, ConfigListener Function)
+{
+    std::scoped_lock Lock(ListenerMutex);
+    Listeners.push_back({ NextListenerId, Key, std::move(Function) });
+    return NextListenerId++;
+}
+
+void Config::RemoveListener(std::uint32_t ListenerId)
+{
+    std::scoped_lock Lock(ListenerMutex);
+    std::erase_if(Listeners, [ListenerId](const Listener& Entry) { return Entry.Id == ListenerId; });
+}
+
+void Config::Notify(ConfigKey Key)
+{
+    // Copied, so a listener may add or remove listeners.
+    std::vector<ConfigListener> Functions;
+
+    {
+        std::scoped_lock Lock(ListenerMutex);
+
+        for (const Listener& Entry : Listeners)
+        {
+            if (Entry.Key == Key)
+                Functions.push_back(Entry.Function);
+        }
+    }
+
+    for (const ConfigListener& Function : Functions)
+        Function(Key);
+}
+
+bool Config::HasKey(std::string_view Name) const
+{
+    const ConfigKey Key = FindKey(Name);
+    return Key.IsValid() && HasValue(Key);
+}
+
+std::string Config::Get(std::string_view Name, std::string_view DefaultValue) const
+{
+    return GetValue(FindKey(Name), DefaultValue);
+}
+
 void Config::SetArray(const std::string& Key, const std::vector<std::string>& Values)
 {
     const std::string StartKey = Key + "[";
-    erase_if(Data, [&StartKey](const auto& KeyValue) { return KeyValue.first.starts_with(StartKey); });
+    std::vector<ConfigKey> RemovedKeys;
 
-    for (std::size_t Index = 0; Index < Values.size(); ++Index)
     {
-        std::stringstream KeyStream;
-        KeyStream << Key << "[" << Index << "]";
-        Data[KeyStream.str()] = Values[Index];
+        std::scoped_lock Lock(Mutex);
+
+        for (std::uint32_t Index = 0; Index < Entries.size(); ++Index)
+        {
+            Entry& Setting = Entries[Index];
+
+            if (Setting.HasValue && Setting.Name.starts_with(StartKey))
+            {
+                Setting.HasValue = false;
+                Setting.Value.clear();
+                Setting.Revision.fetch_add(1, std::memory_order_release);
+                RemovedKeys.emplace_back(Index);
+            }
+        }
     }
+
+    for (const ConfigKey RemovedKey : RemovedKeys)
+        Notify(RemovedKey);
+
+    for (std::size_t Index = 0; Index < Values.size(); ++Index)
+        Set(StartKey + std::to_string(Index) + "]", Values[Index]);
+
+    Save();
 }
 
 void Config::GetArray(const std::string& Key, std::vector<std::string>& Values) const
 {
-    using IndexAndKey = std::tuple<std::size_t, std::string>;
+    Values.clear();
 
-    auto SetKeyIndex = [&](std::size_t Index) -> IndexAndKey
+    for (std::size_t Index = 0;; ++Index)
     {
-        std::stringstream KeyStream;
-        KeyStream << Key << "[" << Index << "]";
-        return { Index, KeyStream.str() };
-    };
+        const ConfigKey ElementKey = FindKey(Key + "[" + std::to_string(Index) + "]");
 
-    Values.clear();
+        if (!ElementKey.IsValid() || !HasValue(ElementKey))
+            break;
+
+        Values.push_back(GetValue(ElementKey, {}));
+    }
+}
 
-    for (IndexAndKey IndexKey = SetKeyIndex(0); HasKey(std::get<1>(IndexKey)); IndexKey = SetKeyIndex(std::get<0>(IndexKey) + 1))
+void Config::Save()
+{
     {
-        Values.push_back(Data.at(std::get<1>(IndexKey)));
+        std::scoped_lock Lock(Mutex);
+
+        if (!IsPersistent)
+            return;
+
+        IsSavePending = true;
+        SaveDeadline = Clock::now() + SaveDelay;
     }
+
+    SaveSignal.notify_one();
 }
 
-void Config::Save() const
+void Config::Flush()
 {
-    if (std::ofstream ConfigStream { FilePath, std::ios::trunc })
+    // Keeps an explicit flush and the writer thread from replacing the file at the same time.
+    std::scoped_lock WriteLock(WriteMutex);
+
     {
-        std::string_view CurrentSection;
+        std::scoped_lock Lock(Mutex);
 
-        for (const auto& [FullKey, Value] : Data)
+        if (!IsSavePending)
+            return;
+
+        IsSavePending = false;
+    }
+
+    const std::string Contents = Serialize();
+
+    if (const std::error_code Error = WriteFileAtomically(FilePath, std::as_bytes(std::span(Contents))))
+        std::cerr << "Unable to save the configuration " << FilePath << ": " << Error.message() << '\n';
+}
+
+void Config::WriterThreadMain(std::stop_token StopToken)
+{
+    std::unique_lock Lock(Mutex);
+
+    while (!StopToken.stop_requested())
+    {
+        SaveSignal.wait(Lock, StopToken, [this] { return IsSavePending; });
+
+        // Every change pushes the deadline back, the file is written once things are quiet.
+        while (IsSavePending && Clock::now() < SaveDeadline && !StopToken.stop_requested())
+            SaveSignal.wait_until(Lock, StopToken, SaveDeadline, [] { return false; });
+
+        if (StopToken.stop_requested())
+            break;
+
+        Lock.unlock();
+        Flush();
+        Lock.lock();
+    }
+}
+
+std::string Config::Serialize() const
+{
+    std::vector<std::pair<std::string, std::string>> Values;
+
+    {
+        std::scoped_lock Lock(Mutex);
+
+        for (const Entry& Setting : Entries)
         {
-            std::string_view Section;
-            std::string_view Key = FullKey;
+            if (Setting.HasValue)
+                Values.emplace_back(Setting.Name, Setting.Value);
+        }
+    }
 
-            if (const std::size_t Index = FullKey.rfind('.'); Index != std::string::npos)
-            {
-                Section = Key.substr(0, Index);
-                Key = Key.substr(Index + 1);
-            }
+    std::ranges::sort(Values);
 
-            if (Section != CurrentSection)
-            {
-                CurrentSection = Section;
-                ConfigStream << "\n[" << Section << "]\n";
-            }
+    std::string Contents;
+    std::string_view CurrentSection;
 
-            ConfigStream << Key << "=" << Value << "\n";
+    for (const auto& [FullKey, Value] : Values)
+    {
+        std::string_view Section;
+        std::string_view Key = FullKey;
+
+        if (const std::size_t Index = FullKey.rfind('.'); Index != std::string::npos)
+        {
+            Section = Key.substr(0, Index);
+            Key = Key.substr(Index + 1);
         }
+
+        if (Section != CurrentSection)
+        {
+            CurrentSection = Section;
+            Contents += "\n[";
+            Contents += Section;
+            Contents += "]\n";
+        }
+
+        Contents += Key;
+        Contents += '=';
+        Contents += Value;
+        Contents += '\n';
     }
+
+    return Contents;
 }
 
 bool Config::Load()
 {
     if (std::ifstream ConfigFile { FilePath })
     {
-        Data.clear();
-
         std::string CurrentSection;
 
         for (std::string Line; std::getline(ConfigFile, Line);)
@@ -88,26 +304,95 @@ bool Config::Load()
                     std::string Key = CurrentSection;
                     Key += '.';
                     Key += std::string_view(Line).substr(0, EqualIndex);
-                    Data[Key] = std::string_view(Line).substr(EqualIndex + 1);
+                    Set(Key, std::string_view(Line).substr(EqualIndex + 1));
                 }
                 else
                 {
-                    Data[CurrentSection + "." + Line] = "";
+                    Set(CurrentSection + "." + Line, "");
                 }
             }
         }
+    }
 
-        return true;
+    if (FilePath.empty())
+        return false;
+
+    {
+        std::scoped_lock Lock(Mutex);
+        IsPersistent = true;
+        IsSavePending = false;
     }
 
-    return false;
+    if (!WriterThread.joinable())
+        WriterThread = std::jthread([this](std::stop_token StopToken) { WriterThreadMain(StopToken); });
+
+    return true;
 }
 
 Config::Config()
 {
     if (char* PrePath = SDL_GetPrefPath("MeraCorp", "Ultipugna"))
     {
-        FilePath = std::string(PrePath) + "Config.ini";
+        PreferencePath = PrePath;
+        FilePath = PreferencePath + "Config.ini";
         SDL_free(PrePath);
     }
 }
+
+bool ParseConfigValue(std::string_view Text, bool& Value)
+{
+    if (Text != "True" && Text != "False")
+        return false;
+
+    Value = Text == "True";
+    return true;
+}
+
+bool ParseConfigValue(std::string_view Text, std::int32_t& Value)
+{
+    return StringToNumber(Text, Value);
+}
+
+bool ParseConfigValue(std::string_view Text, std::uint32_t& Value)
+{
+    return StringToNumber(Text, Value);
+}
+
+bool ParseConfigValue(std::string_view Text, float& Value)
+{
+    return std::from_chars(Text.data(), Text.data() + Text.size(), Value).ec == std::errc{};
+}
+
+bool ParseConfigValue(std::string_view Text, std::string& Value)
+{
+    Value = Text;
+    return true;
+}
+
+std::string FormatConfigValue(bool Value)
+{
+    return Value ? "True" : "False";
+}
+
+std::string FormatConfigValue(std::int32_t Value)
+{
+    return std::to_string(Value);
+}
+
+std::string FormatConfigValue(std::uint32_t Value)
+{
+    return std::to_string(Value);
+}
+
+std::string FormatConfigValue(float Value)
+{
+    // Shortest text reading back as the same float, std::to_string would round to six decimals.
+    char Buffer[32];
+    const std::to_chars_result Result = std::to_chars(Buffer, Buffer + sizeof(Buffer), Value);
+    return std::string(Buffer, Result.ptr);
+}
+
+std::string FormatConfigValue(const std::string& Value)
+{
+    return Value;
+}
@@ -1,9 +1,45 @@
 #pragma once
 
-#include <map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+// Interned configuration key, resolved once from its name and valid for the lifetime of the process.
+class ConfigKey
+{
+public:
+    static constexpr std::uint32_t InvalidIndex = UINT32_MAX;
+
+    constexpr ConfigKey() = default;
+    constexpr explicit ConfigKey(std::uint32_t Index) : Index(Index) {}
+
+    [[nodiscard]] constexpr bool IsValid() const { return Index != InvalidIndex; }
+    [[nodiscard]] constexpr std::uint32_t GetIndex() const { return Index; }
+
+    constexpr bool operator==(const ConfigKey&) const = default;
+
+private:
+    std::uint32_t Index = InvalidIndex;
+};
+
+// Called on the thread which changed the value.
+using ConfigListener = std::function<void(ConfigKey Key)>;
+
+// Settings stored as strings, persisted as an INI file (the last '.' of a key separates its section).
+// Values are accessed through interned keys: the name is only hashed once, each key carries a revision so typed
+// handles (ConfigSetting) parse a value only after it changed. Once Load() was called, every change schedules a
+// save which a background thread writes atomically after a short quiet period, so a burst of changes costs one write
+// and the UI thread never waits on the disk. A config that was never loaded (the headless tools) is never written.
 class Config
 {
 public:
@@ -11,21 +47,136 @@ public:
 
     Config(const Config&) = delete;
     Config& operator=(const Config&) = delete;
+    ~Config();
 
-    [[nodiscard]] std::string& operator[](const std::string& Key) { return Data[Key]; }
-    [[nodiscard]] const std::string& operator[](const std::string& Key) const { return Data.at(Key); }
-    [[nodiscard]] bool HasKey(const std::string& Key) const { return Data.contains(Key); }
-    [[nodiscard]] const std::string& Get(const std::string& Key, const std::string& DefaultValue) const { return HasKey(Key) ? Data.at(Key) : DefaultValue; }
+    // Any thread.
+    [[nodiscard]] ConfigKey Intern(std::string_view Name);
+    [[nodiscard]] bool HasValue(ConfigKey Key) const;
+    [[nodiscard]] std::string GetValue(ConfigKey Key, std::string_view DefaultValue) const;
+    void SetValue(ConfigKey Key, std::string_view Value);
+    // Incremented by every change of the value.
+    [[nodiscard]] std::uint64_t GetRevision(ConfigKey Key) const;
+
+    [[nodiscard]] std::uint32_t AddListener(ConfigKey Key, ConfigListener Listener);
+    void RemoveListener(std::uint32_t ListenerId);
+
+    // By name, for the places reading a setting once.
+    [[nodiscard]] bool HasKey(std::string_view Name) const;
+    [[nodiscard]] std::string Get(std::string_view Name, std::string_view DefaultValue) const;
+    void Set(std::string_view Name, std::string_view Value) { SetValue(Intern(Name), Value); }
 
     void SetArray(const std::string& Key, const std::vector<std::string>& Values);
     void GetArray(const std::string& Key, std::vector<std::string>& Values) const;
 
-    void Save() const;
+    // Schedules a save, changes already do it on their own.
+    void Save();
+    // Writes the pending changes now, on the calling thread.
+    void Flush();
+    // Reads the file and enables saving, a missing file is an empty config.
     bool Load();
 
+    // Per-user writable folder (with a trailing separator) holding the config and the other persistent files.
+    [[nodiscard]] const std::string& GetPreferencePath() const { return PreferencePath; }
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    // Quiet period after the last change before the file is written.
+    static constexpr std::chrono::milliseconds SaveDelay { 500 };
+
+    struct Entry
+    {
+        std::string Name;
+        std::string Value;
+        bool HasValue = false;
+        std::atomic<std::uint64_t> Revision = 0;
+    };
+
+    struct Listener
+    {
+        std::uint32_t Id;
+        ConfigKey Key;
+        ConfigListener Function;
+    };
+
+    struct NameHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view Name) const { return std::hash<std::string_view>{}(Name); }
+    };
+
     Config();
 
-    std::map<std::string, std::string> Data;
+    [[nodiscard]] ConfigKey FindKey(std::string_view Name) const;
+    void Notify(ConfigKey Key);
+    void WriterThreadMain(std::stop_token StopToken);
+    [[nodiscard]] std::string Serialize() const;
+
+    mutable std::mutex Mutex;
+    std::deque<Entry> Entries; // Indexed by ConfigKey, never shrinks so references stay valid.
+    std::unordered_map<std::string, std::uint32_t, NameHash, std::equal_to<>> KeysByName;
+
+    std::mutex ListenerMutex;
+    std::vector<Listener> Listeners;
+    std::uint32_t NextListenerId = 1;
+
+    std::mutex WriteMutex;
+    bool IsPersistent = false;
+    bool IsSavePending = false;
+    Clock::time_point SaveDeadline;
+    std::condition_variable_any SaveSignal;
+    std::jthread WriterThread;
+
     std::string FilePath;
-};
\ No newline at end of file
+    std::string PreferencePath;
+};
+
+// Parsing and formatting of the typed settings, false when the text is not a valid value.
+bool ParseConfigValue(std::string_view Text, bool& Value);
+bool ParseConfigValue(std::string_view Text, std::int32_t& Value);
+bool ParseConfigValue(std::string_view Text, std::uint32_t& Value);
+bool ParseConfigValue(std::string_view Text, float& Value);
+bool ParseConfigValue(std::string_view Text, std::string& Value);
+[[nodiscard]] std::string FormatConfigValue(bool Value);
+[[nodiscard]] std::string FormatConfigValue(std::int32_t Value);
+[[nodiscard]] std::string FormatConfigValue(std::uint32_t Value);
+[[nodiscard]] std::string FormatConfigValue(float Value);
+[[nodiscard]] std::string FormatConfigValue(const std::string& Value);
+
+// Typed handle on one setting, with its default. Get() only parses again after the value changed, so it is cheap
+// enough for every frame. A handle caches its value, so each thread uses its own.
+template<typename Type>
+class ConfigSetting
+{
+public:
+    ConfigSetting(std::string_view Name, Type DefaultValue)
+        : Key(Config::Instance().Intern(Name))
+        , DefaultValue(std::move(DefaultValue))
+    {
+    }
+
+    [[nodiscard]] ConfigKey GetKey() const { return Key; }
+
+    [[nodiscard]] const Type& Get() const
+    {
+        Config& Registry = Config::Instance();
+
+        if (const std::uint64_t Revision = Registry.GetRevision(Key); Revision != CachedRevision)
+        {
+            if (!Registry.HasValue(Key) || !ParseConfigValue(Registry.GetValue(Key, {}), CachedValue))
+                CachedValue = DefaultValue;
+
+            CachedRevision = Revision;
+        }
+
+        return CachedValue;
+    }
+
+    void Set(const Type& Value) const { Config::Instance().SetValue(Key, FormatConfigValue(Value)); }
+
+private:
+    ConfigKey Key;
+    Type DefaultValue;
+    mutable Type CachedValue = {};
+    mutable std::uint64_t CachedRevision = UINT64_MAX;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct VideoFrame
+{
+    std::vector<std::uint32_t> Pixels;
+    std::uint32_t Width = 0;
+    std::uint32_t Height = 0;
+    std::uint32_t Pitch = 0; // Distance in pixels between two rows of Pixels.
+    std::uint64_t FrameNumber = 0;
+};
+
+// Lock-free triple buffer handing finished frames from one producer thread to one consumer thread.
+// The producer always has a private back buffer to write into and the consumer always reads the most
+// recently published frame, so neither side ever waits on the other. Frames published while the consumer
+// is busy are overwritten, which is the intended behavior for display.
+class FrameMailbox
+{
+public:
+    // Producer side: buffer to fill before calling Publish().
+    [[nodiscard]] VideoFrame& BeginWrite() { return Buffers[WriteIndex]; }
+
+    // Returns true if the previously published frame was never acquired and got overwritten.
+    bool Publish()
+    {
+        const std::uint8_t PreviousState = SharedState.exchange(WriteIndex | DirtyFlag, std::memory_order_acq_rel);
+        WriteIndex = PreviousState & IndexMask;
+        return (PreviousState & DirtyFlag) != 0;
+    }
+
+    // Consumer side: returns the latest published frame, or nullptr if nothing new was published since the
+    // last call. The returned frame stays valid until the next call to Acquire().
+    [[nodiscard]] const VideoFrame* Acquire()
+    {
+        if ((SharedState.load(std::memory_order_relaxed) & DirtyFlag) == 0)
+            return nullptr;
+
+        ReadIndex = SharedState.exchange(ReadIndex, std::memory_order_acq_rel) & IndexMask;
+        return &Buffers[ReadIndex];
+    }
+
+    // Most recently published frame, acquired or not, nullptr if none. Must only be called by the consumer while the
+    // producer is stopped.
+    [[nodiscard]] const VideoFrame* GetLatest() const
+    {
+        const std::uint8_t State = SharedState.load(std::memory_order_acquire);
+        const VideoFrame& Frame = Buffers[(State & DirtyFlag) != 0 ? State & IndexMask : ReadIndex];
+        return Frame.Width != 0 ? &Frame : nullptr;
+    }
+
+    // Forgets any pending frame, must only be called while the producer is stopped.
+    void Clear()
+    {
+        WriteIndex = 0;
+        ReadIndex = 1;
+        SharedState.store(2, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::uint8_t IndexMask = 0x3;
+    static constexpr std::uint8_t DirtyFlag = 0x4;
+
+    std::array<VideoFrame, 3> Buffers;
+    std::uint8_t WriteIndex = 0;
+    std::uint8_t ReadIndex = 1;
+    std::atomic<std::uint8_t> SharedState = 2;
+};
@@ -0,0 +1,224 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double NanosecondsPerSecond = 1'000'000'000.0;
+}
+
+std::string_view PacingStrategyName(PacingStrategy Strategy)
+{
+    switch (Strategy)
+    {
+        case PacingStrategy::AudioClock: return "AudioClock";
+        case PacingStrategy::VSync: return "VSync";
+        case PacingStrategy::WallClock: break;
+    }
+
+    return "WallClock";
+}
+
+PacingStrategy PacingStrategyFromName(std::string_view Name)
+{
+    if (Name == "AudioClock")
+        return PacingStrategy::AudioClock;
+
+    if (Name == "VSync")
+        return PacingStrategy::VSync;
+
+    return PacingStrategy::WallClock;
+}
+
+void FramePacer::Reset(double RefreshRate, std::uint64_t NowNs)
+{
+    Rate = RefreshRate > 0.0 ? RefreshRate : 60.0;
+    AnchorNs = NowNs;
+    FramesSinceAnchor = 0;
+    LastRunNs = NowNs;
+    ActiveStrategy = Strategy.load(std::memory_order_relaxed);
+    ConsumedPresents = HostPresents.load(std::memory_order_relaxed);
+
+    EmulatedFrames = 0;
+    CatchUpFrames = 0;
+    MissedFrames = 0;
+    DroppedFrames = 0;
+    DuplicatedFrames = 0;
+}
+
+void FramePacer::SetRefreshRate(double RefreshRate, std::uint64_t NowNs)
+{
+    if (RefreshRate <= 0.0 || RefreshRate == Rate)
+        return;
+
+    AnchorNs = std::max(FrameTimeNs(FramesSinceAnchor), NowNs);
+    FramesSinceAnchor = 0;
+    Rate = RefreshRate;
+}
+
+std::uint32_t FramePacer::FramesToRun(std::uint64_t NowNs, double AudioFillRatio)
+{
+    PacingStrategy EffectiveStrategy = Strategy.load(std::memory_order_relaxed);
+
+    if (EffectiveStrategy == PacingStrategy::AudioClock && AudioFillRatio < 0.0)
+        EffectiveStrategy = PacingStrategy::WallClock;
+
+    // A display running far from the emulated rate (e.g. 50 Hz game on a 60 Hz screen) cannot be locked on.
+    if (EffectiveStrategy == PacingStrategy::VSync && !IsVSyncUsable(NowNs))
+        EffectiveStrategy = PacingStrategy::WallClock;
+
+    if (EffectiveStrategy != ActiveStrategy)
+    {
+        ActiveStrategy = EffectiveStrategy;
+        AnchorNs = NowNs;
+        FramesSinceAnchor = 0;
+        ConsumedPresents = HostPresents.load(std::memory_order_relaxed);
+    }
+
+    std::uint32_t FrameCount = 0;
+
+    switch (ActiveStrategy)
+    {
+        case PacingStrategy::WallClock:
+        {
+            FrameCount = WallClockFramesToRun(NowNs);
+            break;
+        }
+        case PacingStrategy::AudioClock:
+        {
+            FrameCount = AudioFillRatio < AudioTargetFillRatio ? 1 : 0;
+
+            // Never let the audio queue starve the video: if nothing was run for a long time, fall back on the clock.
+            if (FrameCount == 0 && static_cast<double>(NowNs - LastRunNs) * Rate > MaxCatchUpFrames * NanosecondsPerSecond)
+                FrameCount = 1;
+
+            break;
+        }
+        case PacingStrategy::VSync:
+        {
+            const std::uint64_t Presents = HostPresents.load(std::memory_order_acquire);
+            const std::uint64_t PendingPresents = Presents - ConsumedPresents;
+            ConsumedPresents = Presents;
+            FrameCount = static_cast<std::uint32_t>(std::min<std::uint64_t>(PendingPresents, MaxCatchUpFrames));
+
+            if (PendingPresents > FrameCount)
+                MissedFrames.fetch_add(PendingPresents - FrameCount, std::memory_order_relaxed);
+
+            break;
+        }
+    }
+
+    if (ActiveStrategy != PacingStrategy::WallClock && FrameCount != 0)
+    {
+        // Keep the clock grid aligned with the last run so falling back to WallClock does not burst frames.
+        AnchorNs = NowNs;
+        FramesSinceAnchor = 1;
+    }
+
+    if (FrameCount != 0)
+    {
+        LastRunNs = NowNs;
+        EmulatedFrames.fetch_add(FrameCount, std::memory_order_relaxed);
+        CatchUpFrames.fetch_add(FrameCount - 1, std::memory_order_relaxed);
+    }
+
+    return FrameCount;
+}
+
+std::uint64_t FramePacer::TimeUntilNextFrameNs(std::uint64_t NowNs) const
+{
+    const std::uint64_t FramePeriodNs = static_cast<std::uint64_t>(NanosecondsPerSecond / Rate);
+
+    switch (ActiveStrategy)
+    {
+        case PacingStrategy::AudioClock:
+            return FramePeriodNs / 4;
+        case PacingStrategy::VSync:
+            // Woken up early by the host present notification.
+            return FramePeriodNs;
+        case PacingStrategy::WallClock:
+            break;
+    }
+
+    const std::uint64_t NextFrameNs = FrameTimeNs(FramesSinceAnchor);
+    return NextFrameNs > NowNs ? NextFrameNs - NowNs : 0;
+}
+
+void FramePacer::OnHostPresent(std::uint64_t NowNs, bool ShowedNewFrame)
+{
+    if (!ShowedNewFrame)
+        DuplicatedFrames.fetch_add(1, std::memory_order_relaxed);
+
+    if (const std::uint64_t PreviousPresentNs = LastPresentNs.exchange(NowNs, std::memory_order_relaxed); PreviousPresentNs != 0 && NowNs > PreviousPresentNs)
+    {
+        const double IntervalNs = static_cast<double>(NowNs - PreviousPresentNs);
+        const double PreviousIntervalNs = HostPresentIntervalNs.load(std::memory_order_relaxed);
+
+        // Ignore hitches (minimized window, breakpoints) when estimating the display refresh rate.
+        if (PreviousIntervalNs == 0.0)
+            HostPresentIntervalNs.store(IntervalNs, std::memory_order_relaxed);
+        else if (IntervalNs < PreviousIntervalNs * 4.0)
+            HostPresentIntervalNs.store(PreviousIntervalNs * 0.95 + IntervalNs * 0.05, std::memory_order_relaxed);
+    }
+
+    HostPresents.fetch_add(1, std::memory_order_release);
+}
+
+FramePacingStats FramePacer::GetStats() const
+{
+    FramePacingStats Stats;
+    Stats.EmulatedFrames = EmulatedFrames.load(std::memory_order_relaxed);
+    Stats.CatchUpFrames = CatchUpFrames.load(std::memory_order_relaxed);
+    Stats.MissedFrames = MissedFrames.load(std::memory_order_relaxed);
+    Stats.DroppedFrames = DroppedFrames.load(std::memory_order_relaxed);
+    Stats.DuplicatedFrames = DuplicatedFrames.load(std::memory_order_relaxed);
+    Stats.HostPresents = HostPresents.load(std::memory_order_relaxed);
+    return Stats;
+}
+
+double FramePacer::GetHostRefreshRate() const
+{
+    const double IntervalNs = HostPresentIntervalNs.load(std::memory_order_relaxed);
+    return IntervalNs > 0.0 ? NanosecondsPerSecond / IntervalNs : 0.0;
+}
+
+std::uint64_t FramePacer::FrameTimeNs(std::uint64_t FrameIndex) const
+{
+    return AnchorNs + static_cast<std::uint64_t>(std::llround(static_cast<double>(FrameIndex) * NanosecondsPerSecond / Rate));
+}
+
+std::uint32_t FramePacer::WallClockFramesToRun(std::uint64_t NowNs)
+{
+    if (NowNs < AnchorNs)
+    {
+        AnchorNs = NowNs;
+        FramesSinceAnchor = 0;
+    }
+
+    const std::uint64_t DueFrames = static_cast<std::uint64_t>(static_cast<double>(NowNs - AnchorNs) * Rate / NanosecondsPerSecond) + 1;
+
+    if (DueFrames <= FramesSinceAnchor)
+        return 0;
+
+    const std::uint64_t LateFrames = DueFrames - FramesSinceAnchor;
+    const std::uint32_t FrameCount = static_cast<std::uint32_t>(std::min<std::uint64_t>(LateFrames, MaxCatchUpFrames));
+
+    // Frames beyond the budget are skipped rather than queued, so a long hitch never turns into a burst.
+    if (LateFrames > FrameCount)
+        MissedFrames.fetch_add(LateFrames - FrameCount, std::memory_order_relaxed);
+
+    FramesSinceAnchor = DueFrames;
+    return FrameCount;
+}
+
+bool FramePacer::IsVSyncUsable(std::uint64_t NowNs) const
+{
+    // The host stopped presenting (minimized window), keep emulating on the clock meanwhile.
+    const std::uint64_t LastPresent = LastPresentNs.load(std::memory_order_relaxed);
+    if (NowNs > LastPresent && static_cast<double>(NowNs - LastPresent) * Rate > MaxCatchUpFrames * NanosecondsPerSecond)
+        return false;
+
+    const double HostRate = GetHostRefreshRate();
+    return HostRate > 0.0 && std::abs(HostRate - Rate) / Rate <= VSyncMaxRateMismatch;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+enum class PacingStrategy
+{
+    WallClock,  // Emulated frames follow the host steady clock.
+    AudioClock, // Emulated frames are produced when the audio queue runs low.
+    VSync,      // One emulated frame per host present, audio drift absorbed by rate control.
+};
+
+[[nodiscard]] std::string_view PacingStrategyName(PacingStrategy Strategy);
+[[nodiscard]] PacingStrategy PacingStrategyFromName(std::string_view Name);
+
+struct FramePacingStats
+{
+    std::uint64_t EmulatedFrames = 0;
+    std::uint64_t CatchUpFrames = 0;    // Frames run back to back to recover from a late tick.
+    std::uint64_t MissedFrames = 0;     // Frames never emulated because they exceeded the catch-up budget.
+    std::uint64_t DroppedFrames = 0;    // Emulated frames overwritten before the host could present them.
+    std::uint64_t DuplicatedFrames = 0; // Host presents that showed the same emulated frame again.
+    std::uint64_t HostPresents = 0;
+};
+
+// Decides when the emulation thread runs frames. All times are steady clock nanoseconds supplied by the caller,
+// so the pacer itself holds no clock and can be driven by a simulated timeline.
+// FramesToRun() and TimeUntilNextFrameNs() are called from the emulation thread, OnHostPresent() and
+// OnFrameDropped() may be called from any thread.
+class FramePacer
+{
+public:
+    static constexpr std::uint32_t DefaultMaxCatchUpFrames = 3;
+
+    void Reset(double RefreshRate, std::uint64_t NowNs);
+
+    void SetStrategy(PacingStrategy NewStrategy) { Strategy.store(NewStrategy, std::memory_order_relaxed); }
+    [[nodiscard]] PacingStrategy GetStrategy() const { return Strategy.load(std::memory_order_relaxed); }
+
+    void SetMaxCatchUpFrames(std::uint32_t FrameCount) { MaxCatchUpFrames = FrameCount == 0 ? 1 : FrameCount; }
+
+    // Keeps the frame grid anchored when the rate changes (e.g. PAL/NTSC switch), no-op if unchanged.
+    void SetRefreshRate(double RefreshRate, std::uint64_t NowNs);
+
+    // Number of frames to emulate now (bounded by the catch-up budget). AudioFillRatio is the audio queue fill
+    // level in [0, 1], or a negative value when no audio device is available.
+    [[nodiscard]] std::uint32_t FramesToRun(std::uint64_t NowNs, double AudioFillRatio);
+
+    // How long the emulation thread can sleep before FramesToRun() has something to do.
+    [[nodiscard]] std::uint64_t TimeUntilNextFrameNs(std::uint64_t NowNs) const;
+
+    void OnHostPresent(std::uint64_t NowNs, bool ShowedNewFrame);
+    void OnFrameDropped() { DroppedFrames.fetch_add(1, std::memory_order_relaxed); }
+
+    [[nodiscard]] FramePacingStats GetStats() const;
+    [[nodiscard]] double GetHostRefreshRate() const;
+
+private:
+    static constexpr double AudioTargetFillRatio = 0.5;
+    static constexpr double VSyncMaxRateMismatch = 0.05;
+
+    [[nodiscard]] std::uint64_t FrameTimeNs(std::uint64_t FrameIndex) const;
+    [[nodiscard]] std::uint32_t WallClockFramesToRun(std::uint64_t NowNs);
+    [[nodiscard]] bool IsVSyncUsable(std::uint64_t NowNs) const;
+
+    std::atomic<PacingStrategy> Strategy = PacingStrategy::WallClock;
+    PacingStrategy ActiveStrategy = PacingStrategy::WallClock;
+    std::uint32_t MaxCatchUpFrames = DefaultMaxCatchUpFrames;
+
+    // The frame grid is AnchorNs + FrameIndex / RefreshRate, computed from the index so rounding never accumulates.
+    double Rate = 60.0;
+    std::uint64_t AnchorNs = 0;
+    std::uint64_t FramesSinceAnchor = 0;
+    std::uint64_t LastRunNs = 0;
+
+    std::uint64_t ConsumedPresents = 0;
+
+    std::atomic<std::uint64_t> EmulatedFrames = 0;
+    std::atomic<std::uint64_t> CatchUpFrames = 0;
+    std::atomic<std::uint64_t> MissedFrames = 0;
+    std::atomic<std::uint64_t> DroppedFrames = 0;
+    std::atomic<std::uint64_t> DuplicatedFrames = 0;
+    std::atomic<std::uint64_t> HostPresents = 0;
+    std::atomic<std::uint64_t> LastPresentNs = 0;
+    std::atomic<double> HostPresentIntervalNs = 0.0;
+};
@@ -0,0 +1,132 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <span>
+
+#include "Util/TraceRecorder.h"
+
+std::string_view FrameStageName(FrameStage Stage)
+{
+    switch (Stage)
+    {
+    case FrameStage::Emulate: return "Emulate";
+    case FrameStage::Convert: return "Convert";
+    case FrameStage::TextureUpload: return "Texture Upload";
+    case FrameStage::BuildUI: return "Build UI";
+    case FrameStage::ImGuiRender: return "ImGui Render";
+    case FrameStage::Swap: return "Swap";
+    default: return "Unknown";
+    }
+}
+
+FrameProfiler::ThreadRing* FrameProfiler::GetThreadRing()
+{
+    struct ThreadSlot
+    {
+        ThreadRing* Ring = nullptr;
+        bool HasTriedClaim = false;
+
+        ~ThreadSlot()
+        {
+            if (Ring != nullptr)
+                Ring->IsClaimed.store(false, std::memory_order_release);
+        }
+    };
+
+    thread_local ThreadSlot Slot;
+
+    if (!Slot.HasTriedClaim)
+    {
+        Slot.HasTriedClaim = true;
+
+        for (ThreadRing& Ring : Rings)
+        {
+            bool IsClaimed = false;
+
+            if (Ring.IsClaimed.compare_exchange_strong(IsClaimed, true, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                Slot.Ring = &Ring;
+                break;
+            }
+        }
+    }
+
+    return Slot.Ring;
+}
+
+void FrameProfiler::Record(const FrameStageSample& Sample, std::uint64_t WallNs)
+{
+    if (TraceRecorder& Recorder = TraceRecorder::Get(); Recorder.IsCapturing())
+        Recorder.Complete(FrameStageName(Sample.Stage).data(), Sample.StartNs, WallNs);
+
+    if (ThreadRing* Ring = GetThreadRing())
+        Ring->Samples.Push(std::span(&Sample, 1));
+    else
+        UnclaimedDrops.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameProfiler::BeginHostFrame()
+{
+    const std::uint64_t Now = NowNs();
+    HostFrameTimings& PreviousFrame = History[HistoryEnd];
+
+    if (PreviousFrame.StartNs != 0)
+    {
+        PreviousFrame.DurationNs = Now - PreviousFrame.StartNs;
+        HistoryEnd = (HistoryEnd + 1) % History.size();
+        HistoryCount = std::min(HistoryCount + 1, HistoryLength);
+    }
+
+    History[HistoryEnd] = {};
+    History[HistoryEnd].StartNs = Now;
+
+    // Rings released by exited threads may still hold their last samples, so all of them are drained.
+    for (ThreadRing& Ring : Rings)
+    {
+        DrainedSamples.resize(Ring.Samples.Size());
+
+        if (!DrainedSamples.empty() && Ring.Samples.PopExact(DrainedSamples))
+        {
+            for (const FrameStageSample& Sample : DrainedSamples)
+                Attribute(Sample);
+        }
+    }
+}
+
+void FrameProfiler::Attribute(const FrameStageSample& Sample)
+{
+    if (Sample.Stage >= FrameStage::Count)
+        return;
+
+    // Emulation thread samples can arrive a frame late, walk back to the frame they started in.
+    for (std::size_t Age = 0; Age <= HistoryCount; ++Age)
+    {
+        HostFrameTimings& Frame = History[(HistoryEnd + History.size() - Age) % History.size()];
+
+        if (Frame.StartNs <= Sample.StartNs)
+        {
+            Frame.StageNs[static_cast<std::size_t>(Sample.Stage)] += Sample.DurationNs;
+            return;
+        }
+    }
+}
+
+std::size_t FrameProfiler::GetFrameCount() const
+{
+    return HistoryCount;
+}
+
+const HostFrameTimings& FrameProfiler::GetFrame(std::size_t Index) const
+{
+    return History[(HistoryEnd + History.size() - HistoryCount + Index) % History.size()];
+}
+
+std::uint64_t FrameProfiler::GetDroppedSampleCount() const
+{
+    std::uint64_t DroppedSamples = UnclaimedDrops.load(std::memory_order_relaxed);
+
+    for (const ThreadRing& Ring : Rings)
+        DroppedSamples += Ring.Samples.GetDroppedElements();
+
+    return DroppedSamples;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "Util/SpscRingBuffer.h"
+
+enum class FrameStage : std::uint8_t
+{
+    Emulate,       // Core DoFrame(), emulation thread.
+    Convert,       // Frame buffer copy into the display mailbox, emulation thread.
+    TextureUpload, // RenderWindow::UpdateTexture().
+    BuildUI,       // UIManager::Render().
+    ImGuiRender,   // ImGui::Render() and draw data submission.
+    Swap,          // SDL_GL_SwapWindow(), includes the vsync wait.
+    Count,
+};
+
+constexpr std::size_t FrameStageCount = static_cast<std::size_t>(FrameStage::Count);
+
+[[nodiscard]] std::string_view FrameStageName(FrameStage Stage);
+
+struct FrameStageSample
+{
+    std::uint64_t StartNs = 0;
+    std::uint64_t DurationNs = 0; // Exclusive: time spent in nested stages of the same thread is not counted.
+    FrameStage Stage = FrameStage::Count;
+};
+
+// Time spent in each stage during one host frame, from one BeginHostFrame() to the next.
+struct HostFrameTimings
+{
+    std::uint64_t StartNs = 0;
+    std::uint64_t DurationNs = 0;
+    std::array<std::uint64_t, FrameStageCount> StageNs {};
+};
+
+// Collects stage timings from every thread without locks: each thread producing samples owns a single-producer ring,
+// the UI thread drains them all once per host frame and attributes the samples to the host frame they started in.
+class FrameProfiler
+{
+public:
+    static constexpr std::size_t MaxThreadCount = 8;
+    static constexpr std::size_t SamplesPerThread = 1024;
+    static constexpr std::size_t HistoryLength = 600;
+
+    static FrameProfiler& Get() { static FrameProfiler Instance; return Instance; }
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    [[nodiscard]] static std::uint64_t NowNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Any thread. Dropped when all thread rings are taken or the ring of the calling thread is full.
+    // WallNs includes the nested stages, it only feeds the trace timeline when a capture is running.
+    void Record(const FrameStageSample& Sample, std::uint64_t WallNs);
+
+    // UI thread, at the top of each host frame: closes the previous frame and drains the thread rings.
+    void BeginHostFrame();
+
+    // UI thread. Completed frames, oldest first, the frame in progress is not included.
+    [[nodiscard]] std::size_t GetFrameCount() const;
+    [[nodiscard]] const HostFrameTimings& GetFrame(std::size_t Index) const;
+
+    // Samples lost to full rings since startup.
+    [[nodiscard]] std::uint64_t GetDroppedSampleCount() const;
+
+private:
+    struct alignas(64) ThreadRing
+    {
+        std::atomic<bool> IsClaimed = false;
+        SpscRingBuffer<FrameStageSample> Samples { SamplesPerThread };
+    };
+
+    FrameProfiler() = default;
+
+    // Slot of the calling thread, claimed on first use and released when the thread exits.
+    ThreadRing* GetThreadRing();
+
+    void Attribute(const FrameStageSample& Sample);
+
+    std::array<ThreadRing, MaxThreadCount> Rings;
+    std::atomic<std::uint64_t> UnclaimedDrops = 0;
+
+    // UI thread only.
+    std::array<HostFrameTimings, HistoryLength + 1> History {};
+    std::size_t HistoryEnd = 0; // Slot of the frame in progress.
+    std::size_t HistoryCount = 0;
+    std::vector<FrameStageSample> DrainedSamples;
+};
+
+// Records the exclusive time of the enclosing scope as a sample of Stage.
+class ScopedFrameStage
+{
+public:
+    explicit ScopedFrameStage(FrameStage Stage)
+        : Stage(Stage), Parent(Current), StartNs(FrameProfiler::NowNs())
+    {
+        Current = this;
+    }
+
+    ~ScopedFrameStage()
+    {
+        const std::uint64_t DurationNs = FrameProfiler::NowNs() - StartNs;
+        Current = Parent;
+
+        if (Parent != nullptr)
+            Parent->NestedNs += DurationNs;
+
+        FrameProfiler::Get().Record({ StartNs, DurationNs - NestedNs, Stage }, DurationNs);
+    }
+
+    ScopedFrameStage(const ScopedFrameStage&) = delete;
+    ScopedFrameStage& operator=(const ScopedFrameStage&) = delete;
+
+private:
+    static inline thread_local ScopedFrameStage* Current = nullptr;
+
+    FrameStage Stage;
+    ScopedFrameStage* Parent;
+    std::uint64_t StartNs;
+    std::uint64_t NestedNs = 0;
+};
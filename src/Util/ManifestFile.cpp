@@ -0,0 +1,25 @@
+#include "ManifestFile.h"
+
+#include <fstream>
+#include <utility>
+
+bool ReadManifestLines(const std::filesystem::path& ManifestPath, std::vector<std::string>& Lines)
+{
+    std::ifstream Manifest { ManifestPath };
+
+    if (!Manifest)
+        return false;
+
+    for (std::string Line; std::getline(Manifest, Line);)
+    {
+        if (!Line.empty() && Line.back() == '\r')
+            Line.pop_back();
+
+        if (Line.empty() || Line[0] == '#' || Line[0] == ';')
+            continue;
+
+        Lines.push_back(std::move(Line));
+    }
+
+    return true;
+}
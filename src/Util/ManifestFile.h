@@ -0,0 +1,9 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Appends the lines of a text manifest to Lines, skipping empty lines and '#' or ';' comments.
+// A trailing '\r' is removed so manifests edited on Windows read the same. Returns false when the file can't be opened.
+bool ReadManifestLines(const std::filesystem::path& ManifestPath, std::vector<std::string>& Lines);
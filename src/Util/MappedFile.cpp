@@ -0,0 +1,80 @@
+#include "MappedFile.h"
+
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(MappedFile&& Other) noexcept
+    : Address(std::exchange(Other.Address, nullptr))
+    , Size(std::exchange(Other.Size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        Close();
+        Address = std::exchange(Other.Address, nullptr);
+        Size = std::exchange(Other.Size, 0);
+    }
+
+    return *this;
+}
+
+std::error_code MappedFile::Open(const std::filesystem::path& Path)
+{
+    Close();
+
+    const int FileDescriptor = ::open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (FileDescriptor < 0)
+        return { errno, std::generic_category() };
+
+    struct stat FileStatus = {};
+    if (::fstat(FileDescriptor, &FileStatus) != 0)
+    {
+        const std::error_code Error(errno, std::generic_category());
+        ::close(FileDescriptor);
+        return Error;
+    }
+
+    if (FileStatus.st_size == 0)
+    {
+        ::close(FileDescriptor);
+        return std::make_error_code(std::errc::invalid_argument);
+    }
+
+    void* Mapping = ::mmap(nullptr, static_cast<std::size_t>(FileStatus.st_size), PROT_READ, MAP_PRIVATE, FileDescriptor, 0);
+    const int MapErrno = errno;
+
+    // The mapping keeps its own reference on the file.
+    ::close(FileDescriptor);
+
+    if (Mapping == MAP_FAILED)
+        return { MapErrno, std::generic_category() };
+
+    Address = Mapping;
+    Size = static_cast<std::size_t>(FileStatus.st_size);
+    return {};
+}
+
+void MappedFile::Close()
+{
+    if (Address != nullptr)
+    {
+        ::munmap(Address, Size);
+        Address = nullptr;
+        Size = 0;
+    }
+}
+
+void MappedFile::AdviseSequentialRead() const
+{
+    if (Address != nullptr)
+    {
+        ::madvise(Address, Size, MADV_SEQUENTIAL);
+        ::madvise(Address, Size, MADV_WILLNEED);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+
+// Read-only memory mapping of a whole file, unmapped on destruction.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& Other) noexcept;
+    MappedFile& operator=(MappedFile&& Other) noexcept;
+
+    std::error_code Open(const std::filesystem::path& Path);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return Address != nullptr; }
+    [[nodiscard]] std::span<const std::byte> Data() const { return { static_cast<const std::byte*>(Address), Size }; }
+
+    // Hints that the whole file is about to be read front to back, so the kernel reads ahead instead of faulting each page.
+    void AdviseSequentialRead() const;
+
+private:
+    void* Address = nullptr;
+    std::size_t Size = 0;
+};
@@ -0,0 +1,241 @@
+#include "RewindBuffer.h"
+
+#include <algorithm>
+
+#include "Util/StateFile.h"
+
+namespace
+{
+    // Compression runs for every capture, favour speed: deltas are mostly zeroes and compress well anyway.
+    constexpr int RewindCompressionLevel = 1;
+}
+
+RewindBuffer::RewindBuffer()
+{
+    Worker = std::jthread([this](std::stop_token StopToken) { WorkerMain(StopToken); });
+}
+
+RewindBuffer::~RewindBuffer()
+{
+    // Joined here, before the members it uses are destroyed.
+    Worker.request_stop();
+    WorkSignal.notify_all();
+    Worker.join();
+}
+
+void RewindBuffer::Configure(std::size_t NewMemoryBudget, std::uint32_t NewKeyframeInterval)
+{
+    std::scoped_lock Lock(Mutex);
+    MemoryBudget = NewMemoryBudget;
+    KeyframeInterval = std::max<std::uint32_t>(NewKeyframeInterval, 1);
+    EvictOverBudget();
+}
+
+void RewindBuffer::Clear()
+{
+    std::unique_lock Lock(Mutex);
+
+    for (Capture& Pending : PendingCaptures)
+        FreeBuffers.push_back(std::move(Pending.State));
+
+    PendingCaptures.clear();
+    IdleSignal.wait(Lock, [this] { return !IsWorkerBusy; });
+
+    Snapshots.clear();
+    MemoryUsed = 0;
+    ForceKeyframe = true;
+    RestoredKeyframeId = UINT64_MAX;
+}
+
+std::vector<std::byte> RewindBuffer::AcquireBuffer()
+{
+    std::scoped_lock Lock(Mutex);
+
+    if (FreeBuffers.empty())
+        return {};
+
+    std::vector<std::byte> Buffer = std::move(FreeBuffers.back());
+    FreeBuffers.pop_back();
+    return Buffer;
+}
+
+bool RewindBuffer::Push(std::vector<std::byte>&& State, std::uint64_t FrameNumber)
+{
+    if (State.empty())
+        return false;
+
+    {
+        std::scoped_lock Lock(Mutex);
+
+        if (PendingCaptures.size() >= MaxPendingCaptures)
+        {
+            ++DroppedCaptures;
+            FreeBuffers.push_back(std::move(State));
+            return false;
+        }
+
+        PendingCaptures.push_back({ std::move(State), FrameNumber });
+    }
+
+    WorkSignal.notify_one();
+    return true;
+}
+
+bool RewindBuffer::Restore(std::uint64_t TargetFrame, std::vector<std::byte>& State, std::uint64_t& FrameNumber)
+{
+    std::unique_lock Lock(Mutex);
+    IdleSignal.wait(Lock, [this] { return PendingCaptures.empty() && !IsWorkerBusy; });
+
+    bool HasDiscarded = false;
+
+    while (!Snapshots.empty() && Snapshots.back().FrameNumber > TargetFrame)
+    {
+        MemoryUsed -= Snapshots.back().Data.size();
+        Snapshots.pop_back();
+        HasDiscarded = true;
+    }
+
+    // The worker's keyframe may be gone, the next capture starts a new group.
+    if (HasDiscarded)
+        ForceKeyframe = true;
+
+    if (Snapshots.empty() || !DecompressSnapshot(Snapshots.size() - 1, State))
+        return false;
+
+    FrameNumber = Snapshots.back().FrameNumber;
+    return true;
+}
+
+RewindStats RewindBuffer::GetStats() const
+{
+    std::scoped_lock Lock(Mutex);
+
+    RewindStats Stats;
+    Stats.SnapshotCount = Snapshots.size();
+    Stats.KeyframeCount = static_cast<std::size_t>(std::ranges::count_if(Snapshots, &Snapshot::IsKeyframe));
+    Stats.MemoryUsed = MemoryUsed;
+    Stats.MemoryBudget = MemoryBudget;
+    Stats.OldestFrame = Snapshots.empty() ? 0 : Snapshots.front().FrameNumber;
+    Stats.NewestFrame = Snapshots.empty() ? 0 : Snapshots.back().FrameNumber;
+    Stats.DroppedCaptures = DroppedCaptures;
+    return Stats;
+}
+
+void RewindBuffer::WorkerMain(std::stop_token StopToken)
+{
+    while (true)
+    {
+        Capture Pending;
+        bool IsKeyframe = false;
+
+        {
+            std::unique_lock Lock(Mutex);
+            IsWorkerBusy = false;
+            IdleSignal.notify_all();
+
+            if (!WorkSignal.wait(Lock, StopToken, [this] { return !PendingCaptures.empty(); }))
+                return;
+
+            Pending = std::move(PendingCaptures.front());
+            PendingCaptures.pop_front();
+            IsWorkerBusy = true;
+
+            IsKeyframe = ForceKeyframe || DeltasSinceKeyframe + 1 >= KeyframeInterval || Pending.State.size() != Keyframe.size();
+            ForceKeyframe = false;
+        }
+
+        if (IsKeyframe)
+        {
+            CompressState(Pending.State, CompressionBuffer, RewindCompressionLevel);
+            Keyframe.swap(Pending.State);
+            DeltasSinceKeyframe = 0;
+        }
+        else
+        {
+            DeltaBuffer.resize(Keyframe.size());
+
+            for (std::size_t Index = 0; Index < Keyframe.size(); ++Index)
+                DeltaBuffer[Index] = Pending.State[Index] ^ Keyframe[Index];
+
+            CompressState(DeltaBuffer, CompressionBuffer, RewindCompressionLevel);
+            ++DeltasSinceKeyframe;
+        }
+
+        std::scoped_lock Lock(Mutex);
+
+        // Holds the previous keyframe after a keyframe swap, same size either way.
+        FreeBuffers.push_back(std::move(Pending.State));
+
+        if (CompressionBuffer.empty())
+        {
+            // Following deltas would reference a keyframe that was never stored.
+            ForceKeyframe |= IsKeyframe;
+            continue;
+        }
+
+        if (IsKeyframe)
+            ++NextKeyframeId;
+
+        // Exact-size copy, the compression buffer capacity is the worst case bound.
+        Snapshot& Entry = Snapshots.emplace_back();
+        Entry.Data.assign(CompressionBuffer.begin(), CompressionBuffer.end());
+        Entry.FrameNumber = Pending.FrameNumber;
+        Entry.KeyframeId = NextKeyframeId;
+        Entry.IsKeyframe = IsKeyframe;
+        MemoryUsed += Entry.Data.size();
+
+        EvictOverBudget();
+    }
+}
+
+void RewindBuffer::EvictOverBudget()
+{
+    while (MemoryUsed > MemoryBudget && Snapshots.size() > 1)
+    {
+        // Deltas are useless without their keyframe, the whole group goes.
+        do
+        {
+            MemoryUsed -= Snapshots.front().Data.size();
+            Snapshots.pop_front();
+        }
+        while (!Snapshots.empty() && !Snapshots.front().IsKeyframe);
+    }
+
+    if (Snapshots.empty())
+        ForceKeyframe = true;
+}
+
+bool RewindBuffer::DecompressSnapshot(std::size_t Index, std::vector<std::byte>& State)
+{
+    const Snapshot& Entry = Snapshots[Index];
+
+    if (RestoredKeyframeId != Entry.KeyframeId)
+    {
+        const auto KeyframeEntry = std::find_if(Snapshots.rbegin() + static_cast<std::ptrdiff_t>(Snapshots.size() - 1 - Index), Snapshots.rend(), [&Entry](const Snapshot& Candidate)
+        {
+            return Candidate.IsKeyframe && Candidate.KeyframeId == Entry.KeyframeId;
+        });
+
+        if (KeyframeEntry == Snapshots.rend() || DecompressState(KeyframeEntry->Data, RestoredKeyframe))
+        {
+            RestoredKeyframeId = UINT64_MAX;
+            return false;
+        }
+
+        RestoredKeyframeId = Entry.KeyframeId;
+    }
+
+    if (Entry.IsKeyframe)
+    {
+        State.assign(RestoredKeyframe.begin(), RestoredKeyframe.end());
+        return true;
+    }
+
+    if (DecompressState(Entry.Data, State) || State.size() != RestoredKeyframe.size())
+        return false;
+
+    for (std::size_t ByteIndex = 0; ByteIndex < State.size(); ++ByteIndex)
+        State[ByteIndex] ^= RestoredKeyframe[ByteIndex];
+
+    return true;
+}
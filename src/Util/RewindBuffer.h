@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+struct RewindStats
+{
+    std::size_t SnapshotCount = 0;
+    std::size_t KeyframeCount = 0;
+    std::size_t MemoryUsed = 0;
+    std::size_t MemoryBudget = 0;
+    std::uint64_t OldestFrame = 0;
+    std::uint64_t NewestFrame = 0;
+    std::uint64_t DroppedCaptures = 0; // Captures skipped because the worker fell behind.
+};
+
+// Memory-bounded history of emulator states used for rewinding.
+// Captured states are handed over to a worker thread which stores each of them as a zstd compressed XOR delta
+// against the latest keyframe (a full state stored every KeyframeInterval snapshots). When the compressed history
+// exceeds the budget, the oldest keyframe is evicted together with the deltas depending on it.
+class RewindBuffer
+{
+public:
+    static constexpr std::size_t DefaultMemoryBudget = 64 * 1024 * 1024;
+    static constexpr std::uint32_t DefaultKeyframeInterval = 30;
+
+    RewindBuffer();
+    ~RewindBuffer();
+
+    RewindBuffer(const RewindBuffer&) = delete;
+    RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+    void Configure(std::size_t MemoryBudget, std::uint32_t KeyframeInterval);
+    void Clear();
+
+    // Returns a buffer the worker is done with (empty when none is free yet), to capture the next state into so
+    // captures do not allocate a state sized buffer each time.
+    std::vector<std::byte> AcquireBuffer();
+
+    // Takes a state captured once FrameNumber frames were emulated. Only moves the buffer into the worker queue,
+    // returns false if the capture was dropped because the worker is too far behind.
+    bool Push(std::vector<std::byte>&& State, std::uint64_t FrameNumber);
+
+    // Restores the newest snapshot taken at or before TargetFrame and discards the newer ones.
+    // Waits for the captures still being compressed. State keeps its capacity between calls.
+    bool Restore(std::uint64_t TargetFrame, std::vector<std::byte>& State, std::uint64_t& FrameNumber);
+
+    [[nodiscard]] RewindStats GetStats() const;
+
+private:
+    static constexpr std::size_t MaxPendingCaptures = 8;
+
+    struct Capture
+    {
+        std::vector<std::byte> State;
+        std::uint64_t FrameNumber = 0;
+    };
+
+    struct Snapshot
+    {
+        std::vector<std::byte> Data;
+        std::uint64_t FrameNumber = 0;
+        std::uint64_t KeyframeId = 0; // Own id for a keyframe, id of the keyframe it is relative to for a delta.
+        bool IsKeyframe = false;
+    };
+
+    void WorkerMain(std::stop_token StopToken);
+    void EvictOverBudget();
+    bool DecompressSnapshot(std::size_t Index, std::vector<std::byte>& State);
+
+    std::jthread Worker;
+
+    mutable std::mutex Mutex;
+    std::condition_variable_any WorkSignal;
+    std::condition_variable_any IdleSignal;
+    std::deque<Capture> PendingCaptures;
+    // Capture buffers handed back by the worker, bounded by MaxPendingCaptures plus the ones in flight.
+    std::vector<std::vector<std::byte>> FreeBuffers;
+    bool IsWorkerBusy = false;
+    bool ForceKeyframe = true;
+
+    std::deque<Snapshot> Snapshots;
+    std::size_t MemoryUsed = 0;
+    std::size_t MemoryBudget = DefaultMemoryBudget;
+    std::uint32_t KeyframeInterval = DefaultKeyframeInterval;
+    std::uint64_t DroppedCaptures = 0;
+    std::uint64_t NextKeyframeId = 0;
+
+    // Worker thread only.
+    std::vector<std::byte> Keyframe;
+    std::uint32_t DeltasSinceKeyframe = 0;
+    std::vector<std::byte> DeltaBuffer;
+    std::vector<std::byte> CompressionBuffer;
+
+    // Restore() only, the last decompressed keyframe is kept since rewinding walks back through the same group.
+    std::vector<std::byte> RestoredKeyframe;
+    std::uint64_t RestoredKeyframeId = UINT64_MAX;
+};
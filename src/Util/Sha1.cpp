@@ -0,0 +1,141 @@
+#include "Sha1.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+    std::uint32_t LoadBigEndian32(const std::uint8_t* Bytes)
+    {
+        return (static_cast<std::uint32_t>(Bytes[0]) << 24) | (static_cast<std::uint32_t>(Bytes[1]) << 16)
+            | (static_cast<std::uint32_t>(Bytes[2]) << 8) | static_cast<std::uint32_t>(Bytes[3]);
+    }
+}
+
+void Sha1::Update(std::span<const std::byte> Data)
+{
+    const std::uint8_t* Bytes = reinterpret_cast<const std::uint8_t*>(Data.data());
+    std::size_t Remaining = Data.size();
+    TotalSize += Remaining;
+
+    if (BlockSize != 0)
+    {
+        const std::size_t Count = std::min(Remaining, Block.size() - BlockSize);
+        std::memcpy(Block.data() + BlockSize, Bytes, Count);
+        BlockSize += Count;
+        Bytes += Count;
+        Remaining -= Count;
+
+        if (BlockSize < Block.size())
+            return;
+
+        ProcessBlock(Block.data());
+        BlockSize = 0;
+    }
+
+    for (; Remaining >= Block.size(); Bytes += Block.size(), Remaining -= Block.size())
+        ProcessBlock(Bytes);
+
+    std::memcpy(Block.data(), Bytes, Remaining);
+    BlockSize = Remaining;
+}
+
+Sha1Digest Sha1::Finish()
+{
+    const std::uint64_t TotalBits = TotalSize * 8;
+
+    // A single 0x80 byte, zeroes up to 8 bytes before a block boundary, then the message length in bits.
+    std::array<std::byte, 72> Padding = {};
+    Padding[0] = std::byte { 0x80 };
+    const std::size_t PaddingSize = (BlockSize < 56 ? 56 : 120) - BlockSize;
+
+    for (std::size_t Index = 0; Index < 8; ++Index)
+        Padding[PaddingSize + Index] = static_cast<std::byte>(TotalBits >> (56 - Index * 8));
+
+    Update({ Padding.data(), PaddingSize + 8 });
+
+    Sha1Digest Digest;
+
+    for (std::size_t Index = 0; Index < State.size(); ++Index)
+    {
+        Digest[Index * 4 + 0] = static_cast<std::uint8_t>(State[Index] >> 24);
+        Digest[Index * 4 + 1] = static_cast<std::uint8_t>(State[Index] >> 16);
+        Digest[Index * 4 + 2] = static_cast<std::uint8_t>(State[Index] >> 8);
+        Digest[Index * 4 + 3] = static_cast<std::uint8_t>(State[Index]);
+    }
+
+    return Digest;
+}
+
+void Sha1::ProcessBlock(const std::uint8_t* BlockData)
+{
+    std::array<std::uint32_t, 80> Words;
+
+    for (std::size_t Index = 0; Index < 16; ++Index)
+        Words[Index] = LoadBigEndian32(BlockData + Index * 4);
+
+    for (std::size_t Index = 16; Index < 80; ++Index)
+        Words[Index] = std::rotl(Words[Index - 3] ^ Words[Index - 8] ^ Words[Index - 14] ^ Words[Index - 16], 1);
+
+    std::uint32_t A = State[0];
+    std::uint32_t B = State[1];
+    std::uint32_t C = State[2];
+    std::uint32_t D = State[3];
+    std::uint32_t E = State[4];
+
+    for (std::size_t Index = 0; Index < 80; ++Index)
+    {
+        std::uint32_t Function;
+        std::uint32_t Constant;
+
+        if (Index < 20)
+        {
+            Function = (B & C) | (~B & D);
+            Constant = 0x5A827999u;
+        }
+        else if (Index < 40)
+        {
+            Function = B ^ C ^ D;
+            Constant = 0x6ED9EBA1u;
+        }
+        else if (Index < 60)
+        {
+            Function = (B & C) | (B & D) | (C & D);
+            Constant = 0x8F1BBCDCu;
+        }
+        else
+        {
+            Function = B ^ C ^ D;
+            Constant = 0xCA62C1D6u;
+        }
+
+        const std::uint32_t Next = std::rotl(A, 5) + Function + E + Constant + Words[Index];
+        E = D;
+        D = C;
+        C = std::rotl(B, 30);
+        B = A;
+        A = Next;
+    }
+
+    State[0] += A;
+    State[1] += B;
+    State[2] += C;
+    State[3] += D;
+    State[4] += E;
+}
+
+std::string Sha1ToHex(const Sha1Digest& Digest)
+{
+    constexpr const char* HexCharacter = "0123456789abcdef";
+    std::string Hex;
+    Hex.reserve(Digest.size() * 2);
+
+    for (const std::uint8_t Byte : Digest)
+    {
+        Hex += HexCharacter[Byte >> 4];
+        Hex += HexCharacter[Byte & 0xF];
+    }
+
+    return Hex;
+}
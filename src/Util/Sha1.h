@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+using Sha1Digest = std::array<std::uint8_t, 20>;
+
+// SHA-1 (FIPS 180-4), the digest No-Intro and Redump DAT files identify games with. Not for anything security related.
+class Sha1
+{
+public:
+    void Update(std::span<const std::byte> Data);
+    [[nodiscard]] Sha1Digest Finish();
+
+private:
+    void ProcessBlock(const std::uint8_t* Block);
+
+    std::array<std::uint32_t, 5> State = { 0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u };
+    std::array<std::uint8_t, 64> Block = {};
+    std::size_t BlockSize = 0;
+    std::uint64_t TotalSize = 0;
+};
+
+[[nodiscard]] std::string Sha1ToHex(const Sha1Digest& Digest);
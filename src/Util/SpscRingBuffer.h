@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+struct RingBufferStats
+{
+    std::size_t Capacity = 0;
+    std::size_t FillLevel = 0;
+    std::size_t MinFillLevel = 0; // Lowest level seen by the consumer since the previous TakeStats().
+    std::size_t MaxFillLevel = 0; // Highest level seen by the producer since the previous TakeStats().
+    std::uint64_t PushedElements = 0;
+    std::uint64_t PoppedElements = 0;
+    std::uint64_t DroppedElements = 0; // Elements the producer could not fit (overrun).
+    std::uint64_t Underruns = 0;       // Pops that could not be served in full.
+};
+
+// Fixed-capacity single-producer/single-consumer ring buffer. Push() and PopExact() are wait-free and never allocate;
+// only Reset() allocates and it must not run concurrently with them. Producer and consumer indices live on their
+// own cache lines, each side keeps a cached copy of the other index to avoid touching the shared line every call.
+template<typename ElementType>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<ElementType>, "SpscRingBuffer elements are copied as raw memory");
+
+public:
+    SpscRingBuffer() = default;
+    explicit SpscRingBuffer(std::size_t MinCapacity) { Reset(MinCapacity); }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    void Reset(std::size_t MinCapacity)
+    {
+        const std::size_t NewCapacity = std::bit_ceil(std::max<std::size_t>(MinCapacity, 2));
+
+        if (NewCapacity != Capacity)
+        {
+            Elements = std::make_unique<ElementType[]>(NewCapacity);
+            Capacity = NewCapacity;
+        }
+
+        Producer.WriteIndex.store(0, std::memory_order_relaxed);
+        Producer.CachedReadIndex = 0;
+        Producer.PushedElements.store(0, std::memory_order_relaxed);
+        Producer.DroppedElements.store(0, std::memory_order_relaxed);
+        Producer.MaxFillLevel.store(0, std::memory_order_relaxed);
+        Consumer.ReadIndex.store(0, std::memory_order_relaxed);
+        Consumer.CachedWriteIndex = 0;
+        Consumer.PoppedElements.store(0, std::memory_order_relaxed);
+        Consumer.Underruns.store(0, std::memory_order_relaxed);
+        Consumer.MinFillLevel.store(std::numeric_limits<std::size_t>::max(), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t GetCapacity() const { return Capacity; }
+    [[nodiscard]] std::uint64_t GetDroppedElements() const { return Producer.DroppedElements.load(std::memory_order_relaxed); }
+
+    // Approximate when called from a third thread, exact from either side. The read index is loaded first: both only
+    // grow and the read index never passes the write index, so the difference cannot underflow, only exceed the
+    // capacity when the producer pushed in between, which is clamped.
+    [[nodiscard]] std::size_t Size() const
+    {
+        const std::size_t ReadIndex = Consumer.ReadIndex.load(std::memory_order_acquire);
+        const std::size_t WriteIndex = Producer.WriteIndex.load(std::memory_order_acquire);
+        return std::min<std::size_t>(WriteIndex - ReadIndex, Capacity);
+    }
+
+    // Producer side: copies as many elements as fit and returns that count, the rest is counted as dropped.
+    std::size_t Push(std::span<const ElementType> Source)
+    {
+        const std::size_t WriteIndex = Producer.WriteIndex.load(std::memory_order_relaxed);
+
+        if (Capacity - (WriteIndex - Producer.CachedReadIndex) < Source.size())
+            Producer.CachedReadIndex = Consumer.ReadIndex.load(std::memory_order_acquire);
+
+        const std::size_t FreeSpace = Capacity - (WriteIndex - Producer.CachedReadIndex);
+        const std::size_t Count = std::min(FreeSpace, Source.size());
+
+        CopyIn(WriteIndex, Source.first(Count));
+        Producer.WriteIndex.store(WriteIndex + Count, std::memory_order_release);
+
+        Producer.PushedElements.fetch_add(Count, std::memory_order_relaxed);
+        if (Count < Source.size())
+            Producer.DroppedElements.fetch_add(Source.size() - Count, std::memory_order_relaxed);
+
+        const std::size_t FillLevel = WriteIndex + Count - Producer.CachedReadIndex;
+        if (FillLevel > Producer.MaxFillLevel.load(std::memory_order_relaxed))
+            Producer.MaxFillLevel.store(FillLevel, std::memory_order_relaxed);
+
+        return Count;
+    }
+
+    // Producer side: free space, at least this many elements can be pushed.
+    [[nodiscard]] std::size_t FreeSpace()
+    {
+        Producer.CachedReadIndex = Consumer.ReadIndex.load(std::memory_order_acquire);
+        return Capacity - (Producer.WriteIndex.load(std::memory_order_relaxed) - Producer.CachedReadIndex);
+    }
+
+    // Consumer side: pops exactly Destination.size() elements, or nothing (counted as underrun) if not enough
+    // are available. Returns false on underrun.
+    bool PopExact(std::span<ElementType> Destination)
+    {
+        const std::size_t ReadIndex = Consumer.ReadIndex.load(std::memory_order_relaxed);
+
+        if (Consumer.CachedWriteIndex - ReadIndex < Destination.size())
+            Consumer.CachedWriteIndex = Producer.WriteIndex.load(std::memory_order_acquire);
+
+        const std::size_t Available = Consumer.CachedWriteIndex - ReadIndex;
+        UpdateMinFillLevel(Available);
+
+        if (Available < Destination.size())
+        {
+            Consumer.Underruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        CopyOut(ReadIndex, Destination);
+        Consumer.ReadIndex.store(ReadIndex + Destination.size(), std::memory_order_release);
+        Consumer.PoppedElements.fetch_add(Destination.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    // Snapshot of the telemetry, restarts the min/max fill level window. Safe from any thread.
+    [[nodiscard]] RingBufferStats TakeStats()
+    {
+        RingBufferStats Stats;
+        Stats.Capacity = Capacity;
+        Stats.FillLevel = Size();
+        Stats.MinFillLevel = std::min(Consumer.MinFillLevel.exchange(std::numeric_limits<std::size_t>::max(), std::memory_order_relaxed), Stats.FillLevel);
+        Stats.MaxFillLevel = std::max(Producer.MaxFillLevel.exchange(0, std::memory_order_relaxed), Stats.FillLevel);
+        Stats.PushedElements = Producer.PushedElements.load(std::memory_order_relaxed);
+        Stats.PoppedElements = Consumer.PoppedElements.load(std::memory_order_relaxed);
+        Stats.DroppedElements = Producer.DroppedElements.load(std::memory_order_relaxed);
+        Stats.Underruns = Consumer.Underruns.load(std::memory_order_relaxed);
+        return Stats;
+    }
+
+private:
+    static constexpr std::size_t CacheLineSize = 64;
+
+    void CopyIn(std::size_t Index, std::span<const ElementType> Source)
+    {
+        const std::size_t Offset = Index & (Capacity - 1);
+        const std::size_t FirstPart = std::min(Source.size(), Capacity - Offset);
+        std::copy_n(Source.data(), FirstPart, Elements.get() + Offset);
+        std::copy_n(Source.data() + FirstPart, Source.size() - FirstPart, Elements.get());
+    }
+
+    void CopyOut(std::size_t Index, std::span<ElementType> Destination) const
+    {
+        const std::size_t Offset = Index & (Capacity - 1);
+        const std::size_t FirstPart = std::min(Destination.size(), Capacity - Offset);
+        std::copy_n(Elements.get() + Offset, FirstPart, Destination.data());
+        std::copy_n(Elements.get(), Destination.size() - FirstPart, Destination.data() + FirstPart);
+    }
+
+    void UpdateMinFillLevel(std::size_t FillLevel)
+    {
+        std::size_t MinFillLevel = Consumer.MinFillLevel.load(std::memory_order_relaxed);
+        while (FillLevel < MinFillLevel && !Consumer.MinFillLevel.compare_exchange_weak(MinFillLevel, FillLevel, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    struct alignas(CacheLineSize) ProducerState
+    {
+        std::atomic<std::size_t> WriteIndex = 0;
+        std::size_t CachedReadIndex = 0;
+        std::atomic<std::uint64_t> PushedElements = 0;
+        std::atomic<std::uint64_t> DroppedElements = 0;
+        std::atomic<std::size_t> MaxFillLevel = 0;
+    };
+
+    struct alignas(CacheLineSize) ConsumerState
+    {
+        std::atomic<std::size_t> ReadIndex = 0;
+        std::size_t CachedWriteIndex = 0;
+        std::atomic<std::uint64_t> PoppedElements = 0;
+        std::atomic<std::uint64_t> Underruns = 0;
+        std::atomic<std::size_t> MinFillLevel = std::numeric_limits<std::size_t>::max();
+    };
+
+    ProducerState Producer;
+    ConsumerState Consumer;
+
+    alignas(CacheLineSize) std::unique_ptr<ElementType[]> Elements;
+    std::size_t Capacity = 0;
+};
@@ -0,0 +1,108 @@
+#include "StateFile.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+#include <zstd.h>
+
+#include "Util/MappedFile.h"
+
+namespace
+{
+    // Far above any core state, only guards against allocating garbage sizes from a corrupted header.
+    constexpr unsigned long long MaxStateSize = 64ull * 1024 * 1024;
+}
+
+std::error_code CompressState(std::span<const std::byte> State, std::vector<std::byte>& Output, int CompressionLevel)
+{
+    Output.resize(ZSTD_compressBound(State.size()));
+
+    const std::size_t CompressedSize = ZSTD_compress(Output.data(), Output.size(), State.data(), State.size(), CompressionLevel);
+    if (ZSTD_isError(CompressedSize))
+    {
+        Output.clear();
+        return std::make_error_code(std::errc::io_error);
+    }
+
+    Output.resize(CompressedSize);
+    return {};
+}
+
+std::error_code DecompressState(std::span<const std::byte> Compressed, std::vector<std::byte>& Output)
+{
+    const unsigned long long StateSize = ZSTD_getFrameContentSize(Compressed.data(), Compressed.size());
+    if (StateSize == ZSTD_CONTENTSIZE_ERROR || StateSize == ZSTD_CONTENTSIZE_UNKNOWN || StateSize > MaxStateSize)
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+
+    Output.resize(static_cast<std::size_t>(StateSize));
+
+    const std::size_t DecompressedSize = ZSTD_decompress(Output.data(), Output.size(), Compressed.data(), Compressed.size());
+    if (ZSTD_isError(DecompressedSize) || DecompressedSize != Output.size())
+    {
+        Output.clear();
+        return std::make_error_code(std::errc::illegal_byte_sequence);
+    }
+
+    return {};
+}
+
+std::error_code WriteFileAtomically(const std::filesystem::path& Path, std::span<const std::byte> Data)
+{
+    std::error_code Error;
+
+    if (Path.has_parent_path())
+    {
+        std::filesystem::create_directories(Path.parent_path(), Error);
+        if (Error)
+            return Error;
+    }
+
+    std::filesystem::path TemporaryPath = Path;
+    TemporaryPath += ".tmp";
+
+    {
+        std::ofstream Stream(TemporaryPath, std::ios::binary | std::ios::trunc);
+        Stream.write(reinterpret_cast<const char*>(Data.data()), static_cast<std::streamsize>(Data.size()));
+        Stream.flush();
+
+        if (!Stream)
+        {
+            std::filesystem::remove(TemporaryPath, Error);
+            return std::make_error_code(std::errc::io_error);
+        }
+    }
+
+    if ((Error = SyncFile(TemporaryPath)))
+    {
+        std::error_code RemoveError;
+        std::filesystem::remove(TemporaryPath, RemoveError);
+        return Error;
+    }
+
+    std::filesystem::rename(TemporaryPath, Path, Error);
+    return Error;
+}
+
+std::error_code SyncFile(const std::filesystem::path& Path)
+{
+    const int FileDescriptor = ::open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (FileDescriptor < 0)
+        return { errno, std::generic_category() };
+
+    const int Result = ::fsync(FileDescriptor);
+    const int SyncErrno = errno;
+    ::close(FileDescriptor);
+
+    return Result == 0 ? std::error_code() : std::error_code(SyncErrno, std::generic_category());
+}
+
+std::error_code ReadStateFile(const std::filesystem::path& Path, std::vector<std::byte>& State)
+{
+    MappedFile File;
+
+    if (const std::error_code Error = File.Open(Path); Error)
+        return Error;
+
+    return DecompressState(File.Data(), State);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <vector>
+
+// Emulator states on disk are a single zstd frame (readable by the zstd command line tool).
+
+constexpr int DefaultStateCompressionLevel = 3;
+
+// Output is resized to the compressed size, its capacity is kept so a reused buffer stops allocating.
+std::error_code CompressState(std::span<const std::byte> State, std::vector<std::byte>& Output, int CompressionLevel = DefaultStateCompressionLevel);
+std::error_code DecompressState(std::span<const std::byte> Compressed, std::vector<std::byte>& Output);
+
+// Writes next to Path then renames over it, so a crash or a full disk never leaves a truncated file behind.
+std::error_code WriteFileAtomically(const std::filesystem::path& Path, std::span<const std::byte> Data);
+
+// Flushes a closed file to the disk. Before renaming it over another, so a power loss cannot leave the new name
+// pointing at data that was never written.
+std::error_code SyncFile(const std::filesystem::path& Path);
+
+// Maps the file and decompresses it into State.
+std::error_code ReadStateFile(const std::filesystem::path& Path, std::vector<std::byte>& State);
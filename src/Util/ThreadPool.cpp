@@ -0,0 +1,56 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::uint32_t ThreadCount)
+{
+    if (ThreadCount == 0)
+        ThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (std::uint32_t Index = 0; Index < ThreadCount; ++Index)
+        Workers.emplace_back([this](std::stop_token StopToken) { WorkerMain(StopToken); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    // Queued tasks are dropped, running ones finish.
+    for (std::jthread& Worker : Workers)
+        Worker.request_stop();
+
+    Workers.clear();
+}
+
+void ThreadPool::Push(Task NewTask)
+{
+    {
+        std::scoped_lock Lock(Mutex);
+        PendingTasks.push_back(std::move(NewTask));
+    }
+
+    WorkSignal.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock Lock(Mutex);
+    IdleSignal.wait(Lock, [this] { return PendingTasks.empty() && RunningTasks == 0; });
+}
+
+void ThreadPool::WorkerMain(std::stop_token StopToken)
+{
+    std::unique_lock Lock(Mutex);
+
+    while (WorkSignal.wait(Lock, StopToken, [this] { return !PendingTasks.empty(); }))
+    {
+        Task CurrentTask = std::move(PendingTasks.front());
+        PendingTasks.pop_front();
+        ++RunningTasks;
+
+        Lock.unlock();
+        CurrentTask();
+        Lock.lock();
+
+        if (--RunningTasks == 0 && PendingTasks.empty())
+            IdleSignal.notify_all();
+    }
+}
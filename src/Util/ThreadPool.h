@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running queued tasks in submission order, for I/O and hashing work which does not touch an
+// emulator core (the cores keep their state in globals, see tools/Headless/WorkerPool.h for parallel emulation).
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // Zero uses one thread per hardware thread.
+    explicit ThreadPool(std::uint32_t ThreadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Push(Task NewTask);
+
+    // Returns once every task pushed so far has run.
+    void Wait();
+
+    [[nodiscard]] std::uint32_t GetThreadCount() const { return static_cast<std::uint32_t>(Workers.size()); }
+
+private:
+    void WorkerMain(std::stop_token StopToken);
+
+    std::mutex Mutex;
+    std::condition_variable_any WorkSignal;
+    std::condition_variable_any IdleSignal;
+    std::deque<Task> PendingTasks;
+    std::uint32_t RunningTasks = 0;
+
+    // Last, so the workers are stopped before the queue is destroyed.
+    std::vector<std::jthread> Workers;
+};
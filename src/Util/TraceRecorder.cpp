@@ -0,0 +1,224 @@
+#include "TraceRecorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <span>
+
+namespace
+{
+    constexpr std::chrono::milliseconds FlushInterval(20);
+
+    std::uint64_t SteadyClockNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    Stop();
+}
+
+std::error_code TraceRecorder::Start(const std::filesystem::path& NewPath)
+{
+    std::scoped_lock Lock(ControlMutex);
+
+    if (WriterThread.joinable())
+        return std::make_error_code(std::errc::device_or_resource_busy);
+
+    std::error_code Error;
+    std::filesystem::create_directories(NewPath.parent_path(), Error);
+    Stream.open(NewPath, std::ios::binary | std::ios::trunc);
+
+    if (!Stream)
+        return std::make_error_code(std::errc::io_error);
+
+    // Leftovers of the previous capture, pushed after its last drain.
+    DrainRings(false);
+
+    Path = NewPath;
+    IsFirstEvent = true;
+    NamedThreadIds = {};
+    DroppedEvents.store(0, std::memory_order_relaxed);
+    CaptureStartNs = SteadyClockNs();
+    Stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    Capturing.store(true, std::memory_order_relaxed);
+    WriterThread = std::jthread([this](std::stop_token StopToken) { WriterThreadMain(StopToken); });
+    return {};
+}
+
+void TraceRecorder::Stop()
+{
+    std::scoped_lock Lock(ControlMutex);
+
+    if (!WriterThread.joinable())
+        return;
+
+    Capturing.store(false, std::memory_order_relaxed);
+    WriterThread.request_stop();
+    WakeSignal.notify_one();
+    WriterThread.join();
+
+    Stream << "\n]}\n";
+    Stream.close();
+}
+
+void TraceRecorder::SetThreadName(const char* Name)
+{
+    if (ThreadRing* Ring = Get().GetThreadRing())
+        Ring->ThreadName.store(Name, std::memory_order_release);
+}
+
+std::uint64_t TraceRecorder::NowNs()
+{
+    return SteadyClockNs();
+}
+
+void TraceRecorder::Complete(const char* Name, std::uint64_t StartNs, std::uint64_t DurationNs)
+{
+    Push({ Name, StartNs, DurationNs, 0.0, 0, 'X' });
+}
+
+void TraceRecorder::Counter(const char* Name, double Value)
+{
+    if (IsCapturing())
+        Push({ Name, SteadyClockNs(), 0, Value, 0, 'C' });
+}
+
+void TraceRecorder::Push(TraceEvent Event)
+{
+    ThreadRing* Ring = GetThreadRing();
+
+    if (Ring == nullptr)
+    {
+        DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Event.ThreadId = Ring->ThreadId.load(std::memory_order_relaxed);
+
+    if (Ring->Events.Push(std::span(&Event, 1)) == 0)
+        DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+TraceRecorder::ThreadRing* TraceRecorder::GetThreadRing()
+{
+    struct ThreadSlot
+    {
+        ThreadRing* Ring = nullptr;
+        bool HasTriedClaim = false;
+
+        ~ThreadSlot()
+        {
+            if (Ring != nullptr)
+            {
+                Ring->ThreadName.store(nullptr, std::memory_order_relaxed);
+                Ring->IsClaimed.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local ThreadSlot Slot;
+
+    if (!Slot.HasTriedClaim)
+    {
+        Slot.HasTriedClaim = true;
+
+        for (ThreadRing& Ring : Rings)
+        {
+            bool IsClaimed = false;
+
+            if (Ring.IsClaimed.compare_exchange_strong(IsClaimed, true, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                // A fresh id per thread, so a reused ring never merges two threads into one track.
+                Ring.ThreadId.store(NextThreadId.fetch_add(1, std::memory_order_relaxed), std::memory_order_release);
+                Slot.Ring = &Ring;
+                break;
+            }
+        }
+    }
+
+    return Slot.Ring;
+}
+
+void TraceRecorder::WriterThreadMain(std::stop_token StopToken)
+{
+    while (!StopToken.stop_requested())
+    {
+        {
+            std::unique_lock Lock(WakeMutex);
+            WakeSignal.wait_for(Lock, StopToken, FlushInterval, [] { return false; });
+        }
+
+        DrainRings(true);
+        Stream.flush();
+    }
+
+    DrainRings(true);
+}
+
+void TraceRecorder::DrainRings(bool IsWriting)
+{
+    for (std::size_t Index = 0; Index < Rings.size(); ++Index)
+    {
+        ThreadRing& Ring = Rings[Index];
+
+        if (IsWriting && Ring.IsClaimed.load(std::memory_order_acquire))
+        {
+            const std::uint32_t ThreadId = Ring.ThreadId.load(std::memory_order_acquire);
+            const char* ThreadName = Ring.ThreadName.load(std::memory_order_acquire);
+
+            if (ThreadName != nullptr && NamedThreadIds[Index] != ThreadId)
+            {
+                NamedThreadIds[Index] = ThreadId;
+                WriteEvent({ ThreadName, 0, 0, 0.0, ThreadId, 'M' });
+            }
+        }
+
+        DrainedEvents.resize(Ring.Events.Size());
+
+        if (DrainedEvents.empty() || !Ring.Events.PopExact(DrainedEvents) || !IsWriting)
+            continue;
+
+        for (const TraceEvent& Event : DrainedEvents)
+            WriteEvent(Event);
+    }
+}
+
+void TraceRecorder::WriteEvent(const TraceEvent& Event)
+{
+    // Microseconds since the capture started, events timed before it (a stage already running) go negative.
+    const double TimestampUs = static_cast<double>(static_cast<std::int64_t>(Event.TimestampNs - CaptureStartNs)) / 1000.0;
+    char Buffer[256];
+    int Length = 0;
+
+    switch (Event.Phase)
+    {
+    case 'M':
+        Length = std::snprintf(Buffer, sizeof(Buffer), R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":"%s"}})",
+            Event.ThreadId, Event.Name);
+        break;
+    case 'X':
+        Length = std::snprintf(Buffer, sizeof(Buffer), R"({"name":"%s","ph":"X","ts":%.3f,"dur":%.3f,"pid":1,"tid":%u})",
+            Event.Name, TimestampUs, static_cast<double>(Event.DurationNs) / 1000.0, Event.ThreadId);
+        break;
+    case 'C':
+        Length = std::snprintf(Buffer, sizeof(Buffer), R"({"name":"%s","ph":"C","ts":%.3f,"pid":1,"tid":%u,"args":{"value":%g}})",
+            Event.Name, TimestampUs, Event.ThreadId, Event.Value);
+        break;
+    default:
+        Length = std::snprintf(Buffer, sizeof(Buffer), R"({"name":"%s","ph":"%c","ts":%.3f,"pid":1,"tid":%u})",
+            Event.Name, Event.Phase, TimestampUs, Event.ThreadId);
+        break;
+    }
+
+    if (Length <= 0 || static_cast<std::size_t>(Length) >= sizeof(Buffer))
+        return;
+
+    if (!IsFirstEvent)
+        Stream << ",\n";
+
+    IsFirstEvent = false;
+    Stream.write(Buffer, Length);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "Util/SpscRingBuffer.h"
+
+// Event names must outlive the capture, only pass string literals.
+struct TraceEvent
+{
+    const char* Name = nullptr;
+    std::uint64_t TimestampNs = 0;
+    std::uint64_t DurationNs = 0; // Complete events only.
+    double Value = 0.0;           // Counter events only.
+    std::uint32_t ThreadId = 0;
+    char Phase = 0;               // Chrome trace-event phase: 'X', 'C' or 'M' (thread name).
+};
+
+// Records complete and counter events into per-thread single-producer rings while a capture runs. A writer
+// thread drains the rings every few milliseconds and streams them to a Chrome trace-event JSON file, which opens in
+// chrome://tracing or ui.perfetto.dev. Recording is a relaxed load and nothing more while no capture runs.
+class TraceRecorder
+{
+public:
+    static constexpr std::size_t MaxThreadCount = 16;
+    static constexpr std::size_t EventsPerThread = 16384;
+
+    static TraceRecorder& Get() { static TraceRecorder Instance; return Instance; }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+    ~TraceRecorder();
+
+    std::error_code Start(const std::filesystem::path& Path);
+    void Stop();
+
+    [[nodiscard]] bool IsCapturing() const { return Capturing.load(std::memory_order_relaxed); }
+    [[nodiscard]] const std::filesystem::path& GetPath() const { return Path; }
+
+    // Names the calling thread in the timeline, call it once when the thread starts.
+    static void SetThreadName(const char* Name);
+
+    // Steady clock, the time base of the events.
+    [[nodiscard]] static std::uint64_t NowNs();
+
+    // Spans are only recorded once they end, as a single event: a full ring drops a whole span, never half of one.
+    void Complete(const char* Name, std::uint64_t StartNs, std::uint64_t DurationNs);
+    void Counter(const char* Name, double Value);
+
+    // Events lost to full rings during the current or last capture.
+    [[nodiscard]] std::uint64_t GetDroppedEventCount() const { return DroppedEvents.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) ThreadRing
+    {
+        std::atomic<bool> IsClaimed = false;
+        std::atomic<std::uint32_t> ThreadId = 0;
+        std::atomic<const char*> ThreadName = nullptr;
+        SpscRingBuffer<TraceEvent> Events { EventsPerThread };
+    };
+
+    TraceRecorder() = default;
+
+    void Push(TraceEvent Event);
+    // Slot of the calling thread, claimed on first use and released when the thread exits.
+    ThreadRing* GetThreadRing();
+
+    void WriterThreadMain(std::stop_token StopToken);
+    void DrainRings(bool IsWriting);
+    void WriteEvent(const TraceEvent& Event);
+
+    std::array<ThreadRing, MaxThreadCount> Rings;
+    std::atomic<bool> Capturing = false;
+    std::atomic<std::uint32_t> NextThreadId = 1;
+    std::atomic<std::uint64_t> DroppedEvents = 0;
+
+    // Start() and Stop() are serialized, the writer thread owns the stream while it runs.
+    std::mutex ControlMutex;
+    std::jthread WriterThread;
+    std::mutex WakeMutex;
+    std::condition_variable_any WakeSignal;
+    std::filesystem::path Path;
+    std::ofstream Stream;
+    std::uint64_t CaptureStartNs = 0;
+    bool IsFirstEvent = true;
+    std::array<std::uint32_t, MaxThreadCount> NamedThreadIds {};
+    std::vector<TraceEvent> DrainedEvents;
+};
+
+// Complete event spanning the enclosing scope, skipped entirely if no capture was running when the scope opened or if
+// Name is null.
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* Name)
+        : Name(TraceRecorder::Get().IsCapturing() ? Name : nullptr)
+        , StartNs(this->Name != nullptr ? TraceRecorder::NowNs() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (Name != nullptr)
+            TraceRecorder::Get().Complete(Name, StartNs, TraceRecorder::NowNs() - StartNs);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* Name;
+    std::uint64_t StartNs;
+};
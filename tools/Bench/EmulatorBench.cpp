@@ -0,0 +1,430 @@
+// Ultipugna-bench: measures DoFrame() throughput for a list of ROMs and reports it as JSON.
+// Each ROM is warmed up, then timed frame by frame; the per-frame time is split between CPU emulation,
+// audio_update and the frame buffer handoff (same copy as the application's frame mailbox).
+// A previous report can be passed with --baseline to flag throughput regressions.
+// --state-roundtrip also times SaveState/LoadState into a preallocated buffer, the per-frame cost of run-ahead.
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CoreWrapper/GenesisPlusGX.h"
+#include "Util/FrameMailbox.h"
+#include "Util/ManifestFile.h"
+#include "Util/StringUtil.h"
+
+namespace
+{
+    struct BenchOptions
+    {
+        std::vector<std::string> MediaPaths;
+        std::string BiosFolder;
+        std::string OutputPath;
+        std::string BaselinePath;
+        std::uint64_t FrameCount = 3000;
+        std::uint64_t WarmupFrameCount = 300;
+        double TolerancePercent = 5.0;
+        bool MeasureStateRoundTrip = false;
+    };
+
+    struct BenchResult
+    {
+        std::string Name;
+        std::string System;
+        std::uint64_t FrameCount = 0;
+        double FramesPerSecond = 0.0;
+        std::vector<std::uint64_t> FrameNs;
+        std::uint64_t EmulationNs = 0;
+        std::uint64_t AudioNs = 0;
+        std::uint64_t VideoNs = 0;
+        std::size_t StateSize = 0;
+        std::vector<std::uint64_t> SaveStateNs;
+        std::vector<std::uint64_t> LoadStateNs;
+    };
+
+    FrameMailbox BenchMailbox;
+
+    void BenchRenderCallback(const FrameBufferView& View)
+    {
+        // Same guard as the application, a 0 height would underflow the pixel count below.
+        if (View.Width == 0 || View.Height == 0)
+            return;
+
+        VideoFrame& Frame = BenchMailbox.BeginWrite();
+        Frame.Width = View.Width;
+        Frame.Height = View.Height;
+        Frame.Pitch = View.Pitch;
+
+        const std::uint32_t* FirstPixel = View.Pixels + static_cast<std::size_t>(View.Y) * View.Pitch + View.X;
+        const std::size_t PixelCount = static_cast<std::size_t>(View.Height - 1) * View.Pitch + View.Width;
+        Frame.Pixels.assign(FirstPixel, FirstPixel + PixelCount);
+
+        BenchMailbox.Publish();
+        static_cast<void>(BenchMailbox.Acquire());
+    }
+
+    void BenchAudioCallback(std::uint32_t, std::span<std::int16_t>)
+    {
+    }
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: Ultipugna-bench [options] <media>...\n"
+            "  --manifest FILE        Read media paths from FILE (one per line, relative to FILE)\n"
+            "  --frames N             Number of timed frames per media (default 3000)\n"
+            "  --warmup N             Number of untimed frames before measuring (default 300)\n"
+            "  --bios DIR             Folder containing the BIOS files\n"
+            "  --output FILE          Write the JSON report to FILE instead of stdout\n"
+            "  --baseline FILE        Compare frames/s against a previous JSON report\n"
+            "  --tolerance PCT        Allowed frames/s drop against the baseline (default 5)\n"
+            "  --state-roundtrip      Also time a state save and load per frame\n";
+    }
+
+    bool ReadManifest(const std::filesystem::path& ManifestPath, std::vector<std::string>& MediaPaths)
+    {
+        std::vector<std::string> Lines;
+
+        if (!ReadManifestLines(ManifestPath, Lines))
+            return false;
+
+        for (const std::string& Line : Lines)
+            MediaPaths.push_back((ManifestPath.parent_path() / Line).string());
+
+        // The checked-in manifest only lists examples, the ROMs are not redistributable with the repository.
+        if (Lines.empty())
+            std::cerr << ManifestPath.string() << " lists no media: add the paths of the ROMs to benchmark to it, see its comments\n";
+
+        return true;
+    }
+
+    bool ParseOptions(int ArgumentCount, char** Arguments, BenchOptions& Options)
+    {
+        for (int Index = 1; Index < ArgumentCount; ++Index)
+        {
+            const std::string_view Argument = Arguments[Index];
+            const bool HasValue = Index + 1 < ArgumentCount;
+
+            if (Argument == "--frames" && HasValue)
+            {
+                if (!StringToNumber(std::string_view(Arguments[++Index]), Options.FrameCount) || Options.FrameCount == 0)
+                    return false;
+            }
+            else if (Argument == "--warmup" && HasValue)
+            {
+                if (!StringToNumber(std::string_view(Arguments[++Index]), Options.WarmupFrameCount))
+                    return false;
+            }
+            else if (Argument == "--tolerance" && HasValue)
+            {
+                const std::string_view Value = Arguments[++Index];
+                const std::from_chars_result Result = std::from_chars(Value.data(), Value.data() + Value.size(), Options.TolerancePercent);
+
+                if (Result.ec != std::errc{} || Result.ptr != Value.data() + Value.size() || Options.TolerancePercent < 0.0)
+                {
+                    std::cerr << "Invalid --tolerance value: " << Value << '\n';
+                    return false;
+                }
+            }
+            else if (Argument == "--manifest" && HasValue)
+            {
+                if (!ReadManifest(Arguments[++Index], Options.MediaPaths))
+                    return false;
+            }
+            else if (Argument == "--bios" && HasValue)
+            {
+                Options.BiosFolder = Arguments[++Index];
+            }
+            else if (Argument == "--output" && HasValue)
+            {
+                Options.OutputPath = Arguments[++Index];
+            }
+            else if (Argument == "--baseline" && HasValue)
+            {
+                Options.BaselinePath = Arguments[++Index];
+            }
+            else if (Argument == "--state-roundtrip")
+            {
+                Options.MeasureStateRoundTrip = true;
+            }
+            else if (!Argument.starts_with("--"))
+            {
+                Options.MediaPaths.emplace_back(Argument);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return !Options.MediaPaths.empty();
+    }
+
+    std::uint64_t ElapsedNs(std::chrono::steady_clock::time_point Start)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
+    }
+
+    // Same path as run-ahead: the state goes to a buffer allocated once and is loaded back from it.
+    void MeasureStateRoundTrip(IEmulatorCore& Core, const BenchOptions& Options, BenchResult& Result)
+    {
+        std::vector<std::byte> StateBuffer(Core.GetStateSize());
+        Result.SaveStateNs.resize(Options.FrameCount);
+        Result.LoadStateNs.resize(Options.FrameCount);
+
+        for (std::uint64_t Frame = 0; Frame < Options.FrameCount; ++Frame)
+        {
+            Core.DoFrame();
+
+            const std::chrono::steady_clock::time_point SaveStart = std::chrono::steady_clock::now();
+            Result.StateSize = Core.SaveState(StateBuffer);
+            Result.SaveStateNs[Frame] = ElapsedNs(SaveStart);
+
+            const std::chrono::steady_clock::time_point LoadStart = std::chrono::steady_clock::now();
+            if (Core.LoadState(StateBuffer))
+                std::cerr << "LoadState failed at frame " << Frame << '\n';
+            Result.LoadStateNs[Frame] = ElapsedNs(LoadStart);
+        }
+    }
+
+    bool RunBench(IEmulatorCore& Core, const std::string& MediaPath, const BenchOptions& Options, BenchResult& Result)
+    {
+        Core.Initialize();
+
+        if (const std::error_code Error = Core.InsertMediaSource(MediaPath, 0); Error != std::error_code{})
+        {
+            std::cerr << "Unable to load " << MediaPath << ": " << Error.message() << '\n';
+            Core.Shutdown();
+            return false;
+        }
+
+        Result.Name = std::filesystem::path(MediaPath).filename().string();
+        Result.System = Core.GetSystemName();
+        Result.FrameCount = Options.FrameCount;
+        Result.FrameNs.resize(Options.FrameCount);
+
+        for (std::uint64_t Frame = 0; Frame < Options.WarmupFrameCount; ++Frame)
+            Core.DoFrame();
+
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point BenchStart = Clock::now();
+
+        for (std::uint64_t& FrameNs : Result.FrameNs)
+        {
+            const Clock::time_point FrameStart = Clock::now();
+            Core.DoFrame();
+            FrameNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - FrameStart).count());
+
+            const FrameStageTimings& Timings = Core.GetLastFrameTimings();
+            Result.EmulationNs += Timings.EmulationNs;
+            Result.AudioNs += Timings.AudioNs;
+            Result.VideoNs += Timings.VideoNs;
+        }
+
+        const double ElapsedSeconds = std::chrono::duration<double>(Clock::now() - BenchStart).count();
+        Result.FramesPerSecond = ElapsedSeconds > 0.0 ? static_cast<double>(Options.FrameCount) / ElapsedSeconds : 0.0;
+
+        if (Options.MeasureStateRoundTrip)
+            MeasureStateRoundTrip(Core, Options, Result);
+
+        Core.Shutdown();
+        return true;
+    }
+
+    std::uint64_t Percentile(const std::vector<std::uint64_t>& SortedValues, double Fraction)
+    {
+        const std::size_t Index = std::min(SortedValues.size() - 1, static_cast<std::size_t>(Fraction * static_cast<double>(SortedValues.size())));
+        return SortedValues[Index];
+    }
+
+    std::string EscapeJson(std::string_view Text)
+    {
+        std::string Escaped;
+        for (const char Character : Text)
+        {
+            if (Character == '"' || Character == '\\')
+                Escaped += '\\';
+            Escaped += Character;
+        }
+        return Escaped;
+    }
+
+    void WriteReport(std::ostream& Stream, const std::vector<BenchResult>& Results)
+    {
+        Stream << "{\n  \"results\": [\n";
+
+        for (std::size_t Index = 0; Index < Results.size(); ++Index)
+        {
+            const BenchResult& Result = Results[Index];
+            std::vector<std::uint64_t> SortedNs = Result.FrameNs;
+            std::ranges::sort(SortedNs);
+
+            const double FrameCount = static_cast<double>(Result.FrameCount);
+            char Buffer[1024];
+            std::snprintf(Buffer, sizeof(Buffer),
+                "    {\n"
+                "      \"rom\": \"%s\",\n"
+                "      \"system\": \"%s\",\n"
+                "      \"frames\": %llu,\n"
+                "      \"frames_per_second\": %.2f,\n"
+                "      \"ns_per_frame\": { \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu },\n"
+                "      \"mean_ns_per_stage\": { \"emulation\": %.0f, \"audio\": %.0f, \"video\": %.0f }%s\n",
+                EscapeJson(Result.Name).c_str(),
+                EscapeJson(Result.System).c_str(),
+                static_cast<unsigned long long>(Result.FrameCount),
+                Result.FramesPerSecond,
+                static_cast<unsigned long long>(Percentile(SortedNs, 0.50)),
+                static_cast<unsigned long long>(Percentile(SortedNs, 0.90)),
+                static_cast<unsigned long long>(Percentile(SortedNs, 0.99)),
+                static_cast<unsigned long long>(SortedNs.back()),
+                static_cast<double>(Result.EmulationNs) / FrameCount,
+                static_cast<double>(Result.AudioNs) / FrameCount,
+                static_cast<double>(Result.VideoNs) / FrameCount,
+                Result.SaveStateNs.empty() ? "" : ",");
+            Stream << Buffer;
+
+            if (!Result.SaveStateNs.empty())
+            {
+                std::vector<std::uint64_t> SortedSaveNs = Result.SaveStateNs;
+                std::vector<std::uint64_t> SortedLoadNs = Result.LoadStateNs;
+                std::ranges::sort(SortedSaveNs);
+                std::ranges::sort(SortedLoadNs);
+
+                std::snprintf(Buffer, sizeof(Buffer),
+                    "      \"state_roundtrip\": {\n"
+                    "        \"state_bytes\": %zu,\n"
+                    "        \"save_ns\": { \"p50\": %llu, \"p99\": %llu, \"max\": %llu },\n"
+                    "        \"load_ns\": { \"p50\": %llu, \"p99\": %llu, \"max\": %llu }\n"
+                    "      }\n",
+                    Result.StateSize,
+                    static_cast<unsigned long long>(Percentile(SortedSaveNs, 0.50)),
+                    static_cast<unsigned long long>(Percentile(SortedSaveNs, 0.99)),
+                    static_cast<unsigned long long>(SortedSaveNs.back()),
+                    static_cast<unsigned long long>(Percentile(SortedLoadNs, 0.50)),
+                    static_cast<unsigned long long>(Percentile(SortedLoadNs, 0.99)),
+                    static_cast<unsigned long long>(SortedLoadNs.back()));
+                Stream << Buffer;
+            }
+
+            Stream << "    }" << (Index + 1 < Results.size() ? "," : "") << '\n';
+        }
+
+        Stream << "  ]\n}\n";
+    }
+
+    // Only understands reports written by WriteReport(): pairs each "rom" with the following "frames_per_second".
+    std::map<std::string, double> ReadBaseline(const std::string& BaselinePath)
+    {
+        std::map<std::string, double> Baseline;
+        std::ifstream Stream { BaselinePath };
+
+        if (!Stream)
+        {
+            std::cerr << "Unable to read the baseline " << BaselinePath << ", nothing to compare against\n";
+            return Baseline;
+        }
+        std::stringstream Content;
+        Content << Stream.rdbuf();
+        const std::string Text = Content.str();
+
+        constexpr std::string_view RomKey = "\"rom\": \"";
+        constexpr std::string_view FpsKey = "\"frames_per_second\": ";
+
+        for (std::size_t RomPosition = Text.find(RomKey); RomPosition != std::string::npos; RomPosition = Text.find(RomKey, RomPosition + 1))
+        {
+            const std::size_t NameStart = RomPosition + RomKey.size();
+            const std::size_t NameEnd = Text.find('"', NameStart);
+            const std::size_t FpsPosition = Text.find(FpsKey, NameEnd);
+
+            if (NameEnd == std::string::npos || FpsPosition == std::string::npos)
+                break;
+
+            Baseline[Text.substr(NameStart, NameEnd - NameStart)] = std::strtod(Text.c_str() + FpsPosition + FpsKey.size(), nullptr);
+        }
+
+        return Baseline;
+    }
+}
+
+int main(int ArgumentCount, char** Arguments)
+{
+    BenchOptions Options;
+
+    if (!ParseOptions(ArgumentCount, Arguments, Options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::unique_ptr<IEmulatorCore> Core = std::make_unique<GenesisPlusGX>();
+
+    if (!Options.BiosFolder.empty())
+        Core->SetSettingValue("Bios Folder", Options.BiosFolder);
+
+    Core->SetRenderCallback(&BenchRenderCallback);
+    Core->SetAudioCallback(&BenchAudioCallback);
+    IEmulatorCore::SetCurrent(Core.get());
+
+    std::vector<BenchResult> Results;
+
+    for (const std::string& MediaPath : Options.MediaPaths)
+    {
+        if (BenchResult Result; RunBench(*Core, MediaPath, Options, Result))
+        {
+            std::cerr << Result.Name << " (" << Result.System << "): " << Result.FramesPerSecond << " frames/s\n";
+            Results.push_back(std::move(Result));
+        }
+    }
+
+    IEmulatorCore::SetCurrent(nullptr);
+
+    if (Options.OutputPath.empty())
+    {
+        WriteReport(std::cout, Results);
+    }
+    else if (std::ofstream Output { Options.OutputPath, std::ios::trunc })
+    {
+        WriteReport(Output, Results);
+    }
+
+    int ExitCode = Results.size() == Options.MediaPaths.size() ? 0 : 2;
+
+    if (!Options.BaselinePath.empty())
+    {
+        const std::map<std::string, double> Baseline = ReadBaseline(Options.BaselinePath);
+
+        for (const BenchResult& Result : Results)
+        {
+            const auto BaselineResult = Baseline.find(Result.Name);
+
+            if (BaselineResult == Baseline.end() || BaselineResult->second <= 0.0)
+            {
+                std::fprintf(stderr, "%-40s no baseline entry, record one with --output\n", Result.Name.c_str());
+                continue;
+            }
+
+            const double ChangePercent = (Result.FramesPerSecond / BaselineResult->second - 1.0) * 100.0;
+            const bool IsRegression = ChangePercent < -Options.TolerancePercent;
+
+            std::fprintf(stderr, "%-40s %10.2f -> %10.2f frames/s (%+.1f%%)%s\n", Result.Name.c_str(),
+                BaselineResult->second, Result.FramesPerSecond, ChangePercent, IsRegression ? "  REGRESSION" : "");
+
+            if (IsRegression)
+                ExitCode = 3;
+        }
+    }
+
+    return ExitCode;
+}
@@ -0,0 +1,122 @@
+// Measures the per-frame cost of moving the emulated picture from the core frame buffer to the frame mailbox.
+// "Before" reproduces the old GenesisPlusGX::DoFrame path (fresh vector per frame, column-major viewport copy,
+// then the mailbox copy), "After" is the strided FrameBufferView handoff (one contiguous copy into a reused slot).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Util/FrameMailbox.h"
+
+namespace
+{
+    constexpr std::uint32_t BitmapWidth = 720;
+    constexpr std::uint32_t BitmapHeight = 576;
+    constexpr int WarmupIterations = 200;
+    constexpr int MeasureIterations = 5000;
+
+    struct Viewport
+    {
+        const char* Name;
+        std::uint32_t X;
+        std::uint32_t Y;
+        std::uint32_t Width;
+        std::uint32_t Height;
+    };
+
+    void HandoffBefore(const std::vector<std::uint32_t>& Bitmap, const Viewport& View, FrameMailbox& Mailbox)
+    {
+        std::vector<std::uint32_t> FrameBuffer(View.Width * View.Height);
+
+        for (std::uint32_t X = 0; X < View.Width; X++)
+        {
+            for (std::uint32_t Y = 0; Y < View.Height; Y++)
+            {
+                FrameBuffer[X + Y * View.Width] = Bitmap[(Y + View.Y) * BitmapWidth + (X + View.X)];
+            }
+        }
+
+        VideoFrame& Frame = Mailbox.BeginWrite();
+        Frame.Width = View.Width;
+        Frame.Height = View.Height;
+        Frame.Pitch = View.Width;
+        Frame.Pixels.assign(FrameBuffer.begin(), FrameBuffer.end());
+        Mailbox.Publish();
+    }
+
+    void HandoffAfter(const std::vector<std::uint32_t>& Bitmap, const Viewport& View, FrameMailbox& Mailbox)
+    {
+        VideoFrame& Frame = Mailbox.BeginWrite();
+        Frame.Width = View.Width;
+        Frame.Height = View.Height;
+        Frame.Pitch = BitmapWidth;
+
+        const std::uint32_t* FirstPixel = Bitmap.data() + static_cast<std::size_t>(View.Y) * BitmapWidth + View.X;
+        const std::size_t PixelCount = static_cast<std::size_t>(View.Height - 1) * BitmapWidth + View.Width;
+        Frame.Pixels.assign(FirstPixel, FirstPixel + PixelCount);
+        Mailbox.Publish();
+    }
+
+    template<typename HandoffFunction>
+    void Measure(const char* Label, const Viewport& View, HandoffFunction Handoff)
+    {
+        std::vector<std::uint32_t> Bitmap(BitmapWidth * BitmapHeight);
+        for (std::size_t Index = 0; Index < Bitmap.size(); ++Index)
+            Bitmap[Index] = static_cast<std::uint32_t>(Index * 2654435761u);
+
+        FrameMailbox Mailbox;
+        std::uint64_t Checksum = 0;
+
+        auto Consume = [&]()
+        {
+            if (const VideoFrame* Frame = Mailbox.Acquire())
+                Checksum += Frame->Pixels[Frame->Pixels.size() / 2];
+        };
+
+        for (int Iteration = 0; Iteration < WarmupIterations; ++Iteration)
+        {
+            Handoff(Bitmap, View, Mailbox);
+            Consume();
+        }
+
+        std::vector<std::int64_t> Samples(MeasureIterations);
+
+        for (std::int64_t& Sample : Samples)
+        {
+            const auto Start = std::chrono::steady_clock::now();
+            Handoff(Bitmap, View, Mailbox);
+            const auto End = std::chrono::steady_clock::now();
+            Sample = std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count();
+            Consume();
+        }
+
+        std::ranges::sort(Samples);
+        const std::int64_t Median = Samples[Samples.size() / 2];
+        const std::int64_t P99 = Samples[Samples.size() * 99 / 100];
+
+        std::printf("%-8s %-24s median %8lld ns  p99 %8lld ns  (checksum %llx)\n", Label, View.Name,
+            static_cast<long long>(Median), static_cast<long long>(P99), static_cast<unsigned long long>(Checksum));
+    }
+}
+
+int main(int, char**)
+{
+    constexpr Viewport Viewports[] =
+    {
+        { "Genesis H40 320x224", 0, 0, 320, 224 },
+        { "Genesis H40 PAL 320x240", 0, 0, 320, 240 },
+        { "Master System 256x192", 0, 0, 256, 192 },
+        { "Overscan 348x240", 14, 8, 348, 240 },
+    };
+
+    for (const Viewport& View : Viewports)
+    {
+        Measure("Before", View, HandoffBefore);
+        Measure("After", View, HandoffAfter);
+    }
+
+    return 0;
+}
@@ -0,0 +1,755 @@
+// Ultipugna-headless: runs an emulator core without any display, as fast as the host allows.
+// Used for ROM validation and bot workloads on servers where AppFramework cannot initialize.
+// Several media, a manifest or --jobs switch to batch mode: the jobs run in forked worker processes (see WorkerPool.h)
+// while this process writes the dumped frames and audio they hand back.
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "CoreWrapper/GenesisPlusGX.h"
+#include "CoreWrapper/InputMovie.h"
+#include "Util/HashUtil.h"
+#include "Util/ManifestFile.h"
+#include "Util/StringUtil.h"
+#include "Latency.h"
+#include "Regression.h"
+#include "Thumbnails.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    struct HeadlessOptions
+    {
+        std::vector<std::string> MediaPaths;
+        std::string BiosFolder;
+        std::string FrameDumpFolder;
+        std::string AudioDumpPath;
+        std::string MoviePath;
+        std::uint64_t FrameCount = 3600;
+        bool HasFrameCount = false;
+        std::uint64_t SeekFrame = 0;
+        bool HasSeekFrame = false;
+        bool IsTurboSeek = false;
+        std::uint64_t FrameDumpInterval = 0;
+        std::uint64_t HashInterval = 0;
+        std::uint32_t WorkerCount = 0;
+        RegressionOptions Regression;
+        bool IsMeasuringLatency = false;
+        LatencyOptions Latency;
+        bool IsGeneratingThumbnails = false;
+        ThumbnailOptions Thumbnails;
+    };
+
+    struct HeadlessState
+    {
+        std::uint64_t FrameIndex = 0;
+        std::uint64_t VideoHash = 0;
+        std::uint64_t AudioHash = 0;
+        std::uint64_t AudioSampleCount = 0;
+        const HeadlessOptions* Options = nullptr;
+        std::ofstream AudioStream;
+
+        // Batch mode: frames and audio go to the supervisor instead of the disk.
+        SharedFrameRing* Ring = nullptr;
+        SharedFrame* PendingFrame = nullptr;
+        std::uint32_t JobIndex = 0;
+    };
+
+    struct JobSummary
+    {
+        std::uint64_t VideoHash = 0;
+        std::uint64_t AudioHash = 0;
+        std::uint64_t StateHash = 0;
+        double Seconds = 0.0;
+        std::uint64_t FrameCount = 0;
+        std::uint32_t AudioSampleRate = 0;
+    };
+
+    // Core callbacks are plain function pointers, the runner only ever drives one core per process.
+    HeadlessState State;
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: Ultipugna-headless <media>... [options]\n"
+            "  --frames N             Number of frames to emulate (default 3600)\n"
+            "  --bios DIR             Folder containing the BIOS files\n"
+            "  --dump-frames DIR      Write frames as PPM images into DIR\n"
+            "  --dump-every N         Only dump one frame every N frames (default 1)\n"
+            "  --dump-audio FILE      Write the emulated audio as a 16-bit stereo WAV file (a folder in batch mode)\n"
+            "  --hash-every N         Print video, audio and state hashes every N frames\n"
+            "  --movie FILE           Play the inputs of a movie, runs the whole movie unless --frames is given\n"
+            "  --seek N               Seek the movie to frame N before emulating, through its closest keyframe\n"
+            "  --turbo                Skip rendering while seeking (faster, may not be bit exact)\n"
+            "  --manifest FILE        Add the media listed in FILE, one path per line relative to FILE\n"
+            "  --jobs N               Run the media in N worker processes (default: one per hardware thread)\n"
+            "  --regress FILE         Replay the movies of a regression manifest and compare them with the golden hashes\n"
+            "  --golden DIR           Golden hash folder (default: Golden next to the regression manifest)\n"
+            "  --update-golden        Write the golden hashes or the latency baseline that differ instead of failing\n"
+            "  --latency              Model the input-to-present latency of every pacing, run-ahead and buffering setup from\n"
+            "                         the measured core response, after the movie or --frames frames (default 300)\n"
+            "  --latency-input NAME   Input pressed by --latency (Up Down Left Right A B C X Y Z Start Mode, default Start)\n"
+            "  --baseline FILE        Latency baseline, fails when a setup got slower, written when missing\n"
+            "  --host-hz N            Display refresh rate simulated by --latency (default 60)\n"
+            "  --thumbnails           Generate the thumbnails of the library's ROMs missing from the thumbnail atlas,\n"
+            "                         captured after --frames frames (default 600)\n"
+            "  --library FILE         Library index read by --thumbnails (default: Library.idx in the preference folder)\n"
+            "  --atlas FILE           Thumbnail atlas written by --thumbnails (default: Thumbnails.atlas in the preference folder)\n"
+            "Batch mode only reports the last hashes of each media, frames are dumped into one subfolder per media.\n";
+    }
+
+    bool ReadManifest(const std::filesystem::path& ManifestPath, std::vector<std::string>& MediaPaths)
+    {
+        std::vector<std::string> Lines;
+
+        if (!ReadManifestLines(ManifestPath, Lines))
+            return false;
+
+        for (const std::string& Line : Lines)
+            MediaPaths.push_back((ManifestPath.parent_path() / Line).string());
+
+        return true;
+    }
+
+    bool ParseOptions(int ArgumentCount, char** Arguments, HeadlessOptions& Options)
+    {
+        for (int Index = 1; Index < ArgumentCount; ++Index)
+        {
+            const std::string_view Argument = Arguments[Index];
+            const bool HasValue = Index + 1 < ArgumentCount;
+
+            auto ParseNumber = [&](std::uint64_t& Value)
+            {
+                return HasValue && StringToNumber(std::string_view(Arguments[++Index]), Value);
+            };
+
+            if (Argument == "--frames")
+            {
+                if (!ParseNumber(Options.FrameCount))
+                    return false;
+
+                Options.HasFrameCount = true;
+            }
+            else if (Argument == "--dump-every")
+            {
+                if (!ParseNumber(Options.FrameDumpInterval))
+                    return false;
+            }
+            else if (Argument == "--hash-every")
+            {
+                if (!ParseNumber(Options.HashInterval))
+                    return false;
+            }
+            else if (Argument == "--seek")
+            {
+                if (!ParseNumber(Options.SeekFrame))
+                    return false;
+
+                Options.HasSeekFrame = true;
+            }
+            else if (Argument == "--turbo")
+            {
+                Options.IsTurboSeek = true;
+            }
+            else if (Argument == "--movie" && HasValue)
+            {
+                Options.MoviePath = Arguments[++Index];
+            }
+            else if (Argument == "--jobs")
+            {
+                std::uint64_t WorkerCount = 0;
+
+                if (!ParseNumber(WorkerCount) || WorkerCount == 0 || WorkerCount > 1024)
+                    return false;
+
+                Options.WorkerCount = static_cast<std::uint32_t>(WorkerCount);
+            }
+            else if (Argument == "--regress" && HasValue)
+            {
+                Options.Regression.ManifestPath = Arguments[++Index];
+            }
+            else if (Argument == "--golden" && HasValue)
+            {
+                Options.Regression.GoldenFolder = Arguments[++Index];
+            }
+            else if (Argument == "--update-golden")
+            {
+                Options.Regression.IsUpdatingGolden = true;
+                Options.Latency.IsUpdatingBaseline = true;
+            }
+            else if (Argument == "--latency")
+            {
+                Options.IsMeasuringLatency = true;
+            }
+            else if (Argument == "--latency-input" && HasValue)
+            {
+                if (!ControllerInputFromName(Arguments[++Index], Options.Latency.Input))
+                    return false;
+            }
+            else if (Argument == "--baseline" && HasValue)
+            {
+                Options.Latency.BaselinePath = Arguments[++Index];
+            }
+            else if (Argument == "--host-hz" && HasValue)
+            {
+                const std::string_view Value = Arguments[++Index];
+
+                if (std::from_chars(Value.data(), Value.data() + Value.size(), Options.Latency.HostRefreshRate).ec != std::errc{} ||
+                    Options.Latency.HostRefreshRate < 1.0)
+                    return false;
+            }
+            else if (Argument == "--thumbnails")
+            {
+                Options.IsGeneratingThumbnails = true;
+            }
+            else if (Argument == "--library" && HasValue)
+            {
+                Options.Thumbnails.LibraryIndexPath = Arguments[++Index];
+            }
+            else if (Argument == "--atlas" && HasValue)
+            {
+                Options.Thumbnails.AtlasPath = Arguments[++Index];
+            }
+            else if (Argument == "--manifest" && HasValue)
+            {
+                if (!ReadManifest(Arguments[++Index], Options.MediaPaths))
+                    return false;
+            }
+            else if (Argument == "--bios" && HasValue)
+            {
+                Options.BiosFolder = Arguments[++Index];
+            }
+            else if (Argument == "--dump-frames" && HasValue)
+            {
+                Options.FrameDumpFolder = Arguments[++Index];
+            }
+            else if (Argument == "--dump-audio" && HasValue)
+            {
+                Options.AudioDumpPath = Arguments[++Index];
+            }
+            else if (!Argument.starts_with("--"))
+            {
+                Options.MediaPaths.emplace_back(Argument);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (!Options.FrameDumpFolder.empty() && Options.FrameDumpInterval == 0)
+            Options.FrameDumpInterval = 1;
+
+        if (Options.HasSeekFrame && Options.MoviePath.empty())
+        {
+            std::cerr << "--seek needs a movie to seek in, pass it with --movie\n";
+            return false;
+        }
+
+        // A movie belongs to one media.
+        if (!Options.MoviePath.empty() && (Options.MediaPaths.size() != 1 || Options.WorkerCount != 0))
+            return false;
+
+        if (Options.IsMeasuringLatency)
+        {
+            if (Options.MediaPaths.size() != 1 || Options.WorkerCount != 0)
+                return false;
+
+            Options.Latency.MediaPath = Options.MediaPaths.front();
+            Options.Latency.BiosFolder = Options.BiosFolder;
+            Options.Latency.MoviePath = Options.MoviePath;
+
+            if (Options.HasFrameCount)
+                Options.Latency.WarmupFrames = Options.FrameCount;
+
+            return true;
+        }
+
+        if (Options.IsGeneratingThumbnails)
+        {
+            Options.Thumbnails.BiosFolder = Options.BiosFolder;
+            Options.Thumbnails.WorkerCount = Options.WorkerCount;
+
+            if (Options.HasFrameCount)
+                Options.Thumbnails.FrameCount = Options.FrameCount;
+
+            return Options.MediaPaths.empty() && Options.Thumbnails.FrameCount != 0;
+        }
+
+        if (!Options.Regression.ManifestPath.empty())
+        {
+            Options.Regression.BiosFolder = Options.BiosFolder;
+            Options.Regression.WorkerCount = Options.WorkerCount;
+            return Options.MediaPaths.empty();
+        }
+
+        return !Options.MediaPaths.empty();
+    }
+
+    void WriteWavHeader(std::ofstream& Stream, std::uint32_t SampleRate, std::uint64_t SampleCount)
+    {
+        auto Write32 = [&](std::uint32_t Value) { Stream.write(reinterpret_cast<const char*>(&Value), 4); };
+        auto Write16 = [&](std::uint16_t Value) { Stream.write(reinterpret_cast<const char*>(&Value), 2); };
+
+        constexpr std::uint16_t ChannelCount = 2;
+        constexpr std::uint16_t BytesPerSample = 2;
+        const std::uint32_t DataSize = static_cast<std::uint32_t>(SampleCount * ChannelCount * BytesPerSample);
+
+        Stream.seekp(0);
+        Stream.write("RIFF", 4);
+        Write32(36 + DataSize);
+        Stream.write("WAVEfmt ", 8);
+        Write32(16);
+        Write16(1);
+        Write16(ChannelCount);
+        Write32(SampleRate);
+        Write32(SampleRate * ChannelCount * BytesPerSample);
+        Write16(ChannelCount * BytesPerSample);
+        Write16(BytesPerSample * 8);
+        Stream.write("data", 4);
+        Write32(DataSize);
+    }
+
+    void DumpFrame(const std::filesystem::path& Folder, std::uint64_t FrameIndex, const FrameBufferView& Frame)
+    {
+        char FileName[32];
+        std::snprintf(FileName, sizeof(FileName), "frame_%06llu.ppm", static_cast<unsigned long long>(FrameIndex));
+
+        if (std::ofstream Stream { Folder / FileName, std::ios::binary })
+        {
+            Stream << "P6\n" << Frame.Width << ' ' << Frame.Height << "\n255\n";
+
+            std::vector<char> Row(Frame.Width * 3);
+
+            for (std::uint32_t Y = 0; Y < Frame.Height; ++Y)
+            {
+                const std::uint32_t* Pixels = Frame.Pixels + static_cast<std::size_t>(Frame.Y + Y) * Frame.Pitch + Frame.X;
+
+                for (std::uint32_t X = 0; X < Frame.Width; ++X)
+                {
+                    Row[X * 3 + 0] = static_cast<char>((Pixels[X] >> 16) & 0xff);
+                    Row[X * 3 + 1] = static_cast<char>((Pixels[X] >> 8) & 0xff);
+                    Row[X * 3 + 2] = static_cast<char>(Pixels[X] & 0xff);
+                }
+
+                Stream.write(Row.data(), static_cast<std::streamsize>(Row.size()));
+            }
+        }
+    }
+
+    // Worker side of batch mode, one ring slot carries the dumped frame and the audio of one emulated frame.
+    SharedFrame& AcquireSharedFrame()
+    {
+        if (State.PendingFrame == nullptr)
+        {
+            // The supervisor only writes files, it catches up quickly.
+            while ((State.PendingFrame = State.Ring->TryBeginWrite()) == nullptr)
+                std::this_thread::yield();
+
+            State.PendingFrame->JobIndex = State.JobIndex;
+            State.PendingFrame->FrameIndex = State.FrameIndex;
+            State.PendingFrame->Width = 0;
+            State.PendingFrame->Height = 0;
+            State.PendingFrame->SampleCount = 0;
+        }
+
+        return *State.PendingFrame;
+    }
+
+    void PublishSharedFrame()
+    {
+        if (State.PendingFrame != nullptr)
+        {
+            State.Ring->EndWrite();
+            State.PendingFrame = nullptr;
+        }
+    }
+
+    void ShareFrame(const FrameBufferView& Frame)
+    {
+        if (static_cast<std::size_t>(Frame.Width) * Frame.Height > MaxSharedFramePixels)
+            return;
+
+        SharedFrame& Shared = AcquireSharedFrame();
+        Shared.Width = Frame.Width;
+        Shared.Height = Frame.Height;
+
+        for (std::uint32_t Y = 0; Y < Frame.Height; ++Y)
+        {
+            const std::uint32_t* Pixels = Frame.Pixels + static_cast<std::size_t>(Frame.Y + Y) * Frame.Pitch + Frame.X;
+            std::copy_n(Pixels, Frame.Width, Shared.Pixels + static_cast<std::size_t>(Y) * Frame.Width);
+        }
+    }
+
+    void ShareAudio(std::span<const std::int16_t> Samples)
+    {
+        while (!Samples.empty())
+        {
+            SharedFrame& Shared = AcquireSharedFrame();
+            const std::size_t Count = std::min<std::size_t>(Samples.size(), MaxSharedFrameSamples - Shared.SampleCount);
+
+            std::copy_n(Samples.data(), Count, Shared.Samples + Shared.SampleCount);
+            Shared.SampleCount += static_cast<std::uint32_t>(Count);
+            Samples = Samples.subspan(Count);
+
+            if (Shared.SampleCount == MaxSharedFrameSamples)
+                PublishSharedFrame();
+        }
+    }
+
+    void HeadlessRenderCallback(const FrameBufferView& Frame)
+    {
+        const HeadlessOptions& Options = *State.Options;
+
+        if (Options.HashInterval != 0 && (State.FrameIndex + 1) % Options.HashInterval == 0)
+        {
+            State.VideoHash = FNV1A_64Offset;
+
+            for (std::uint32_t Y = 0; Y < Frame.Height; ++Y)
+            {
+                const std::uint32_t* Pixels = Frame.Pixels + static_cast<std::size_t>(Frame.Y + Y) * Frame.Pitch + Frame.X;
+
+                for (std::uint32_t X = 0; X < Frame.Width; ++X)
+                    FNV1A_64Uint32(State.VideoHash, Pixels[X]);
+            }
+        }
+
+        if (Options.FrameDumpInterval != 0 && State.FrameIndex % Options.FrameDumpInterval == 0)
+        {
+            if (State.Ring != nullptr)
+                ShareFrame(Frame);
+            else
+                DumpFrame(Options.FrameDumpFolder, State.FrameIndex, Frame);
+        }
+    }
+
+    void HeadlessAudioCallback(std::uint32_t NumChannels, std::span<std::int16_t> Samples)
+    {
+        if (State.Options->HashInterval != 0)
+        {
+            for (const std::int16_t Sample : Samples)
+            {
+                FNV1A_64Update(State.AudioHash, static_cast<std::uint16_t>(Sample) & 0xff);
+                FNV1A_64Update(State.AudioHash, static_cast<std::uint16_t>(Sample) >> 8);
+            }
+        }
+
+        if (State.Ring != nullptr && !State.Options->AudioDumpPath.empty() && NumChannels == 2)
+        {
+            ShareAudio(Samples);
+        }
+        else if (State.AudioStream && NumChannels == 2)
+        {
+            State.AudioStream.write(reinterpret_cast<const char*>(Samples.data()), static_cast<std::streamsize>(Samples.size_bytes()));
+            State.AudioSampleCount += Samples.size() / NumChannels;
+        }
+    }
+
+    int RunMedia(const std::string& MediaPath, bool PrintHashes, JobSummary& Summary)
+    {
+        const HeadlessOptions& Options = *State.Options;
+
+        State.VideoHash = 0;
+        State.AudioHash = FNV1A_64Offset;
+        State.AudioSampleCount = 0;
+
+        const std::unique_ptr<IEmulatorCore> Core = std::make_unique<GenesisPlusGX>();
+        Summary.AudioSampleRate = Core->GetAudioSampleRate();
+
+        if (!Options.BiosFolder.empty())
+            Core->SetSettingValue("Bios Folder", Options.BiosFolder);
+
+        // Skip the frame buffer handoff entirely when nobody looks at the picture.
+        if (Options.HashInterval != 0 || Options.FrameDumpInterval != 0)
+            Core->SetRenderCallback(&HeadlessRenderCallback);
+
+        if (Options.HashInterval != 0 || State.AudioStream || (State.Ring != nullptr && !Options.AudioDumpPath.empty()))
+            Core->SetAudioCallback(&HeadlessAudioCallback);
+
+        IEmulatorCore::SetCurrent(Core.get());
+        Core->Initialize();
+
+        if (const std::error_code Error = Core->InsertMediaSource(MediaPath, 0); Error != std::error_code{})
+        {
+            std::cerr << "Unable to load " << MediaPath << ": " << Error.message() << '\n';
+            Core->Shutdown();
+            IEmulatorCore::SetCurrent(nullptr);
+            return 2;
+        }
+
+        InputMoviePlayer Movie;
+        std::uint64_t FrameCount = Options.FrameCount;
+
+        if (!Options.MoviePath.empty())
+        {
+            std::uint64_t MediaHash = 0;
+            std::error_code Error = Movie.Open(Options.MoviePath);
+
+            if (!Error)
+                Error = HashMediaFile(MediaPath, MediaHash);
+
+            if (!Error)
+                Error = Movie.Begin(*Core, MediaHash);
+
+            if (!Error)
+                Error = Movie.Seek(*Core, Options.SeekFrame, Options.IsTurboSeek);
+
+            if (Error)
+            {
+                std::cerr << "Unable to play " << Options.MoviePath << ": " << Error.message() << '\n';
+                Core->Shutdown();
+                IEmulatorCore::SetCurrent(nullptr);
+                return 2;
+            }
+
+            if (!Options.HasFrameCount)
+                FrameCount = Movie.GetFrameCount();
+        }
+
+        const std::uint64_t FirstFrame = Movie.GetCurrentFrame();
+        const auto StartTime = std::chrono::steady_clock::now();
+
+        for (State.FrameIndex = FirstFrame; State.FrameIndex < FrameCount; ++State.FrameIndex)
+        {
+            // Past the end of the movie the last inputs stay set.
+            if (Movie.IsOpen())
+                Movie.ApplyFrame(*Core);
+
+            Core->DoFrame();
+
+            if (State.Ring != nullptr)
+                PublishSharedFrame();
+
+            if (Options.HashInterval != 0 && (State.FrameIndex + 1) % Options.HashInterval == 0)
+            {
+                std::uint64_t StateHash = FNV1A_64Offset;
+
+                for (const std::byte Byte : Core->SaveState())
+                    FNV1A_64Update(StateHash, static_cast<unsigned char>(Byte));
+
+                Summary.VideoHash = State.VideoHash;
+                Summary.AudioHash = State.AudioHash;
+                Summary.StateHash = StateHash;
+
+                if (PrintHashes)
+                {
+                    std::printf("frame %llu video %016llx audio %016llx state %016llx\n",
+                        static_cast<unsigned long long>(State.FrameIndex + 1),
+                        static_cast<unsigned long long>(State.VideoHash),
+                        static_cast<unsigned long long>(State.AudioHash),
+                        static_cast<unsigned long long>(StateHash));
+                }
+            }
+        }
+
+        Summary.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+        Summary.FrameCount = FrameCount > FirstFrame ? FrameCount - FirstFrame : 0;
+
+        Core->Shutdown();
+        IEmulatorCore::SetCurrent(nullptr);
+        return 0;
+    }
+
+    int RunSingle(const HeadlessOptions& Options)
+    {
+        if (!Options.FrameDumpFolder.empty())
+            std::filesystem::create_directories(Options.FrameDumpFolder);
+
+        if (!Options.AudioDumpPath.empty())
+        {
+            // Placeholder header, rewritten once the sample count is known.
+            State.AudioStream.open(Options.AudioDumpPath, std::ios::binary | std::ios::trunc);
+            WriteWavHeader(State.AudioStream, 0, 0);
+        }
+
+        JobSummary Summary;
+
+        if (const int ExitCode = RunMedia(Options.MediaPaths.front(), true, Summary); ExitCode != 0)
+            return ExitCode;
+
+        if (State.AudioStream)
+            WriteWavHeader(State.AudioStream, Summary.AudioSampleRate, State.AudioSampleCount);
+
+        std::printf("%llu frames in %.3f s (%.1f frames/s)\n", static_cast<unsigned long long>(Summary.FrameCount),
+            Summary.Seconds, Summary.Seconds > 0.0 ? static_cast<double>(Summary.FrameCount) / Summary.Seconds : 0.0);
+
+        return 0;
+    }
+
+    int RunWorker(WorkerContext& Context)
+    {
+        State.Ring = &Context.Ring();
+        std::uint32_t FailedJobs = 0;
+
+        while (const std::optional<std::uint32_t> JobIndex = Context.NextJob())
+        {
+            SharedJobResult& Result = Context.Result(*JobIndex);
+            Result.WorkerIndex = Context.WorkerIndex;
+            Result.Status.store(JobStatus::Running, std::memory_order_release);
+
+            State.JobIndex = *JobIndex;
+            JobSummary Summary;
+            const bool HasSucceeded = RunMedia(State.Options->MediaPaths[*JobIndex], false, Summary) == 0;
+
+            Result.FrameCount = Summary.FrameCount;
+            Result.Seconds = Summary.Seconds;
+            Result.AudioSampleRate = Summary.AudioSampleRate;
+            Result.VideoHash = Summary.VideoHash;
+            Result.AudioHash = Summary.AudioHash;
+            Result.StateHash = Summary.StateHash;
+            Result.Status.store(HasSucceeded ? JobStatus::Succeeded : JobStatus::Failed, std::memory_order_release);
+
+            if (!HasSucceeded)
+                ++FailedJobs;
+        }
+
+        return FailedJobs == 0 ? 0 : 1;
+    }
+
+    std::string GetJobName(const HeadlessOptions& Options, std::uint32_t JobIndex)
+    {
+        // Indexed so that the same media listed twice, or two media with the same name, do not share outputs.
+        char Prefix[16];
+        std::snprintf(Prefix, sizeof(Prefix), "%03u_", JobIndex);
+        return Prefix + std::filesystem::path(Options.MediaPaths[JobIndex]).stem().string();
+    }
+
+    int RunBatch(const HeadlessOptions& Options)
+    {
+        const std::uint32_t JobCount = static_cast<std::uint32_t>(Options.MediaPaths.size());
+        std::uint32_t WorkerCount = Options.WorkerCount != 0 ? Options.WorkerCount : std::max(std::thread::hardware_concurrency(), 1u);
+        WorkerCount = std::min(WorkerCount, JobCount);
+
+        if (!Options.FrameDumpFolder.empty())
+            std::filesystem::create_directories(Options.FrameDumpFolder);
+
+        if (!Options.AudioDumpPath.empty())
+            std::filesystem::create_directories(Options.AudioDumpPath);
+
+        const auto StartTime = std::chrono::steady_clock::now();
+
+        WorkerPool Pool;
+
+        if (!Pool.Start(WorkerCount, JobCount, &RunWorker))
+            return 3;
+
+        struct JobOutput
+        {
+            std::ofstream AudioStream;
+            std::uint64_t AudioSampleCount = 0;
+            std::filesystem::path FrameFolder;
+        };
+
+        std::unordered_map<std::uint32_t, JobOutput> Outputs;
+
+        const std::uint32_t FailedWorkers = Pool.Run([&](std::uint32_t, const SharedFrame& Frame)
+        {
+            if (Frame.JobIndex >= JobCount)
+                return;
+
+            JobOutput& Output = Outputs[Frame.JobIndex];
+
+            if (Frame.Width != 0 && Frame.Height != 0)
+            {
+                if (Output.FrameFolder.empty())
+                {
+                    Output.FrameFolder = std::filesystem::path(Options.FrameDumpFolder) / GetJobName(Options, Frame.JobIndex);
+                    std::filesystem::create_directories(Output.FrameFolder);
+                }
+
+                DumpFrame(Output.FrameFolder, Frame.FrameIndex, { Frame.Pixels, Frame.Width, 0, 0, Frame.Width, Frame.Height });
+            }
+
+            if (Frame.SampleCount != 0)
+            {
+                if (!Output.AudioStream.is_open())
+                {
+                    const std::filesystem::path AudioPath = std::filesystem::path(Options.AudioDumpPath) / (GetJobName(Options, Frame.JobIndex) + ".wav");
+                    Output.AudioStream.open(AudioPath, std::ios::binary | std::ios::trunc);
+                    WriteWavHeader(Output.AudioStream, 0, 0);
+                }
+
+                Output.AudioStream.write(reinterpret_cast<const char*>(Frame.Samples), static_cast<std::streamsize>(Frame.SampleCount * sizeof(std::int16_t)));
+                Output.AudioSampleCount += Frame.SampleCount / 2;
+            }
+        });
+
+        const double ElapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+        for (auto& [JobIndex, Output] : Outputs)
+        {
+            if (Output.AudioStream)
+                WriteWavHeader(Output.AudioStream, Pool.Result(JobIndex).AudioSampleRate, Output.AudioSampleCount);
+        }
+
+        std::uint32_t FailedJobs = 0;
+        std::uint64_t TotalFrames = 0;
+
+        for (std::uint32_t JobIndex = 0; JobIndex < JobCount; ++JobIndex)
+        {
+            const SharedJobResult& Result = Pool.Result(JobIndex);
+            const JobStatus Status = Result.Status.load(std::memory_order_acquire);
+
+            // A job still marked running belongs to a worker which crashed.
+            const char* StatusName = Status == JobStatus::Succeeded ? "ok" : Status == JobStatus::Failed ? "failed" : Status == JobStatus::Running ? "crashed" : "not run";
+
+            if (Status != JobStatus::Succeeded)
+                ++FailedJobs;
+            else
+                TotalFrames += Result.FrameCount;
+
+            std::printf("%-8s worker %3u  %7.1f frames/s  video %016llx audio %016llx state %016llx  %s\n", StatusName,
+                Result.WorkerIndex, Result.Seconds > 0.0 ? static_cast<double>(Result.FrameCount) / Result.Seconds : 0.0,
+                static_cast<unsigned long long>(Result.VideoHash), static_cast<unsigned long long>(Result.AudioHash),
+                static_cast<unsigned long long>(Result.StateHash), Options.MediaPaths[JobIndex].c_str());
+        }
+
+        std::printf("%u media, %llu frames in %.3f s on %u workers (%.1f frames/s)\n", JobCount,
+            static_cast<unsigned long long>(TotalFrames), ElapsedSeconds, WorkerCount,
+            ElapsedSeconds > 0.0 ? static_cast<double>(TotalFrames) / ElapsedSeconds : 0.0);
+
+        if (FailedWorkers != 0)
+            std::fprintf(stderr, "%u worker(s) did not exit cleanly\n", FailedWorkers);
+
+        return FailedJobs == 0 && FailedWorkers == 0 ? 0 : 4;
+    }
+}
+
+int main(int ArgumentCount, char** Arguments)
+{
+    HeadlessOptions Options;
+
+    if (!ParseOptions(ArgumentCount, Arguments, Options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    State.Options = &Options;
+
+    if (Options.IsMeasuringLatency)
+        return RunLatency(Options.Latency);
+
+    if (Options.IsGeneratingThumbnails)
+        return RunThumbnails(Options.Thumbnails);
+
+    if (!Options.Regression.ManifestPath.empty())
+        return RunRegression(Options.Regression);
+
+    if (Options.MediaPaths.size() == 1 && Options.WorkerCount == 0)
+        return RunSingle(Options);
+
+    return RunBatch(Options);
+}
@@ -0,0 +1,510 @@
+#include "Latency.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "CoreWrapper/GenesisPlusGX.h"
+#include "CoreWrapper/InputMovie.h"
+#include "CoreWrapper/RunAhead.h"
+#include "Util/FrameMailbox.h"
+#include "Util/FramePacer.h"
+#include "Util/HashUtil.h"
+
+namespace
+{
+    constexpr double NanosecondsPerSecond = 1'000'000'000.0;
+
+    constexpr std::array<std::string_view, ControllerInputCount> ControllerInputNames =
+    {
+        "Up", "Down", "Left", "Right", "A", "B", "C", "X", "Y", "Z", "Start", "Mode",
+    };
+
+    // Frames run after releasing the inputs left by the warm-up, so the injected press is a fresh edge.
+    constexpr std::uint32_t SettleFrames = 8;
+    constexpr std::uint32_t MaxResponseFrames = 120;
+
+    // Host model, assumed rather than measured. Mirrors AppFramework and EmulatorCoreManager: events are polled at the
+    // top of each host frame, the display window acquires the latest emulated frame while the UI is built, the swap
+    // presents at the next vblank. Audio is played by a 48 kHz device in 2048 sample buffers out of a four buffer queue.
+    constexpr std::uint64_t FrameAcquireDelayNs = 1'000'000;
+    constexpr double AudioDeviceRate = 48000.0;
+    constexpr double AudioDeviceBufferFrames = 2048.0;
+    constexpr double AudioQueueFrames = AudioDeviceBufferFrames * 4.0;
+    constexpr std::uint32_t MaxQueuedPresents = 2;
+
+    // Each trial presses the input at another phase of the host, emulation and audio clocks.
+    constexpr std::uint32_t TrialCount = 120;
+    constexpr std::uint64_t SimulationStartNs = 1'000'000'000;
+    constexpr std::uint64_t SimulationWarmupNs = 1'000'000'000;
+    constexpr std::uint64_t SimulationTimeoutNs = 4'000'000'000;
+
+    // A baseline tolerates a quarter host frame on the mean, frame costs differ between machines.
+    constexpr double MeanToleranceHostFrames = 0.25;
+
+    // How the core answers the input, for one run-ahead count.
+    struct CoreResponse
+    {
+        std::uint32_t ResponseFrames = 0; // Frames emulated with the input held up to the first changed picture, 0 if none.
+        std::uint64_t FrameCostNs = 0;    // Mean host time of one RunAhead::DoFrame().
+    };
+
+    struct PipelineConfig
+    {
+        PacingStrategy Pacing = PacingStrategy::WallClock;
+        std::uint32_t RunAheadFrames = 0;
+        std::uint32_t QueuedPresents = 0;
+    };
+
+    struct LatencyResult
+    {
+        PipelineConfig Config;
+        std::uint32_t ResponseFrames = 0;
+        double MinMs = 0.0;
+        double MeanMs = 0.0;
+        double MaxMs = 0.0;
+        std::uint32_t MissedTrials = 0;
+    };
+
+    // Core callbacks are plain function pointers, the runner only ever drives one core per process.
+    std::uint64_t FrameHash = 0;
+
+    void LatencyRenderCallback(const FrameBufferView& Frame)
+    {
+        std::uint64_t Hash = static_cast<std::uint64_t>(Frame.Width) << 32 | Frame.Height;
+
+        for (std::uint32_t Y = 0; Y < Frame.Height; ++Y)
+        {
+            const std::uint32_t* Row = Frame.Pixels + static_cast<std::size_t>(Frame.Y + Y) * Frame.Pitch + Frame.X;
+            Hash = BulkHash64(std::as_bytes(std::span(Row, Frame.Width)), Hash);
+        }
+
+        FrameHash = Hash;
+    }
+
+    void ReleaseInputs(IEmulatorCore& Core)
+    {
+        std::array<float, ControllerInputCount> Values {};
+
+        for (int Port = 0; Port < MaxControllerPorts; ++Port)
+            Core.SetControllerInputValues(Port, Values);
+    }
+
+    // Runs MaxResponseFrames frames from the start state with and without the input held, the first frame whose picture
+    // differs is the response.
+    CoreResponse MeasureResponse(IEmulatorCore& Core, std::span<const std::byte> StartState, const LatencyOptions& Options, std::uint32_t RunAheadFrames)
+    {
+        RunAhead Runner;
+        Runner.SetFrameCount(RunAheadFrames);
+
+        std::vector<std::uint64_t> ControlHashes;
+        ControlHashes.reserve(MaxResponseFrames);
+
+        CoreResponse Response;
+        std::uint64_t TotalNs = 0;
+        std::uint64_t TimedFrames = 0;
+
+        for (const bool IsPressed : { false, true })
+        {
+            Core.LoadState(StartState);
+            ReleaseInputs(Core);
+
+            if (IsPressed)
+                Core.SetControllerInputValue(0, static_cast<int>(Options.Input), 1.0f);
+
+            for (std::uint32_t Frame = 0; Frame < MaxResponseFrames; ++Frame)
+            {
+                FrameHash = 0;
+
+                const auto StartTime = std::chrono::steady_clock::now();
+                Runner.DoFrame(Core);
+                TotalNs += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count());
+                ++TimedFrames;
+
+                if (!IsPressed)
+                {
+                    ControlHashes.push_back(FrameHash);
+                }
+                else if (FrameHash != ControlHashes[Frame])
+                {
+                    Response.ResponseFrames = Frame + 1;
+                    break;
+                }
+            }
+        }
+
+        Response.FrameCostNs = TotalNs / std::max<std::uint64_t>(TimedFrames, 1);
+        return Response;
+    }
+
+    // Replays the emulation thread and the UI thread on a simulated timeline, driving the real FramePacer and
+    // FrameMailbox, and returns the time from the physical input to the first present on screen showing its effect.
+    std::optional<std::uint64_t> SimulateLatency(const PipelineConfig& Config, std::span<const CoreResponse> Responses, double CoreRate,
+        double HostRate, std::uint64_t HostPhaseNs, std::uint64_t InputNs)
+    {
+        // A frame emulated on the timeline, published to the mailbox once the clock reaches the end of its emulation.
+        struct EmulatedFrame
+        {
+            std::uint64_t PublishNs = 0;
+            bool ShowsInput = false;
+        };
+
+        const std::uint64_t HostPeriodNs = static_cast<std::uint64_t>(NanosecondsPerSecond / HostRate);
+        const std::uint64_t AudioBufferPeriodNs = static_cast<std::uint64_t>(AudioDeviceBufferFrames * NanosecondsPerSecond / AudioDeviceRate);
+        const double AudioFramesPerFrame = AudioDeviceRate / CoreRate;
+
+        FramePacer Pacer;
+        Pacer.SetStrategy(Config.Pacing);
+        Pacer.Reset(CoreRate, SimulationStartNs);
+
+        // Emulation thread.
+        std::uint64_t NextEmulationNs = SimulationStartNs;
+        std::uint32_t RemainingFrames = 0;
+        bool IsPresentSignaled = false;
+        std::uint32_t FramesWithInput = 0;
+        std::deque<EmulatedFrame> InFlight;
+        std::vector<bool> ShowsInput; // By VideoFrame::FrameNumber.
+        FrameMailbox Mailbox;
+
+        // Audio device.
+        double AudioQueued = AudioQueueFrames / 2.0;
+        std::uint64_t NextAudioBufferNs = SimulationStartNs + AudioBufferPeriodNs;
+
+        // UI thread.
+        std::optional<std::uint64_t> InputPolledNs;
+        bool HasNewFrame = false;
+
+        auto AdvanceAudio = [&](std::uint64_t NowNs)
+        {
+            for (; NextAudioBufferNs <= NowNs; NextAudioBufferNs += AudioBufferPeriodNs)
+                AudioQueued = std::max(AudioQueued - AudioDeviceBufferFrames, 0.0);
+        };
+
+        // Runs every emulation thread step due strictly before EndNs.
+        auto AdvanceEmulation = [&](std::uint64_t EndNs)
+        {
+            while (NextEmulationNs < EndNs)
+            {
+                const std::uint64_t NowNs = NextEmulationNs;
+                AdvanceAudio(NowNs);
+
+                if (RemainingFrames == 0)
+                {
+                    RemainingFrames = Pacer.FramesToRun(NowNs, AudioQueued / AudioQueueFrames);
+
+                    if (RemainingFrames == 0)
+                    {
+                        NextEmulationNs = NowNs + std::max<std::uint64_t>(Pacer.TimeUntilNextFrameNs(NowNs), 1);
+                        continue;
+                    }
+                }
+
+                // Same rules as EmulationThreadMain: the input is sampled right before the frame and only the last
+                // frame of a batch runs ahead.
+                const bool IsRunAheadFrame = RemainingFrames == 1;
+                const CoreResponse& Response = Responses[IsRunAheadFrame ? Config.RunAheadFrames : 0];
+
+                if (InputPolledNs && *InputPolledNs <= NowNs)
+                    ++FramesWithInput;
+
+                const std::uint64_t FrameEndNs = NowNs + std::max<std::uint64_t>(Response.FrameCostNs, 1);
+                InFlight.push_back({ FrameEndNs, Response.ResponseFrames != 0 && FramesWithInput >= Response.ResponseFrames });
+                AudioQueued = std::min(AudioQueued + AudioFramesPerFrame, AudioQueueFrames);
+
+                if (--RemainingFrames != 0)
+                    NextEmulationNs = FrameEndNs;
+                else if (std::exchange(IsPresentSignaled, false))
+                    NextEmulationNs = FrameEndNs;
+                else
+                    NextEmulationNs = FrameEndNs + Pacer.TimeUntilNextFrameNs(FrameEndNs);
+            }
+        };
+
+        for (std::uint64_t HostFrame = 0;; ++HostFrame)
+        {
+            const std::uint64_t FrameStartNs = SimulationStartNs + HostPhaseNs + HostFrame * HostPeriodNs;
+
+            if (FrameStartNs > InputNs + SimulationTimeoutNs)
+                return std::nullopt;
+
+            AdvanceEmulation(FrameStartNs);
+
+            // The swap of the previous host frame returns at this vblank and wakes the emulation thread up.
+            if (HostFrame != 0)
+            {
+                Pacer.OnHostPresent(FrameStartNs, std::exchange(HasNewFrame, false));
+
+                if (RemainingFrames != 0)
+                    IsPresentSignaled = true;
+                else
+                    NextEmulationNs = std::min(NextEmulationNs, FrameStartNs);
+            }
+
+            if (!InputPolledNs && InputNs <= FrameStartNs)
+                InputPolledNs = FrameStartNs;
+
+            const std::uint64_t AcquireNs = FrameStartNs + FrameAcquireDelayNs;
+            AdvanceEmulation(AcquireNs);
+
+            // Frames are emulated in order, the ones finished by now reach the mailbox in the same order.
+            for (; !InFlight.empty() && InFlight.front().PublishNs <= AcquireNs; InFlight.pop_front())
+            {
+                VideoFrame& Frame = Mailbox.BeginWrite();
+                Frame.Width = 1;
+                Frame.Height = 1;
+                Frame.FrameNumber = ShowsInput.size();
+                ShowsInput.push_back(InFlight.front().ShowsInput);
+                Mailbox.Publish();
+            }
+
+            // Nothing new keeps the previous frame on screen, which did not show the input yet.
+            const VideoFrame* Acquired = Mailbox.Acquire();
+            HasNewFrame = Acquired != nullptr;
+
+            // Shown at the next vblank, later still when the driver queues presents.
+            if (Acquired != nullptr && ShowsInput[Acquired->FrameNumber])
+                return FrameStartNs + (1 + Config.QueuedPresents) * HostPeriodNs - InputNs;
+        }
+    }
+
+    LatencyResult MeasureLatency(const PipelineConfig& Config, std::span<const CoreResponse> Responses, double CoreRate, double HostRate)
+    {
+        LatencyResult Result;
+        Result.Config = Config;
+        Result.ResponseFrames = Responses[Config.RunAheadFrames].ResponseFrames;
+        Result.MinMs = std::numeric_limits<double>::max();
+
+        std::uint32_t MeasuredTrials = 0;
+
+        for (std::uint32_t Trial = 0; Trial < TrialCount; ++Trial)
+        {
+            // Low discrepancy steps spread the presses over two seconds and the vblanks over one host frame, so the
+            // clocks are never compared at a single phase (they would stay locked when both run at the same rate).
+            const double InputPhase = std::fmod(Trial * 0.7548776662466927, 1.0);
+            const double HostPhase = std::fmod(Trial * 0.5698402909980532, 1.0);
+            const std::uint64_t InputNs = SimulationStartNs + SimulationWarmupNs + static_cast<std::uint64_t>(InputPhase * 2.0 * NanosecondsPerSecond);
+            const std::uint64_t HostPhaseNs = static_cast<std::uint64_t>(HostPhase * NanosecondsPerSecond / HostRate);
+            const std::optional<std::uint64_t> LatencyNs = SimulateLatency(Config, Responses, CoreRate, HostRate, HostPhaseNs, InputNs);
+
+            if (!LatencyNs)
+            {
+                ++Result.MissedTrials;
+                continue;
+            }
+
+            const double Ms = static_cast<double>(*LatencyNs) / 1'000'000.0;
+            Result.MinMs = std::min(Result.MinMs, Ms);
+            Result.MaxMs = std::max(Result.MaxMs, Ms);
+            Result.MeanMs += Ms;
+            ++MeasuredTrials;
+        }
+
+        if (MeasuredTrials == 0)
+            Result.MinMs = 0.0;
+        else
+            Result.MeanMs /= MeasuredTrials;
+
+        return Result;
+    }
+
+    bool ReadBaseline(const std::string& Path, std::vector<LatencyResult>& Baseline)
+    {
+        std::ifstream Stream { Path };
+
+        if (!Stream)
+            return false;
+
+        std::string Pacing;
+        LatencyResult Entry;
+
+        while (Stream >> Pacing >> Entry.Config.RunAheadFrames >> Entry.Config.QueuedPresents >> Entry.ResponseFrames >> Entry.MeanMs >> Entry.MaxMs)
+        {
+            Entry.Config.Pacing = PacingStrategyFromName(Pacing);
+            Baseline.push_back(Entry);
+        }
+
+        return true;
+    }
+
+    bool WriteBaseline(const std::string& Path, std::span<const LatencyResult> Results)
+    {
+        std::ofstream Stream { Path, std::ios::trunc };
+        char Line[128];
+
+        for (const LatencyResult& Result : Results)
+        {
+            std::snprintf(Line, sizeof(Line), "%s %u %u %u %.3f %.3f\n", PacingStrategyName(Result.Config.Pacing).data(), Result.Config.RunAheadFrames,
+                Result.Config.QueuedPresents, Result.ResponseFrames, Result.MeanMs, Result.MaxMs);
+            Stream << Line;
+        }
+
+        return static_cast<bool>(Stream);
+    }
+
+    const LatencyResult* FindResult(std::span<const LatencyResult> Results, const PipelineConfig& Config)
+    {
+        const auto Result = std::ranges::find_if(Results, [&Config](const LatencyResult& Entry)
+        {
+            return Entry.Config.Pacing == Config.Pacing && Entry.Config.RunAheadFrames == Config.RunAheadFrames &&
+                Entry.Config.QueuedPresents == Config.QueuedPresents;
+        });
+
+        return Result != Results.end() ? &*Result : nullptr;
+    }
+}
+
+bool ControllerInputFromName(std::string_view Name, ControllerInput& Input)
+{
+    const auto Entry = std::ranges::find(ControllerInputNames, Name);
+
+    if (Entry == ControllerInputNames.end())
+        return false;
+
+    Input = static_cast<ControllerInput>(Entry - ControllerInputNames.begin());
+    return true;
+}
+
+int RunLatency(const LatencyOptions& Options)
+{
+    const std::unique_ptr<IEmulatorCore> Core = std::make_unique<GenesisPlusGX>();
+
+    if (!Options.BiosFolder.empty())
+        Core->SetSettingValue("Bios Folder", Options.BiosFolder);
+
+    Core->SetRenderCallback(&LatencyRenderCallback);
+    IEmulatorCore::SetCurrent(Core.get());
+    Core->Initialize();
+
+    InputMoviePlayer Movie;
+    std::error_code Error = Core->InsertMediaSource(Options.MediaPath, 0);
+
+    if (!Error && !Options.MoviePath.empty())
+    {
+        std::uint64_t MediaHash = 0;
+        Error = Movie.Open(Options.MoviePath);
+
+        if (!Error)
+            Error = HashMediaFile(Options.MediaPath, MediaHash);
+
+        if (!Error)
+            Error = Movie.Begin(*Core, MediaHash);
+    }
+
+    if (Error)
+    {
+        std::cerr << "Unable to load " << Options.MediaPath << ": " << Error.message() << '\n';
+        Core->Shutdown();
+        IEmulatorCore::SetCurrent(nullptr);
+        return 2;
+    }
+
+    if (!Options.MoviePath.empty())
+    {
+        while (Movie.ApplyFrame(*Core))
+            Core->DoFrame();
+    }
+    else
+    {
+        for (std::uint64_t Frame = 0; Frame < Options.WarmupFrames; ++Frame)
+            Core->DoFrame();
+    }
+
+    ReleaseInputs(*Core);
+
+    for (std::uint32_t Frame = 0; Frame < SettleFrames; ++Frame)
+        Core->DoFrame();
+
+    const std::vector<std::byte> StartState = Core->SaveState();
+    std::array<CoreResponse, RunAhead::MaxFrameCount + 1> Responses;
+
+    for (std::uint32_t RunAheadFrames = 0; RunAheadFrames <= RunAhead::MaxFrameCount; ++RunAheadFrames)
+    {
+        Responses[RunAheadFrames] = MeasureResponse(*Core, StartState, Options, RunAheadFrames);
+
+        std::printf("Run-ahead %u: %s after %u frame(s), %.3f ms per frame\n", RunAheadFrames, ControllerInputNames[static_cast<std::size_t>(Options.Input)].data(),
+            Responses[RunAheadFrames].ResponseFrames, static_cast<double>(Responses[RunAheadFrames].FrameCostNs) / 1'000'000.0);
+    }
+
+    const double CoreRate = Core->GetRefreshUpdate();
+    Core->Shutdown();
+    IEmulatorCore::SetCurrent(nullptr);
+
+    if (Responses[0].ResponseFrames == 0)
+    {
+        std::cerr << "The picture never changed within " << MaxResponseFrames << " frames of the input\n";
+        return 3;
+    }
+
+    std::vector<LatencyResult> Results;
+
+    for (const PacingStrategy Pacing : { PacingStrategy::WallClock, PacingStrategy::AudioClock, PacingStrategy::VSync })
+    {
+        for (std::uint32_t RunAheadFrames = 0; RunAheadFrames <= RunAhead::MaxFrameCount; ++RunAheadFrames)
+        {
+            for (std::uint32_t QueuedPresents = 0; QueuedPresents <= MaxQueuedPresents; ++QueuedPresents)
+                Results.push_back(MeasureLatency({ Pacing, RunAheadFrames, QueuedPresents }, Responses, CoreRate, Options.HostRefreshRate));
+        }
+    }
+
+    std::vector<LatencyResult> Baseline;
+    const bool HasBaseline = !Options.BaselinePath.empty() && !Options.IsUpdatingBaseline && ReadBaseline(Options.BaselinePath, Baseline);
+    const double HostPeriodMs = 1000.0 / Options.HostRefreshRate;
+    std::uint32_t Regressions = 0;
+
+    // Only the core's response and frame costs are measured, the rest comes from the host model above.
+    std::printf("Modelled latency: measured core response and frame cost, simulated host timeline (real FramePacer and FrameMailbox,\n"
+        "assumed %.1f ms frame acquire delay, %.0f Hz audio device in %.0f frame buffers)\n", static_cast<double>(FrameAcquireDelayNs) / 1'000'000.0,
+        AudioDeviceRate, AudioDeviceBufferFrames);
+    std::printf("Core %.3f Hz, host %.3f Hz, %u presses per configuration\n", CoreRate, Options.HostRefreshRate, TrialCount);
+    std::printf("%-10s %-9s %-6s %-8s %8s %8s %8s %7s\n", "Pacing", "Run-ahead", "Queued", "Response", "Min ms", "Mean ms", "Max ms", "Frames");
+
+    for (const LatencyResult& Result : Results)
+    {
+        const char* Status = "";
+
+        if (Result.ResponseFrames == 0 || Result.MissedTrials != 0)
+        {
+            Status = " NO RESPONSE";
+            ++Regressions;
+        }
+        else if (const LatencyResult* Expected = HasBaseline ? FindResult(Baseline, Result.Config) : nullptr)
+        {
+            if (Result.ResponseFrames > Expected->ResponseFrames || Result.MeanMs > Expected->MeanMs + MeanToleranceHostFrames * HostPeriodMs)
+            {
+                Status = " SLOWER";
+                ++Regressions;
+            }
+        }
+        else if (HasBaseline)
+        {
+            Status = " NEW";
+        }
+
+        std::printf("%-10s %-9u %-6u %-8u %8.2f %8.2f %8.2f %7.2f%s\n", PacingStrategyName(Result.Config.Pacing).data(), Result.Config.RunAheadFrames,
+            Result.Config.QueuedPresents, Result.ResponseFrames, Result.MinMs, Result.MeanMs, Result.MaxMs, Result.MeanMs / HostPeriodMs, Status);
+    }
+
+    if (!Options.BaselinePath.empty() && (Options.IsUpdatingBaseline || !HasBaseline))
+    {
+        if (!WriteBaseline(Options.BaselinePath, Results))
+        {
+            std::cerr << "Unable to write the latency baseline " << Options.BaselinePath << '\n';
+            return 4;
+        }
+
+        std::printf("Baseline written to %s\n", Options.BaselinePath.c_str());
+    }
+
+    return Regressions == 0 ? 0 : 4;
+}
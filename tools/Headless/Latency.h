@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "CoreWrapper/IEmulatorCore.h"
+
+// Input-to-photon latency runs: presses one controller input at a known frame and measures how many emulated frames
+// pass before the picture changes, for every run-ahead count. The host side (input polling, pacing, frame mailbox,
+// presents) is then replayed on a simulated timeline for every pacing strategy, run-ahead count and number of presents
+// queued by the driver, and the latency is reported up to the first present showing the change. The timeline drives
+// the real FramePacer and FrameMailbox, but the polling, acquire and audio device timings are a model: the figures
+// are modelled latency, not a measurement of the running application.
+//
+// Baseline lines:   pacing run-ahead queued-presents response-frames mean-ms max-ms
+struct LatencyOptions
+{
+    std::string MediaPath;
+    std::string BiosFolder;
+    std::string MoviePath;            // Played to its end first, to reach a screen that reacts to the input.
+    std::uint64_t WarmupFrames = 300; // Emulated before the injection when there is no movie.
+    ControllerInput Input = ControllerInput::Start;
+    double HostRefreshRate = 60.0;
+    std::string BaselinePath;
+    bool IsUpdatingBaseline = false; // Writes the baseline instead of comparing against it.
+};
+
+[[nodiscard]] bool ControllerInputFromName(std::string_view Name, ControllerInput& Input);
+
+// Returns the process exit code, 0 when the input got a response and no configuration got slower than the baseline.
+int RunLatency(const LatencyOptions& Options);
@@ -0,0 +1,429 @@
+#include "Regression.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "CoreWrapper/GenesisPlusGX.h"
+#include "CoreWrapper/InputMovie.h"
+#include "Util/HashUtil.h"
+#include "Util/ManifestFile.h"
+#include "Util/MappedFile.h"
+#include "Util/StateFile.h"
+#include "Util/StringUtil.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    constexpr std::uint64_t GoldenMagic = 0x314E444C4F474855ull; // "UHGOLDN1"
+    constexpr std::uint64_t NoFrame = UINT64_MAX;
+
+    enum class RegressionOutcome : std::uint32_t
+    {
+        Match,
+        Mismatch,
+        NoGolden,
+        GoldenUpdated,
+        LoadFailed,
+    };
+
+    struct RegressionEntry
+    {
+        std::string MediaPath;
+        std::string MoviePath;
+        std::vector<std::uint64_t> CheckpointFrames;
+        std::uint64_t CheckpointInterval = 0;
+    };
+
+    struct Checkpoint
+    {
+        std::uint64_t Frame = 0;
+        std::uint64_t VideoHash = 0;
+        std::uint64_t AudioHash = 0;
+        std::uint64_t StateHash = 0;
+
+        bool operator==(const Checkpoint&) const = default;
+    };
+
+    // What a golden file stores: one hash per frame (picture and audio of that frame) and the checkpoints.
+    struct RegressionRun
+    {
+        std::vector<std::uint64_t> FrameHashes;
+        std::vector<Checkpoint> Checkpoints;
+    };
+
+    struct FrameHashState
+    {
+        std::uint64_t VideoHash = 0;
+        std::uint64_t FrameAudioHash = 0;
+    };
+
+    // Core callbacks are plain function pointers, each worker process drives one core at a time.
+    FrameHashState HashState;
+    const RegressionOptions* CurrentOptions = nullptr;
+    const std::vector<RegressionEntry>* CurrentEntries = nullptr;
+
+    bool ReadManifest(const std::filesystem::path& ManifestPath, std::vector<RegressionEntry>& Entries)
+    {
+        std::vector<std::string> Lines;
+
+        if (!ReadManifestLines(ManifestPath, Lines))
+            return false;
+
+        for (const std::string& Line : Lines)
+        {
+            const std::vector<std::string_view> Fields = Line | std::views::split('|') | AsStringView | ToVector;
+
+            if (Fields.size() < 2 || Fields.size() > 3)
+            {
+                std::cerr << "Invalid manifest line: " << Line << '\n';
+                return false;
+            }
+
+            RegressionEntry& Entry = Entries.emplace_back();
+            Entry.MediaPath = (ManifestPath.parent_path() / Fields[0]).string();
+            Entry.MoviePath = (ManifestPath.parent_path() / Fields[1]).string();
+
+            if (Fields.size() < 3)
+                continue;
+
+            for (const std::string_view Checkpoint : Fields[2] | std::views::split(',') | AsStringView | SkipEmpty)
+            {
+                std::uint64_t Frame = 0;
+                const bool IsInterval = Checkpoint.starts_with('*');
+
+                if (!StringToNumber(IsInterval ? Checkpoint.substr(1) : Checkpoint, Frame) || Frame == 0)
+                {
+                    std::cerr << "Invalid checkpoint \"" << Checkpoint << "\" in manifest line: " << Line << '\n';
+                    return false;
+                }
+
+                if (IsInterval)
+                    Entry.CheckpointInterval = Frame;
+                else
+                    Entry.CheckpointFrames.push_back(Frame);
+            }
+        }
+
+        return true;
+    }
+
+    std::string GetEntryName(const RegressionEntry& Entry)
+    {
+        return std::filesystem::path(Entry.MediaPath).stem().string() + '.' + std::filesystem::path(Entry.MoviePath).stem().string();
+    }
+
+    std::filesystem::path GetGoldenPath(const RegressionEntry& Entry)
+    {
+        return std::filesystem::path(CurrentOptions->GoldenFolder) / (GetEntryName(Entry) + ".golden");
+    }
+
+    bool ReadGolden(const std::filesystem::path& Path, RegressionRun& Golden)
+    {
+        MappedFile File;
+
+        if (File.Open(Path))
+            return false;
+
+        const std::span<const std::byte> Bytes = File.Data();
+        const std::size_t WordCount = Bytes.size() / sizeof(std::uint64_t);
+        std::vector<std::uint64_t> Words(WordCount);
+        std::memcpy(Words.data(), Bytes.data(), WordCount * sizeof(std::uint64_t));
+
+        if (WordCount < 3 || Words[0] != GoldenMagic || Words[1] > WordCount || Words[2] > WordCount / 4 || 3 + Words[1] + Words[2] * 4 != WordCount)
+            return false;
+
+        Golden.Checkpoints.resize(Words[2]);
+
+        for (std::size_t Index = 0; Index < Golden.Checkpoints.size(); ++Index)
+        {
+            const std::uint64_t* Fields = &Words[3 + Index * 4];
+            Golden.Checkpoints[Index] = { Fields[0], Fields[1], Fields[2], Fields[3] };
+        }
+
+        Golden.FrameHashes.assign(Words.begin() + static_cast<std::ptrdiff_t>(3 + Words[2] * 4), Words.end());
+        return true;
+    }
+
+    std::error_code WriteGolden(const std::filesystem::path& Path, const RegressionRun& Run)
+    {
+        std::vector<std::uint64_t> Words = { GoldenMagic, Run.FrameHashes.size(), Run.Checkpoints.size() };
+
+        for (const Checkpoint& Entry : Run.Checkpoints)
+            Words.insert(Words.end(), { Entry.Frame, Entry.VideoHash, Entry.AudioHash, Entry.StateHash });
+
+        Words.insert(Words.end(), Run.FrameHashes.begin(), Run.FrameHashes.end());
+        return WriteFileAtomically(Path, std::as_bytes(std::span(Words)));
+    }
+
+    // First frame (1-based, like the checkpoints) where the run and the golden hashes differ, NoFrame if none.
+    std::uint64_t FindFirstDivergentFrame(const RegressionRun& Run, const RegressionRun& Golden)
+    {
+        const std::size_t CommonFrameCount = std::min(Run.FrameHashes.size(), Golden.FrameHashes.size());
+        const auto Divergence = std::mismatch(Run.FrameHashes.begin(), Run.FrameHashes.begin() + static_cast<std::ptrdiff_t>(CommonFrameCount), Golden.FrameHashes.begin());
+        std::uint64_t FirstFrame = NoFrame;
+
+        if (Divergence.first != Run.FrameHashes.begin() + static_cast<std::ptrdiff_t>(CommonFrameCount))
+            FirstFrame = static_cast<std::uint64_t>(Divergence.first - Run.FrameHashes.begin()) + 1;
+        else if (Run.FrameHashes.size() != Golden.FrameHashes.size())
+            FirstFrame = CommonFrameCount + 1;
+
+        // Internal state can diverge before anything visible or audible does.
+        const std::size_t CommonCheckpointCount = std::min(Run.Checkpoints.size(), Golden.Checkpoints.size());
+
+        for (std::size_t Index = 0; Index < CommonCheckpointCount; ++Index)
+        {
+            if (Run.Checkpoints[Index] != Golden.Checkpoints[Index])
+            {
+                FirstFrame = std::min({ FirstFrame, Run.Checkpoints[Index].Frame, Golden.Checkpoints[Index].Frame });
+                break;
+            }
+        }
+
+        if (Run.Checkpoints.size() != Golden.Checkpoints.size() && FirstFrame == NoFrame)
+            FirstFrame = CommonCheckpointCount < Run.Checkpoints.size() ? Run.Checkpoints[CommonCheckpointCount].Frame : Golden.Checkpoints[CommonCheckpointCount].Frame;
+
+        return FirstFrame;
+    }
+
+    void RegressionRenderCallback(const FrameBufferView& Frame)
+    {
+        std::uint64_t Hash = static_cast<std::uint64_t>(Frame.Width) << 32 | Frame.Height;
+
+        for (std::uint32_t Y = 0; Y < Frame.Height; ++Y)
+        {
+            const std::uint32_t* Row = Frame.Pixels + static_cast<std::size_t>(Frame.Y + Y) * Frame.Pitch + Frame.X;
+            Hash = BulkHash64(std::as_bytes(std::span(Row, Frame.Width)), Hash);
+        }
+
+        HashState.VideoHash = Hash;
+    }
+
+    void RegressionAudioCallback(std::uint32_t, std::span<std::int16_t> Samples)
+    {
+        HashState.FrameAudioHash = BulkHash64(std::as_bytes(Samples), HashState.FrameAudioHash);
+    }
+
+    bool ReplayEntry(const RegressionEntry& Entry, RegressionRun& Run, double& Seconds)
+    {
+        const std::unique_ptr<IEmulatorCore> Core = std::make_unique<GenesisPlusGX>();
+
+        if (!CurrentOptions->BiosFolder.empty())
+            Core->SetSettingValue("Bios Folder", CurrentOptions->BiosFolder);
+
+        Core->SetRenderCallback(&RegressionRenderCallback);
+        Core->SetAudioCallback(&RegressionAudioCallback);
+        IEmulatorCore::SetCurrent(Core.get());
+        Core->Initialize();
+
+        InputMoviePlayer Movie;
+        std::uint64_t MediaHash = 0;
+        std::error_code Error = Core->InsertMediaSource(Entry.MediaPath, 0);
+
+        if (!Error)
+            Error = Movie.Open(Entry.MoviePath);
+
+        if (!Error)
+            Error = HashMediaFile(Entry.MediaPath, MediaHash);
+
+        if (!Error)
+            Error = Movie.Begin(*Core, MediaHash);
+
+        if (Error)
+        {
+            std::cerr << "Unable to replay " << Entry.MoviePath << " on " << Entry.MediaPath << ": " << Error.message() << '\n';
+            Core->Shutdown();
+            IEmulatorCore::SetCurrent(nullptr);
+            return false;
+        }
+
+        const std::uint64_t FrameCount = Movie.GetFrameCount();
+        std::vector<std::uint64_t> CheckpointFrames = Entry.CheckpointFrames;
+        CheckpointFrames.push_back(FrameCount);
+        std::ranges::sort(CheckpointFrames);
+
+        Run.FrameHashes.reserve(FrameCount);
+        std::vector<std::byte> StateBuffer(Core->GetStateSize());
+        std::uint64_t AudioHash = 0;
+        auto NextCheckpoint = CheckpointFrames.begin();
+
+        const auto StartTime = std::chrono::steady_clock::now();
+
+        for (std::uint64_t Frame = 1; Movie.ApplyFrame(*Core); ++Frame)
+        {
+            HashState = {};
+            Core->DoFrame();
+
+            AudioHash = SplitMix64(AudioHash ^ HashState.FrameAudioHash);
+            Run.FrameHashes.push_back(SplitMix64(HashState.VideoHash ^ SplitMix64(HashState.FrameAudioHash)));
+
+            while (NextCheckpoint != CheckpointFrames.end() && *NextCheckpoint < Frame)
+                ++NextCheckpoint;
+
+            const bool IsCheckpoint = (NextCheckpoint != CheckpointFrames.end() && *NextCheckpoint == Frame) ||
+                (Entry.CheckpointInterval != 0 && Frame % Entry.CheckpointInterval == 0);
+
+            if (IsCheckpoint)
+            {
+                const std::size_t StateSize = Core->SaveState(std::span<std::byte>(StateBuffer));
+                const std::uint64_t StateHash = BulkHash64(std::span<const std::byte>(StateBuffer).first(StateSize));
+                Run.Checkpoints.push_back({ Frame, HashState.VideoHash, AudioHash, StateHash });
+            }
+        }
+
+        Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+        Core->Shutdown();
+        IEmulatorCore::SetCurrent(nullptr);
+        return true;
+    }
+
+    int RunRegressionWorker(WorkerContext& Context)
+    {
+        while (const std::optional<std::uint32_t> JobIndex = Context.NextJob())
+        {
+            const RegressionEntry& Entry = (*CurrentEntries)[*JobIndex];
+            SharedJobResult& Result = Context.Result(*JobIndex);
+            Result.WorkerIndex = Context.WorkerIndex;
+            Result.DetailFrame = NoFrame;
+            Result.Status.store(JobStatus::Running, std::memory_order_release);
+
+            RegressionRun Run;
+            double Seconds = 0.0;
+
+            if (!ReplayEntry(Entry, Run, Seconds))
+            {
+                Result.Detail = static_cast<std::uint32_t>(RegressionOutcome::LoadFailed);
+                Result.Status.store(JobStatus::Failed, std::memory_order_release);
+                continue;
+            }
+
+            Result.FrameCount = Run.FrameHashes.size();
+            Result.Seconds = Seconds;
+
+            if (!Run.Checkpoints.empty())
+            {
+                Result.VideoHash = Run.Checkpoints.back().VideoHash;
+                Result.AudioHash = Run.Checkpoints.back().AudioHash;
+                Result.StateHash = Run.Checkpoints.back().StateHash;
+            }
+
+            const std::filesystem::path GoldenPath = GetGoldenPath(Entry);
+            RegressionRun Golden;
+            RegressionOutcome Outcome = RegressionOutcome::NoGolden;
+
+            if (ReadGolden(GoldenPath, Golden))
+            {
+                Result.DetailFrame = FindFirstDivergentFrame(Run, Golden);
+                Outcome = Result.DetailFrame == NoFrame ? RegressionOutcome::Match : RegressionOutcome::Mismatch;
+            }
+
+            if (Outcome != RegressionOutcome::Match && CurrentOptions->IsUpdatingGolden)
+            {
+                if (const std::error_code Error = WriteGolden(GoldenPath, Run))
+                    std::cerr << "Unable to write " << GoldenPath.string() << ": " << Error.message() << '\n';
+                else
+                    Outcome = RegressionOutcome::GoldenUpdated;
+            }
+
+            Result.Detail = static_cast<std::uint32_t>(Outcome);
+            const bool HasSucceeded = Outcome == RegressionOutcome::Match || Outcome == RegressionOutcome::GoldenUpdated;
+            Result.Status.store(HasSucceeded ? JobStatus::Succeeded : JobStatus::Failed, std::memory_order_release);
+        }
+
+        return 0;
+    }
+}
+
+int RunRegression(const RegressionOptions& Options)
+{
+    std::vector<RegressionEntry> Entries;
+
+    if (!ReadManifest(Options.ManifestPath, Entries))
+    {
+        std::cerr << "Unable to read the regression manifest " << Options.ManifestPath << '\n';
+        return 1;
+    }
+
+    if (Entries.empty())
+        return 0;
+
+    RegressionOptions ResolvedOptions = Options;
+
+    if (ResolvedOptions.GoldenFolder.empty())
+        ResolvedOptions.GoldenFolder = (std::filesystem::path(Options.ManifestPath).parent_path() / "Golden").string();
+
+    std::filesystem::create_directories(ResolvedOptions.GoldenFolder);
+
+    // Inherited by the worker processes.
+    CurrentOptions = &ResolvedOptions;
+    CurrentEntries = &Entries;
+
+    const std::uint32_t JobCount = static_cast<std::uint32_t>(Entries.size());
+    std::uint32_t WorkerCount = Options.WorkerCount != 0 ? Options.WorkerCount : std::max(std::thread::hardware_concurrency(), 1u);
+    WorkerCount = std::min(WorkerCount, JobCount);
+
+    const auto StartTime = std::chrono::steady_clock::now();
+
+    WorkerPool Pool;
+
+    if (!Pool.Start(WorkerCount, JobCount, &RunRegressionWorker))
+        return 3;
+
+    const std::uint32_t FailedWorkers = Pool.Run([](std::uint32_t, const SharedFrame&) {});
+    const double ElapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+    std::uint32_t FailedJobs = 0;
+    std::uint64_t TotalFrames = 0;
+
+    for (std::uint32_t JobIndex = 0; JobIndex < JobCount; ++JobIndex)
+    {
+        const SharedJobResult& Result = Pool.Result(JobIndex);
+        const JobStatus Status = Result.Status.load(std::memory_order_acquire);
+        const auto Outcome = static_cast<RegressionOutcome>(Result.Detail);
+        const std::string Name = GetEntryName(Entries[JobIndex]);
+
+        TotalFrames += Result.FrameCount;
+
+        if (Status != JobStatus::Succeeded)
+            ++FailedJobs;
+
+        if (Status == JobStatus::Pending || Status == JobStatus::Running)
+        {
+            std::printf("%-8s %s\n", Status == JobStatus::Running ? "CRASHED" : "NOT RUN", Name.c_str());
+        }
+        else if (Outcome == RegressionOutcome::Mismatch)
+        {
+            std::printf("%-8s %s, first divergent frame %llu (replay: %s --movie %s --seek %llu)\n", "FAILED", Name.c_str(),
+                static_cast<unsigned long long>(Result.DetailFrame), Entries[JobIndex].MediaPath.c_str(),
+                Entries[JobIndex].MoviePath.c_str(), static_cast<unsigned long long>(Result.DetailFrame - 1));
+        }
+        else
+        {
+            const char* OutcomeName = Outcome == RegressionOutcome::Match ? "ok" : Outcome == RegressionOutcome::GoldenUpdated ? "UPDATED" :
+                Outcome == RegressionOutcome::NoGolden ? "NEW" : "ERROR";
+
+            std::printf("%-8s %s, %llu frames, %.1f frames/s\n", OutcomeName, Name.c_str(), static_cast<unsigned long long>(Result.FrameCount),
+                Result.Seconds > 0.0 ? static_cast<double>(Result.FrameCount) / Result.Seconds : 0.0);
+        }
+    }
+
+    std::printf("%u entries, %u failed, %llu frames in %.3f s on %u workers (%.1f frames/s)\n", JobCount, FailedJobs,
+        static_cast<unsigned long long>(TotalFrames), ElapsedSeconds, WorkerCount,
+        ElapsedSeconds > 0.0 ? static_cast<double>(TotalFrames) / ElapsedSeconds : 0.0);
+
+    if (FailedWorkers != 0)
+        std::fprintf(stderr, "%u worker(s) did not exit cleanly\n", FailedWorkers);
+
+    return FailedJobs == 0 && FailedWorkers == 0 ? 0 : 4;
+}
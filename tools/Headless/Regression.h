@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Golden-hash regression runs: replays the movies of a manifest in the worker pool and compares the hashes of every
+// frame, and of the state at chosen frames, against a golden database (one file per manifest entry).
+//
+// Manifest lines, paths relative to the manifest:   media|movie[|checkpoints]
+// Checkpoints are frame numbers separated by commas, "*N" adds one every N frames. The last frame of the movie is
+// always a checkpoint.
+struct RegressionOptions
+{
+    std::string ManifestPath;
+    std::string GoldenFolder; // Defaults to "Golden" next to the manifest.
+    std::string BiosFolder;
+    std::uint32_t WorkerCount = 0;
+    bool IsUpdatingGolden = false; // Writes the golden files that are missing or differ instead of failing.
+};
+
+// Returns the process exit code, 0 when every entry matched its golden hashes.
+int RunRegression(const RegressionOptions& Options);
@@ -0,0 +1,258 @@
+#include "Thumbnails.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "CoreWrapper/GenesisPlusGX.h"
+#include "Library/RomLibrary.h"
+#include "Library/ThumbnailAtlas.h"
+#include "Util/HashUtil.h"
+#include "WorkerPool.h"
+
+namespace
+{
+    // A frame of a single colour is a fade or a blank screen between two logos: the capture goes on for a few more
+    // seconds looking for a picture, and keeps the last frame when there is none.
+    constexpr std::uint64_t MaxCaptureDelayFrames = 180;
+
+    static_assert(ThumbnailPixelCount * sizeof(std::uint16_t) <= sizeof(SharedFrame::Pixels), "A thumbnail must fit in a shared frame");
+
+    struct CaptureState
+    {
+        std::array<std::uint16_t, ThumbnailPixelCount> Pixels = {};
+        bool HasFrame = false;
+        bool IsUniform = true;
+    };
+
+    // Core callbacks are plain function pointers, each worker process drives one core at a time.
+    CaptureState Capture;
+    const ThumbnailOptions* CurrentOptions = nullptr;
+    const std::vector<RomEntry>* CurrentJobs = nullptr;
+
+    struct Sha1Hasher
+    {
+        std::size_t operator()(const Sha1Digest& Digest) const { return BulkHash64(std::as_bytes(std::span(Digest))); }
+    };
+
+    using Sha1Set = std::unordered_set<Sha1Digest, Sha1Hasher>;
+
+    void ThumbnailRenderCallback(const FrameBufferView& Frame)
+    {
+        DownscaleToThumbnail(Frame, Capture.Pixels);
+        Capture.HasFrame = true;
+        Capture.IsUniform = std::ranges::all_of(Capture.Pixels, [](std::uint16_t Pixel) { return Pixel == Capture.Pixels[0]; });
+    }
+
+    bool CaptureThumbnail(const RomEntry& Entry, std::uint64_t& FrameCount)
+    {
+        const std::unique_ptr<IEmulatorCore> Core = std::make_unique<GenesisPlusGX>();
+
+        if (!CurrentOptions->BiosFolder.empty())
+            Core->SetSettingValue("Bios Folder", CurrentOptions->BiosFolder);
+
+        Core->SetRenderCallback(&ThumbnailRenderCallback);
+        IEmulatorCore::SetCurrent(Core.get());
+        Core->Initialize();
+
+        if (const std::error_code Error = Core->InsertMediaSource(Entry.Path, 0))
+        {
+            std::cerr << "Unable to load " << Entry.Path << ": " << Error.message() << '\n';
+            Core->Shutdown();
+            IEmulatorCore::SetCurrent(nullptr);
+            return false;
+        }
+
+        Capture = {};
+
+        // Only the captured frames are rendered, the picture of the boot is never looked at. The core may be less
+        // accurate without rendering, which does not matter for a thumbnail.
+        Core->SetRenderingSkipped(true);
+
+        for (FrameCount = 1; FrameCount < CurrentOptions->FrameCount; ++FrameCount)
+            Core->DoFrame();
+
+        Core->SetRenderingSkipped(false);
+
+        for (std::uint64_t Delay = 0; Delay <= MaxCaptureDelayFrames && (!Capture.HasFrame || Capture.IsUniform); ++Delay, ++FrameCount)
+            Core->DoFrame();
+
+        Core->Shutdown();
+        IEmulatorCore::SetCurrent(nullptr);
+        return Capture.HasFrame;
+    }
+
+    int RunThumbnailWorker(WorkerContext& Context)
+    {
+        while (const std::optional<std::uint32_t> JobIndex = Context.NextJob())
+        {
+            SharedJobResult& Result = Context.Result(*JobIndex);
+            Result.WorkerIndex = Context.WorkerIndex;
+            Result.Status.store(JobStatus::Running, std::memory_order_release);
+
+            const auto StartTime = std::chrono::steady_clock::now();
+            std::uint64_t FrameCount = 0;
+
+            if (!CaptureThumbnail((*CurrentJobs)[*JobIndex], FrameCount))
+            {
+                Result.Status.store(JobStatus::Failed, std::memory_order_release);
+                continue;
+            }
+
+            Result.FrameCount = FrameCount;
+            Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+            Result.Detail = Capture.IsUniform ? 1 : 0;
+
+            // Downscaled here, in parallel, the supervisor only appends the pixels to the atlas.
+            SharedFrame* Frame = nullptr;
+
+            while ((Frame = Context.Ring().TryBeginWrite()) == nullptr)
+                std::this_thread::yield();
+
+            Frame->JobIndex = *JobIndex;
+            Frame->FrameIndex = FrameCount;
+            Frame->Width = ThumbnailWidth;
+            Frame->Height = ThumbnailHeight;
+            Frame->SampleCount = 0;
+            std::memcpy(Frame->Pixels, Capture.Pixels.data(), sizeof(Capture.Pixels));
+            Context.Ring().EndWrite();
+
+            Result.Status.store(JobStatus::Succeeded, std::memory_order_release);
+        }
+
+        return 0;
+    }
+}
+
+int RunThumbnails(const ThumbnailOptions& Options)
+{
+    ThumbnailOptions ResolvedOptions = Options;
+
+    if (ResolvedOptions.LibraryIndexPath.empty())
+        ResolvedOptions.LibraryIndexPath = RomLibrary::DefaultIndexPath().string();
+
+    if (ResolvedOptions.AtlasPath.empty())
+        ResolvedOptions.AtlasPath = ThumbnailAtlas::DefaultPath().string();
+
+    RomLibrary Library(ResolvedOptions.LibraryIndexPath);
+
+    if (const std::error_code Error = Library.LoadIndex())
+    {
+        std::cerr << "Unable to read the library index " << ResolvedOptions.LibraryIndexPath << ": " << Error.message() << '\n';
+        return 1;
+    }
+
+    const std::shared_ptr<const std::vector<RomEntry>> Entries = Library.GetEntries();
+
+    // A missing or outdated atlas only means every thumbnail is generated again.
+    ThumbnailAtlas PreviousAtlas;
+    PreviousAtlas.Open(ResolvedOptions.AtlasPath);
+
+    // One job per distinct ROM not in the atlas yet, thumbnails of ROMs no longer in the library are dropped.
+    std::vector<RomEntry> Jobs;
+    std::vector<const RomEntry*> KeptEntries;
+    Sha1Set Seen;
+
+    for (const RomEntry& Entry : *Entries)
+    {
+        if (!Seen.insert(Entry.Sha1).second)
+            continue;
+
+        if (PreviousAtlas.Find(Entry.Sha1) != nullptr)
+            KeptEntries.push_back(&Entry);
+        else
+            Jobs.push_back(Entry);
+    }
+
+    if (Jobs.empty() && KeptEntries.size() == PreviousAtlas.GetKeys().size())
+    {
+        std::printf("%zu thumbnails, up to date\n", KeptEntries.size());
+        return 0;
+    }
+
+    // The previous atlas stays mapped while its replacement is written next to it.
+    ThumbnailAtlasWriter Writer;
+
+    if (const std::error_code Error = Writer.Begin(ResolvedOptions.AtlasPath))
+    {
+        std::cerr << "Unable to write " << ResolvedOptions.AtlasPath << ": " << Error.message() << '\n';
+        return 1;
+    }
+
+    for (const RomEntry* Entry : KeptEntries)
+        Writer.Add(Entry->Sha1, ThumbnailPixels(PreviousAtlas.Find(Entry->Sha1), ThumbnailPixelCount));
+
+    std::uint32_t FailedJobs = 0;
+    std::uint32_t UniformJobs = 0;
+    std::uint32_t FailedWorkers = 0;
+    std::uint64_t TotalFrames = 0;
+    std::uint32_t WorkerCount = 0;
+
+    const auto StartTime = std::chrono::steady_clock::now();
+
+    if (!Jobs.empty())
+    {
+        // Inherited by the worker processes.
+        CurrentOptions = &ResolvedOptions;
+        CurrentJobs = &Jobs;
+
+        const std::uint32_t JobCount = static_cast<std::uint32_t>(Jobs.size());
+        WorkerCount = Options.WorkerCount != 0 ? Options.WorkerCount : std::max(std::thread::hardware_concurrency(), 1u);
+        WorkerCount = std::min(WorkerCount, JobCount);
+
+        WorkerPool Pool;
+
+        if (!Pool.Start(WorkerCount, JobCount, &RunThumbnailWorker))
+            return 3;
+
+        FailedWorkers = Pool.Run([&Writer, &Jobs](std::uint32_t, const SharedFrame& Frame)
+        {
+            std::array<std::uint16_t, ThumbnailPixelCount> Pixels;
+            std::memcpy(Pixels.data(), Frame.Pixels, sizeof(Pixels));
+            Writer.Add(Jobs[Frame.JobIndex].Sha1, Pixels);
+        });
+
+        for (std::uint32_t JobIndex = 0; JobIndex < JobCount; ++JobIndex)
+        {
+            const SharedJobResult& Result = Pool.Result(JobIndex);
+
+            TotalFrames += Result.FrameCount;
+
+            if (Result.Status.load(std::memory_order_acquire) != JobStatus::Succeeded)
+            {
+                ++FailedJobs;
+                std::printf("%-8s %s\n", "FAILED", Jobs[JobIndex].Path.c_str());
+            }
+            else if (Result.Detail != 0)
+            {
+                ++UniformJobs;
+            }
+        }
+    }
+
+    const double ElapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+
+    if (const std::error_code Error = Writer.Finish())
+    {
+        std::cerr << "Unable to write " << ResolvedOptions.AtlasPath << ": " << Error.message() << '\n';
+        return 1;
+    }
+
+    std::printf("%zu thumbnails generated (%u blank), %u failed, %zu kept, %llu frames in %.3f s on %u workers (%.1f thumbnails/s)\n",
+        Jobs.size() - FailedJobs, UniformJobs, FailedJobs, KeptEntries.size(), static_cast<unsigned long long>(TotalFrames), ElapsedSeconds, WorkerCount,
+        ElapsedSeconds > 0.0 ? static_cast<double>(Jobs.size() - FailedJobs) / ElapsedSeconds : 0.0);
+
+    if (FailedWorkers != 0)
+        std::fprintf(stderr, "%u worker(s) did not exit cleanly\n", FailedWorkers);
+
+    return FailedJobs == 0 && FailedWorkers == 0 ? 0 : ThumbnailGeneratorPartialExitCode;
+}
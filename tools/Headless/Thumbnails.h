@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Thumbnail generation for the ROM library: boots every indexed ROM in the worker pool, captures a downscaled frame
+// once it is past its boot logos and writes them all into one thumbnail atlas (see Library/ThumbnailAtlas.h).
+// Thumbnails already in the atlas are kept, so a run after a rescan only boots the new ROMs.
+struct ThumbnailOptions
+{
+    std::string LibraryIndexPath; // Default: the library window's index.
+    std::string AtlasPath;        // Default: ThumbnailAtlas::DefaultPath().
+    std::string BiosFolder;
+    std::uint64_t FrameCount = 600; // Frames emulated before the capture.
+    std::uint32_t WorkerCount = 0;
+};
+
+// Returns the process exit code: 0 when every thumbnail was generated, ThumbnailGeneratorPartialExitCode when the
+// atlas was written but some ROMs failed to boot or a worker crashed, anything else when it was not written.
+int RunThumbnails(const ThumbnailOptions& Options);
@@ -0,0 +1,318 @@
+#include "WorkerPool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <csignal>
+#include <new>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::int64_t>::is_always_lock_free,
+    "Atomics shared between processes must be lock-free");
+static_assert(std::atomic<JobStatus>::is_always_lock_free);
+
+namespace
+{
+    constexpr std::size_t AlignUp(std::size_t Value, std::size_t Alignment)
+    {
+        return (Value + Alignment - 1) / Alignment * Alignment;
+    }
+}
+
+SharedFrame* SharedFrameRing::TryBeginWrite()
+{
+    const std::uint64_t Write = WriteIndex.load(std::memory_order_relaxed);
+
+    if (Write - ReadIndex.load(std::memory_order_acquire) >= SlotCount)
+        return nullptr;
+
+    return &Slots[Write % SlotCount];
+}
+
+void SharedFrameRing::EndWrite()
+{
+    WriteIndex.fetch_add(1, std::memory_order_release);
+}
+
+const SharedFrame* SharedFrameRing::TryRead() const
+{
+    const std::uint64_t Read = ReadIndex.load(std::memory_order_relaxed);
+
+    if (Read == WriteIndex.load(std::memory_order_acquire))
+        return nullptr;
+
+    return &Slots[Read % SlotCount];
+}
+
+void SharedFrameRing::EndRead()
+{
+    ReadIndex.fetch_add(1, std::memory_order_release);
+}
+
+void SharedJobDeque::Reset(std::uint32_t* Storage, std::uint32_t Count)
+{
+    Jobs = Storage;
+    Top.store(0, std::memory_order_relaxed);
+    Bottom.store(Count, std::memory_order_relaxed);
+}
+
+std::optional<std::uint32_t> SharedJobDeque::Pop()
+{
+    const std::int64_t NewBottom = Bottom.load(std::memory_order_relaxed) - 1;
+    Bottom.store(NewBottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t CurrentTop = Top.load(std::memory_order_relaxed);
+
+    if (CurrentTop > NewBottom)
+    {
+        Bottom.store(NewBottom + 1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    std::optional<std::uint32_t> Job = Jobs[NewBottom];
+
+    if (CurrentTop == NewBottom)
+    {
+        // Last job: race the thieves for it.
+        if (!Top.compare_exchange_strong(CurrentTop, CurrentTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            Job.reset();
+
+        Bottom.store(NewBottom + 1, std::memory_order_relaxed);
+    }
+
+    return Job;
+}
+
+std::optional<std::uint32_t> SharedJobDeque::Steal()
+{
+    while (true)
+    {
+        std::int64_t CurrentTop = Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t CurrentBottom = Bottom.load(std::memory_order_acquire);
+
+        if (CurrentTop >= CurrentBottom)
+            return std::nullopt;
+
+        const std::uint32_t Job = Jobs[CurrentTop];
+
+        if (Top.compare_exchange_strong(CurrentTop, CurrentTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return Job;
+    }
+}
+
+std::optional<std::uint32_t> WorkerContext::NextJob()
+{
+    if (const std::optional<std::uint32_t> Job = Pool.Deques[WorkerIndex].Pop())
+        return Job;
+
+    for (std::uint32_t Offset = 1; Offset < Pool.WorkerCount; ++Offset)
+    {
+        if (const std::optional<std::uint32_t> Job = Pool.Deques[(WorkerIndex + Offset) % Pool.WorkerCount].Steal())
+            return Job;
+    }
+
+    return std::nullopt;
+}
+
+SharedJobResult& WorkerContext::Result(std::uint32_t JobIndex)
+{
+    return Pool.JobResults[JobIndex];
+}
+
+SharedFrameRing& WorkerContext::Ring()
+{
+    return Pool.Rings[WorkerIndex];
+}
+
+WorkerPool::~WorkerPool()
+{
+    Unmap();
+}
+
+bool WorkerPool::Start(std::uint32_t NewWorkerCount, std::uint32_t NewJobCount, const WorkerFunction& Worker)
+{
+    WorkerCount = NewWorkerCount == 0 ? 1 : NewWorkerCount;
+    JobCount = NewJobCount;
+
+    const std::size_t DequesOffset = 0;
+    const std::size_t JobStorageOffset = AlignUp(DequesOffset + WorkerCount * sizeof(SharedJobDeque), 64);
+    const std::size_t ResultsOffset = AlignUp(JobStorageOffset + JobCount * sizeof(std::uint32_t), 64);
+    const std::size_t RingsOffset = AlignUp(ResultsOffset + JobCount * sizeof(SharedJobResult), 64);
+    MappingSize = RingsOffset + WorkerCount * sizeof(SharedFrameRing);
+
+    // Anonymous shared pages are zero-filled and only committed when touched, unused frame slots cost nothing.
+    Mapping = ::mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (Mapping == MAP_FAILED)
+    {
+        Mapping = nullptr;
+        std::perror("mmap");
+        return false;
+    }
+
+    std::byte* Base = static_cast<std::byte*>(Mapping);
+    Deques = new (Base + DequesOffset) SharedJobDeque[WorkerCount];
+    JobStorage = reinterpret_cast<std::uint32_t*>(Base + JobStorageOffset);
+    JobResults = new (Base + ResultsOffset) SharedJobResult[JobCount];
+    Rings = new (Base + RingsOffset) SharedFrameRing[WorkerCount];
+
+    std::vector<std::uint32_t> Jobs(JobCount);
+
+    for (std::uint32_t Job = 0; Job < JobCount; ++Job)
+        Jobs[Job] = Job;
+
+    SpreadJobs(Jobs);
+    WorkerMain = Worker;
+    return ForkWorkers();
+}
+
+void WorkerPool::SpreadJobs(std::span<const std::uint32_t> Jobs)
+{
+    // Round-robin, each worker owning a contiguous range of the storage. Popping from the bottom means a worker
+    // runs its jobs in reverse order, which does not matter for independent jobs. Only called while no worker runs.
+    std::uint32_t* Storage = JobStorage;
+
+    for (std::uint32_t Worker = 0; Worker < WorkerCount; ++Worker)
+    {
+        std::uint32_t Count = 0;
+
+        for (std::size_t Index = Worker; Index < Jobs.size(); Index += WorkerCount)
+            Storage[Count++] = Jobs[Index];
+
+        Deques[Worker].Reset(Storage, Count);
+        Storage += Count;
+    }
+}
+
+bool WorkerPool::ForkWorkers()
+{
+    // Anything still buffered would be written once more by every child.
+    std::fflush(nullptr);
+
+    for (std::uint32_t WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex)
+    {
+        const pid_t Process = ::fork();
+
+        if (Process < 0)
+        {
+            std::perror("fork");
+            KillWorkers();
+            return false;
+        }
+
+        if (Process == 0)
+        {
+            WorkerContext Context { *this, WorkerIndex };
+            const int ExitCode = WorkerMain(Context);
+            std::fflush(nullptr);
+            ::_exit(ExitCode);
+        }
+
+        WorkerProcesses.push_back(Process);
+    }
+
+    return true;
+}
+
+void WorkerPool::KillWorkers()
+{
+    for (const pid_t Process : WorkerProcesses)
+    {
+        if (Process > 0)
+        {
+            ::kill(Process, SIGKILL);
+            ::waitpid(Process, nullptr, 0);
+        }
+    }
+
+    WorkerProcesses.clear();
+}
+
+std::uint32_t WorkerPool::Run(const FrameFunction& OnFrame)
+{
+    std::uint32_t FailedWorkers = 0;
+    std::size_t RunningWorkers = WorkerProcesses.size();
+
+    auto DrainRings = [&]()
+    {
+        bool HasFrames = false;
+
+        for (std::uint32_t WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex)
+        {
+            while (const SharedFrame* Frame = Rings[WorkerIndex].TryRead())
+            {
+                OnFrame(WorkerIndex, *Frame);
+                Rings[WorkerIndex].EndRead();
+                HasFrames = true;
+            }
+        }
+
+        return HasFrames;
+    };
+
+    std::vector<std::uint32_t> PendingJobs;
+
+    while (true)
+    {
+        while (RunningWorkers != 0)
+        {
+            const bool HasFrames = DrainRings();
+
+            for (pid_t& Process : WorkerProcesses)
+            {
+                int Status = 0;
+
+                if (Process > 0 && ::waitpid(Process, &Status, WNOHANG) == Process)
+                {
+                    if (!WIFEXITED(Status) || WEXITSTATUS(Status) != 0)
+                        ++FailedWorkers;
+
+                    Process = -1;
+                    --RunningWorkers;
+                }
+            }
+
+            if (!HasFrames)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        DrainRings();
+        WorkerProcesses.clear();
+
+        // A worker steals only while it runs, the jobs of a worker which crashed after the others exited are left.
+        const std::size_t PreviousPendingCount = PendingJobs.size();
+        PendingJobs.clear();
+
+        for (std::uint32_t Job = 0; Job < JobCount; ++Job)
+        {
+            if (JobResults[Job].Status.load(std::memory_order_acquire) == JobStatus::Pending)
+                PendingJobs.push_back(Job);
+        }
+
+        // Stops when the last set of workers ran none of the jobs it was given, they would fail the same way again.
+        if (PendingJobs.empty() || (PreviousPendingCount != 0 && PendingJobs.size() == PreviousPendingCount))
+            break;
+
+        std::fprintf(stderr, "Requeuing %zu job(s) left by a crashed worker\n", PendingJobs.size());
+        SpreadJobs(PendingJobs);
+
+        if (!ForkWorkers())
+            break;
+
+        RunningWorkers = WorkerProcesses.size();
+    }
+
+    return FailedWorkers;
+}
+
+void WorkerPool::Unmap()
+{
+    if (Mapping != nullptr)
+    {
+        ::munmap(Mapping, MappingSize);
+        Mapping = nullptr;
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+// Process-based worker pool for the headless runner.
+// Genesis Plus GX keeps its whole state in C globals, so parallel emulation needs one process per core instance.
+// The supervisor maps an anonymous shared region, fills the job deques and forks the workers, which inherit the
+// mapping. Workers pick jobs from their own deque and steal from the others when it runs dry, and hand the frames
+// and audio the supervisor asked for back through a per-worker single-producer/single-consumer ring.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <sys/types.h>
+#include <vector>
+
+// Largest frame buffer of the cores (GenesisPlusGX allocates 720x576) and audio produced by one frame.
+constexpr std::size_t MaxSharedFramePixels = 720 * 576;
+constexpr std::size_t MaxSharedFrameSamples = 4096;
+
+struct SharedFrame
+{
+    std::uint32_t JobIndex = 0;
+    std::uint64_t FrameIndex = 0;
+    std::uint32_t Width = 0; // Zero when the slot only carries audio.
+    std::uint32_t Height = 0;
+    std::uint32_t SampleCount = 0; // Interleaved stereo samples.
+    std::uint32_t Pixels[MaxSharedFramePixels];
+    std::int16_t Samples[MaxSharedFrameSamples];
+};
+
+// Lives in shared memory: only trivially constructible members and lock-free atomics.
+class SharedFrameRing
+{
+public:
+    static constexpr std::uint64_t SlotCount = 4;
+
+    // Worker side, nullptr while the supervisor has not consumed the oldest slot yet.
+    [[nodiscard]] SharedFrame* TryBeginWrite();
+    void EndWrite();
+
+    // Supervisor side.
+    [[nodiscard]] const SharedFrame* TryRead() const;
+    void EndRead();
+
+private:
+    alignas(64) std::atomic<std::uint64_t> WriteIndex;
+    alignas(64) std::atomic<std::uint64_t> ReadIndex;
+    SharedFrame Slots[SlotCount];
+};
+
+// Bounded Chase-Lev deque of job indices, filled before the workers start: the owner pops from the bottom,
+// thieves steal from the top, the last job is arbitrated with a compare-exchange on Top.
+class SharedJobDeque
+{
+public:
+    void Reset(std::uint32_t* Storage, std::uint32_t Count);
+
+    [[nodiscard]] std::optional<std::uint32_t> Pop();
+    [[nodiscard]] std::optional<std::uint32_t> Steal();
+
+private:
+    alignas(64) std::atomic<std::int64_t> Top;
+    alignas(64) std::atomic<std::int64_t> Bottom;
+    std::uint32_t* Jobs;
+};
+
+enum class JobStatus : std::uint32_t
+{
+    Pending,
+    Running,
+    Succeeded,
+    Failed,
+};
+
+// Written by the worker running the job, read by the supervisor once the job is no longer running.
+struct SharedJobResult
+{
+    std::atomic<JobStatus> Status;
+    std::uint32_t WorkerIndex;
+    std::uint64_t FrameCount;
+    double Seconds;
+    std::uint32_t AudioSampleRate;
+    std::uint64_t VideoHash;
+    std::uint64_t AudioHash;
+    std::uint64_t StateHash;
+    std::uint32_t Detail; // Tool-specific outcome of the job.
+    std::uint64_t DetailFrame; // Frame the outcome refers to, if any.
+};
+
+class WorkerPool;
+
+struct WorkerContext
+{
+    WorkerPool& Pool;
+    std::uint32_t WorkerIndex;
+
+    // Next job for this worker, stolen from another worker when its own deque is empty.
+    [[nodiscard]] std::optional<std::uint32_t> NextJob();
+    [[nodiscard]] SharedJobResult& Result(std::uint32_t JobIndex);
+    [[nodiscard]] SharedFrameRing& Ring();
+};
+
+class WorkerPool
+{
+public:
+    using WorkerFunction = std::function<int(WorkerContext& Context)>;
+    using FrameFunction = std::function<void(std::uint32_t WorkerIndex, const SharedFrame& Frame)>;
+
+    WorkerPool() = default;
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Maps the shared region, spreads the jobs round-robin and forks the workers, which run Worker and exit with
+    // its return value. Returns false in the supervisor if the mapping or a fork failed, the workers already forked
+    // are killed.
+    bool Start(std::uint32_t WorkerCount, std::uint32_t JobCount, const WorkerFunction& Worker);
+
+    // Supervisor loop: hands every published frame to OnFrame until all workers exited and the rings are empty.
+    // Jobs nobody picked up, left in the deque of a worker which crashed once the others ran dry, are spread over a
+    // new set of workers, until a set leaves no job behind or runs none of them. Returns the number of workers which
+    // did not exit cleanly.
+    std::uint32_t Run(const FrameFunction& OnFrame);
+
+    [[nodiscard]] std::uint32_t GetWorkerCount() const { return WorkerCount; }
+    [[nodiscard]] std::uint32_t GetJobCount() const { return JobCount; }
+    [[nodiscard]] const SharedJobResult& Result(std::uint32_t JobIndex) const { return JobResults[JobIndex]; }
+
+private:
+    friend struct WorkerContext;
+
+    void SpreadJobs(std::span<const std::uint32_t> Jobs);
+    bool ForkWorkers();
+    void KillWorkers();
+    void Unmap();
+
+    std::uint32_t WorkerCount = 0;
+    std::uint32_t JobCount = 0;
+
+    void* Mapping = nullptr;
+    std::size_t MappingSize = 0;
+
+    SharedJobDeque* Deques = nullptr;
+    std::uint32_t* JobStorage = nullptr;
+    SharedJobResult* JobResults = nullptr;
+    SharedFrameRing* Rings = nullptr;
+
+    WorkerFunction WorkerMain;
+    std::vector<pid_t> WorkerProcesses;
+};